@@ -23,14 +23,24 @@ async function fetchWithError(url, options = {}) {
     }
 }
 
+// State version of the last status response, the server only sends changes
+let statusVersion = 0;
+
 // Update status values
 async function updateStatus() {
     try {
-        const data = await fetchWithError('/status');
+        const data = await fetchWithError(`/status?since=${statusVersion}`);
+        statusVersion = data.version;
         // Make sure these IDs exist in your HTML
-        document.getElementById('temperature').textContent = data.temperature.toFixed(1);
-        document.getElementById('humidity').textContent = data.humidity.toFixed(1);
-        document.getElementById('pressure').textContent = data.pressure.toFixed(1);
+        if (data.temperature !== undefined) {
+            document.getElementById('temperature').textContent = data.temperature.toFixed(1);
+        }
+        if (data.humidity !== undefined) {
+            document.getElementById('humidity').textContent = data.humidity.toFixed(1);
+        }
+        if (data.pressure !== undefined) {
+            document.getElementById('pressure').textContent = data.pressure.toFixed(1);
+        }
     } catch (error) {
         logError('Status update failed: ' + error);
     }
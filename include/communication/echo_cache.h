@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include "thermostat_types.h"
+
+// Values recently sent, to recognise them coming back.
+//
+// A bridge elsewhere in the building (KNX to MQTT, say) returns what we
+// send on one protocol as a command on another one. Applied again, it
+// would be sent out again and bounce between the two. The cache keeps the
+// latest value sent of the last ENTRIES datapoints with its time, on
+// whichever protocol it went out. An incoming value equal to it within the
+// window is an echo, unless the datapoint changed to another value since:
+// then it is a real command that happens to restore an older value. Values
+// compare with a tolerance that covers KNX DPT 9 rounding and the two
+// decimals of MQTT payloads.
+class EchoCache {
+public:
+    static constexpr uint8_t ENTRIES = 32;
+
+    EchoCache();
+
+    // 0 disables the cache
+    void setWindow(unsigned long ms) { window = ms; }
+    unsigned long getWindow() const { return window; }
+
+    void record(uint8_t zone, CommandType type, float value, unsigned long now);
+
+    // The datapoint's state is now value, a sent value it no longer equals
+    // cannot come back as an echo
+    void update(uint8_t zone, CommandType type, float value);
+
+    // True if the value is the latest one sent for the datapoint within the
+    // window and still its state; the suppression is counted for the
+    // protocol it came in on
+    bool isEcho(CommandSource source, uint8_t zone, CommandType type, float value, unsigned long now);
+
+    uint32_t getSuppressedCount(CommandSource source) const;
+    uint32_t getSuppressedCount() const;
+
+private:
+    static constexpr uint8_t SOURCE_COUNT = static_cast<uint8_t>(CommandSource::SOURCE_INTERNAL) + 1;
+
+    struct Entry {
+        unsigned long time;
+        float value;
+        uint8_t zone;
+        CommandType type;
+        bool used;
+        bool current;  // The value is still the datapoint's state
+    };
+
+    static bool matches(float sent, float received);
+    Entry* find(uint8_t zone, CommandType type);
+
+    Entry entries[ENTRIES];
+    uint8_t next;  // Oldest entry, replaced by the next new datapoint
+    unsigned long window;
+    uint32_t suppressed[SOURCE_COUNT];
+};
@@ -26,6 +26,14 @@ struct KnxGroupAddress {
     uint8_t sub;
 };
 
+// Group addresses of one hub zone, 0/0/0 leaves an address unused
+struct KnxZoneAddresses {
+    KnxGroupAddress temperature;  // Room temperature from a KNX sensor, received
+    KnxGroupAddress setpoint;     // Received and sent
+    KnxGroupAddress valve;        // Sent to the actuator
+    KnxGroupAddress comfort;      // Minutes until comfort, received
+};
+
 class KNXInterface : public ProtocolInterface {
 public:
     // Forward declaration of implementation class
@@ -49,6 +57,9 @@ public:
     void setValvePositionGA(const KnxGroupAddress& ga);
     void setModeGA(const KnxGroupAddress& ga);
     void setHeatingStateGA(const KnxGroupAddress& ga);
+    void setOutdoorTemperatureGA(const KnxGroupAddress& ga);  // Received, DPT 9.001
+    void setFlowTemperatureGA(const KnxGroupAddress& ga);     // Received, DPT 9.001
+    void setComfortTimeGA(const KnxGroupAddress& ga);         // Received, minutes as DPT 9
     
     bool sendTemperature(float value);
     bool sendHumidity(float value);
@@ -57,6 +68,11 @@ public:
     bool sendValvePosition(float value);
     bool sendMode(ThermostatMode mode);
     bool sendHeatingState(bool isHeating);
+
+    // Hub zones, numbered from 1
+    void setZoneGroupAddresses(uint8_t zone, const KnxZoneAddresses& addresses);
+    bool sendZoneValue(uint8_t zone, CommandType type, float value) override;
+    uint32_t getCapabilities() const override { return ProtocolInterface::getCapabilities() | PROTOCOL_CAP_ZONES; }
     
     // Core functionality
     void disconnect() override;
@@ -90,6 +106,7 @@ private:
     bool validateGroupAddress(const KnxGroupAddress& ga) const;
     void setupCallbacks();
     void cleanupCallbacks();
+    static void handleTelegram(message_t const& msg, void* arg);
     uint8_t modeToKnx(ThermostatMode mode) const;
     ThermostatMode knxToMode(uint8_t value) const;
 };
\ No newline at end of file
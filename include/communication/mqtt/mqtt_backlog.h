@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Store-and-forward settings, the "backlog" object of the MQTT section
+struct MqttBacklogConfig {
+    bool enabled;
+    uint32_t maxFileSize;  // Spill segment limit in bytes, 0 keeps the backlog in RAM
+    float replayRate;      // Publishes per second shared by replay and live values
+};
+
+// Room for about 20000 values, replayed at 20 per second
+constexpr MqttBacklogConfig DEFAULT_MQTT_BACKLOG_CONFIG = {true, 262144, 20.0f};
+
+// One value that could not be published, in the segment file as is
+struct BacklogRecord {
+    uint32_t time;  // millis() when it was sent
+    float value;
+    uint8_t zone;   // 0 for the device itself
+    uint8_t type;   // CommandType
+    uint16_t reserved;
+};
+
+// Values held back while the broker is unreachable, oldest first.
+//
+// New values go into a small RAM ring. When the ring is full it is appended
+// to a segment file in one write, and the values are read back from there
+// in chunks before the ring's, so the order is kept and flash sees few
+// large writes. The segment is deleted once it was read to the end. Once it
+// reached maxFileSize, or without a segment, the ring overwrites its oldest
+// value instead. The path is a plain stdio one: on the device LittleFS is
+// mounted at /littlefs.
+class MqttBacklog {
+public:
+    static constexpr size_t RAM_RECORDS = 64;
+    static constexpr size_t READ_RECORDS = 16;
+
+    struct Stats {
+        uint32_t stored;    // Values taken while offline
+        uint32_t spilled;   // Values written to the segment
+        uint32_t replayed;  // Values handed back by pop()
+        uint32_t dropped;   // Values lost to a full segment or a failed write
+    };
+
+    explicit MqttBacklog(const char* path);
+
+    void configure(const MqttBacklogConfig& newConfig);
+    const MqttBacklogConfig& getConfig() const { return config; }
+
+    // Deletes a segment left by an earlier boot, whose times mean nothing now
+    void begin();
+
+    void store(const BacklogRecord& record);
+
+    // Oldest value, false when the backlog is empty
+    bool peek(BacklogRecord& record);
+    void pop();
+
+    bool isEmpty() const { return ramCount == 0 && readIndex == readCount && fileRead == fileSize; }
+    // Values waiting, counting the unread part of the segment
+    size_t size() const;
+    const Stats& getStats() const { return stats; }
+
+private:
+    void spill();
+    bool fill();
+    void removeSegment();
+
+    const char* path;
+    MqttBacklogConfig config;
+    Stats stats;
+
+    // Newest values, oldest at ramHead
+    BacklogRecord ram[RAM_RECORDS];
+    size_t ramHead;
+    size_t ramCount;
+
+    // Segment in bytes, and a chunk of it read ahead
+    uint32_t fileSize;
+    uint32_t fileRead;  // Bytes read into the chunk so far
+    BacklogRecord chunk[READ_RECORDS];
+    size_t readIndex;
+    size_t readCount;
+};
@@ -8,6 +8,7 @@
 #include <WiFiClient.h>
 #include <memory>
 #include "interfaces/protocol_interface.h"
+#include "communication/mqtt/mqtt_backlog.h"
 #include "protocol_manager.h"
 #include "thermostat_state.h"
 
@@ -62,8 +63,20 @@ public:
     void setCredentials(const char* username, const char* password);
     void setClientId(const char* clientId);
     void setTopicPrefix(const char* prefix);
+    void setOutdoorTemperatureTopic(const char* topic);  // Full topic, empty disables
     bool isEnabled() const;
 
+    // Hub zones, numbered from 1. The prefix is relative to the topic prefix.
+    void setZoneTopicPrefix(uint8_t zone, const char* prefix);
+    bool sendZoneValue(uint8_t zone, CommandType type, float value) override;
+    uint32_t getCapabilities() const override { return ProtocolInterface::getCapabilities() | PROTOCOL_CAP_ZONES; }
+
+    // Values sent while the broker is unreachable are kept and published on
+    // <prefix>history/<topic> after reconnecting, see MqttBacklog
+    void setBacklogConfig(const MqttBacklogConfig& config);
+    const MqttBacklog::Stats& getBacklogStats() const;
+    size_t getBacklogSize() const;
+
     // Protocol manager registration
     void registerProtocolManager(ProtocolManager* manager);
 
@@ -74,9 +87,14 @@ private:
 
     // Message handling
     bool publish(const char* topic, const char* payload, bool retain = true);
+    bool publishValue(uint8_t zone, CommandType type, float value);
+    bool storeOffline(uint8_t zone, CommandType type, float value);
+    void publishOfflineValues();
+    void replayBacklog(unsigned long now);
     void setupSubscriptions();
     void cleanupSubscriptions();
     void handleMessage(char* topic, uint8_t* payload, unsigned int length);
+    bool handleZoneMessage(const String& topic, float value);
     static void mqttCallback(char* topic, uint8_t* payload, unsigned int length);
     String getFullTopic(const char* suffix) const;
 
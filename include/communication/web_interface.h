@@ -6,11 +6,14 @@
 #include <LittleFS.h>
 #include "thermostat_state.h"
 #include "config_manager.h"
+#include "control/pid_telemetry.h"
 
 // Forward declarations
 class SensorInterface;
 class PIDController;
 class ProtocolManager;
+class ControllerFactory;
+class PwmOutput;
 
 class WebInterface {
 public:
@@ -23,17 +26,29 @@ public:
     void end();
     void loop();
     void listFiles();
+
+    // Optional, lets /save switch control engines at runtime
+    void setControllerFactory(ControllerFactory* factory) { controllerFactory = factory; }
+
+    // Optional, streams PID samples to WebSocket clients on /telemetry
+    void setTelemetry(PidTelemetry* ring) { telemetry = ring; }
+
+    // Optional, adds the PWM switch count to /status
+    void setPwmOutput(const PwmOutput* output) { pwmOutput = output; }
     
     // Request handlers
     void handleRoot(AsyncWebServerRequest* request);
     void handleSave(AsyncWebServerRequest* request);
     void handleGetStatus(AsyncWebServerRequest* request);
+    void handleGetProfile(AsyncWebServerRequest* request);
     void handleSetpoint(AsyncWebServerRequest* request);
     void handleReboot(AsyncWebServerRequest* request);
     void handleFactoryReset(AsyncWebServerRequest* request);
     void handleNotFound(AsyncWebServerRequest* request);
     void handleMode(AsyncWebServerRequest* request);
     void handlePID(AsyncWebServerRequest* request);
+    void handleAutotune(AsyncWebServerRequest* request);
+    void handleGetAutotune(AsyncWebServerRequest* request);
     void handleGetConfig(AsyncWebServerRequest *request);
     void handleCreateConfig(AsyncWebServerRequest* request);
 
@@ -48,13 +63,33 @@ public:
     String getContentType(String filename);
     String generateHtml();
     void setupMDNS();
+    void streamTelemetry();
 
 private:
+    // Samples per WebSocket frame, and the coarsest downsampling
+    static constexpr size_t TELEMETRY_BATCH = 32;
+    static constexpr uint8_t MAX_TELEMETRY_STEP = 64;
+
+    // Frame header, followed by count PidSamples
+    struct TelemetryHeader {
+        uint8_t version;
+        uint8_t step;       // Every step-th sample is sent
+        uint16_t count;
+        uint32_t skipped;   // Samples overwritten before they could be sent
+    };
+
     AsyncWebServer server;
+    AsyncWebSocket telemetrySocket;
     ConfigManager* configManager;
     SensorInterface* sensorInterface;
     PIDController* pidController;
     ThermostatState* thermostatState;
     ProtocolManager* protocolManager;
+    ControllerFactory* controllerFactory;
+    PidTelemetry* telemetry;
+    const PwmOutput* pwmOutput;
+    uint32_t telemetryCursor;
+    uint8_t telemetryStep;
+    alignas(PidSample) uint8_t telemetryFrame[sizeof(TelemetryHeader) + TELEMETRY_BATCH * sizeof(PidSample)];
     bool otaInitialized;
 };
\ No newline at end of file
@@ -8,7 +8,17 @@
 #include <WiFi.h>
 #include <DNSServer.h>
 #include "thermostat_types.h"
+#include "protocol_types.h"
 #include "control/pid_controller.h"
+#include "control/valve_governor.h"
+#include "control/control_pipeline.h"
+#include "control/heating_curve.h"
+#include "control/pwm_output.h"
+#include "control/hysteresis_controller.h"
+#include "control/controller_factory.h"
+#include "control/cascade_controller.h"
+#include "control/optimum_start.h"
+#include "communication/mqtt/mqtt_backlog.h"
 #include "interfaces/config_interface.h"
 
 // Forward declarations
@@ -21,6 +31,19 @@ struct KNXPhysicalAddress {
     uint8_t member;
 };
 
+// One room driven by a hub, see ZoneHub
+struct ZoneConfig {
+    char name[16];
+    bool enabled;
+    float setpoint;
+    KNXPhysicalAddress temperatureGA;  // 0/0/0 when unused
+    KNXPhysicalAddress setpointGA;
+    KNXPhysicalAddress valveGA;
+    KNXPhysicalAddress comfortGA;
+    char mqttPrefix[32];               // Below the MQTT topic prefix, empty when unused
+    ControlEngine engine;
+};
+
 class ConfigManager : public ConfigInterface {
 public:
     ConfigManager();
@@ -77,6 +100,10 @@ public:
     
     void setKnxModeGA(uint8_t area, uint8_t line, uint8_t member);
     void getKnxModeGA(uint8_t& area, uint8_t& line, uint8_t& member) const;
+    const KNXPhysicalAddress& getKnxOutdoorGA() const { return knxOutdoorGA; }  // 0/0/0 when unused
+    const KNXPhysicalAddress& getKnxHeatingGA() const { return knxHeatingGA; }  // 0/0/0 when unused
+    const KNXPhysicalAddress& getKnxFlowGA() const { return knxFlowGA; }  // 0/0/0 when unused
+    const KNXPhysicalAddress& getKnxComfortGA() const { return knxComfortGA; }  // 0/0/0 when unused
     
     // MQTT settings
     bool getMqttEnabled() const override;
@@ -89,6 +116,7 @@ public:
     const char* getMQTTPassword() const { return mqttPassword; }
     const char* getMQTTClientId() const { return mqttClientId; }
     const char* getMQTTTopicPrefix() const { return mqttTopicPrefix; }
+    const char* getMQTTOutdoorTopic() const { return mqttOutdoorTopic; }
     void setMQTTServer(const char* server);
     void setMQTTPort(uint16_t port);
     void setMQTTUser(const char* user);
@@ -108,6 +136,31 @@ public:
     
     const PIDConfig& getPidConfig() const;
     void setPidConfig(const PIDConfig& config);
+    const ValveGovernorConfig& getValveConfig() const { return valveConfig; }
+    void setValveConfig(const ValveGovernorConfig& config) { valveConfig = config; }
+    const FailsafeConfig& getFailsafeConfig() const { return failsafeConfig; }
+    void setFailsafeConfig(const FailsafeConfig& config) { failsafeConfig = config; }
+    const HeatingCurve& getHeatingCurve() const { return heatingCurve; }
+    void setHeatingCurve(const HeatingCurve& curve) { heatingCurve = curve; }
+    const PwmOutputConfig& getPwmConfig() const { return pwmConfig; }
+    void setPwmConfig(const PwmOutputConfig& config) { pwmConfig = config; }
+    ControlEngine getControlEngine() const { return controlEngine; }
+    void setControlEngine(ControlEngine engine) { controlEngine = engine; }
+    const HysteresisConfig& getHysteresisConfig() const { return hysteresisConfig; }
+    void setHysteresisConfig(const HysteresisConfig& config) { hysteresisConfig = config; }
+    const CascadeConfig& getCascadeConfig() const { return cascadeConfig; }
+    void setCascadeConfig(const CascadeConfig& config) { cascadeConfig = config; }
+    const OptimumStartConfig& getOptimumStartConfig() const { return optimumStartConfig; }
+    void setOptimumStartConfig(const OptimumStartConfig& config) { optimumStartConfig = config; }
+    const OutboundConfig& getOutboundConfig() const { return outboundConfig; }
+    const MqttBacklogConfig& getMqttBacklogConfig() const { return mqttBacklogConfig; }
+    void setMqttBacklogConfig(const MqttBacklogConfig& config) { mqttBacklogConfig = config; }
+    void setOutboundConfig(const OutboundConfig& config) { outboundConfig = config; }
+
+    // Hub zones, read from the "zones" array
+    uint8_t getZoneCount() const { return zoneCount; }
+    const ZoneConfig& getZone(uint8_t index) const { return zones[index]; }
+    void setZoneEngine(uint8_t index, ControlEngine engine) { zones[index].engine = engine; }
     
     // Status
     ThermostatStatus getLastError() const override { return lastError; }
@@ -139,6 +192,10 @@ private:
     KNXPhysicalAddress knxSetpointGA;
     KNXPhysicalAddress knxValveGA;
     KNXPhysicalAddress knxModeGA;
+    KNXPhysicalAddress knxOutdoorGA;
+    KNXPhysicalAddress knxHeatingGA;
+    KNXPhysicalAddress knxFlowGA;
+    KNXPhysicalAddress knxComfortGA;
     
     // MQTT settings
     bool mqttEnabled;
@@ -148,10 +205,23 @@ private:
     char mqttPassword[32];
     char mqttClientId[32];
     char mqttTopicPrefix[32];
+    char mqttOutdoorTopic[64];
+    MqttBacklogConfig mqttBacklogConfig;
     
     // Control parameters
     float setpoint;
     PIDConfig pidConfig;
+    ValveGovernorConfig valveConfig;
+    FailsafeConfig failsafeConfig;
+    HeatingCurve heatingCurve;
+    PwmOutputConfig pwmConfig;
+    ControlEngine controlEngine;
+    HysteresisConfig hysteresisConfig;
+    CascadeConfig cascadeConfig;
+    OptimumStartConfig optimumStartConfig;
+    OutboundConfig outboundConfig;
+    ZoneConfig zones[ThermostatLimits::MAX_ZONES];
+    uint8_t zoneCount;
     
     // Status
     ThermostatStatus lastError;
@@ -160,4 +230,5 @@ private:
     void loadDefaults();
     bool saveJsonConfig();
     bool loadJsonConfig();
+    void loadZones(JsonArray array);
 };
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "control/pid_kernel.h"
+
+// Inner loop settings, gains in valve percent per K of flow error
+struct CascadeConfig {
+    bool enabled;
+    float minFlow;              // Flow setpoint at 0 % room demand, in C
+    float maxFlow;              // Flow setpoint at 100 % room demand, in C
+    float kp;
+    float ki;
+    float kd;
+    unsigned long sampleTime;   // Inner loop period in ms
+    unsigned long flowTimeout;  // A flow reading older than this is stale, in ms
+};
+
+// 20-55 C flow, PI every 10 s, stale after 10 minutes
+constexpr CascadeConfig DEFAULT_CASCADE_CONFIG = {false, 20.0f, 55.0f, 3.0f, 0.1f, 0.0f, 10000, 600000};
+
+// Flow temperature loop below the room controller.
+//
+// The room controller's output becomes a demand that maps linearly onto a
+// flow setpoint, and this loop moves the valve until the heating circuit's
+// flow temperature matches it. It runs at its own, faster rate, so supply
+// temperature changes are corrected at the valve long before the room
+// notices them. Without a fresh flow reading the demand drives the valve
+// directly, as in single-loop control, and the loop takes over again
+// bumplessly from that position.
+class CascadeController {
+public:
+    CascadeController();
+
+    void configure(const CascadeConfig& newConfig);
+    const CascadeConfig& getConfig() const { return config; }
+
+    // Outer loop output in percent
+    void setDemand(float percent);
+    float getFlowSetpoint() const;
+
+    void setFlowTemperature(float value, unsigned long now);
+    bool hasFreshFlow(unsigned long now) const;
+
+    // One inner loop step, returns the valve position
+    float update(unsigned long now);
+    float getOutput() const { return output; }
+
+private:
+    CascadeConfig config;
+    PidKernel<PidMath> kernel;
+    float demand;
+    float flowTemperature;
+    unsigned long lastFlowTime;
+    bool hasFlow;
+    bool closed;            // Inner loop in control, false while falling back
+    unsigned long lastTime;
+    float output;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "thermostat_state.h"
+#include "control/pid_controller.h"
+#include "control/controller_factory.h"
+#include "control/valve_governor.h"
+#include "control/pwm_output.h"
+#include "control/cascade_controller.h"
+#include "control/optimum_start.h"
+#include "system/delegate.h"
+
+// Output while the sensor delivers no samples
+struct FailsafeConfig {
+    unsigned long timeout;  // Time without a fresh sample in ms, 0 disables
+    float output;           // Controller output in percent until samples return
+};
+
+// Ten missed samples at the default rate, then a valve opening that keeps the room from cooling out
+constexpr FailsafeConfig DEFAULT_FAILSAFE_CONFIG = {300000, 20.0f};
+
+// Event-driven control path.
+//
+// One pass runs for every fresh sensor sample: filter, controller compute,
+// valve update. The controller is the PID unless a factory selects another
+// engine. Publishing happens through the ThermostatState change callbacks.
+// Nothing else runs the PID, so the controller always acts on the newest
+// sample instead of on a clock that drifts against the sensor's. When the
+// samples stop, checkSamples() holds the output at a safe value instead of
+// leaving the valve where the last pass put it.
+class ControlPipeline {
+public:
+    ControlPipeline(ThermostatState* state, PIDController* pid);
+
+    // Sample arrival event from the sensor layer
+    void onSample(float temperature, float humidity, float pressure);
+
+    // Called periodically by the control task, enters the failsafe once the
+    // newest sample is older than its timeout
+    void setFailsafe(const FailsafeConfig& config) { failsafe = config; }
+    const FailsafeConfig& getFailsafe() const { return failsafe; }
+    void checkSamples(unsigned long now);
+    bool isFailsafe() const { return failsafeActive; }
+
+    // First-order low-pass on temperature, 1.0 disables filtering
+    void setFilterCoefficient(float alpha);
+
+    // Optional engine selection, read on every pass
+    void setControllerFactory(ControllerFactory* factory) { controllers = factory; }
+
+    // Optional output stage between the PID and the valve position
+    void setValveGovernor(ValveGovernor* governor) { valveGovernor = governor; }
+    // Optional on/off output for two-point actuators, fed with the PID output
+    void setPwmOutput(PwmOutput* output) { pwmOutput = output; }
+
+    // Optional flow temperature loop between the controller and the output
+    // stage. The controller then only sets its demand, and onCascadeTick()
+    // moves the valve at the inner loop's rate.
+    void setCascade(CascadeController* controller) { cascade = controller; }
+    void onCascadeTick(unsigned long now);
+
+    // Optional comfort schedule. A preheat switches to the comfort setpoint
+    // and overrides the controller with full output until it is reached.
+    using SetpointCallback = Delegate<void(float)>;
+    void setOptimumStart(OptimumStart* start) { optimumStart = start; }
+    // Called when the pipeline itself changes the setpoint
+    void onSetpointChange(SetpointCallback callback) { setpointCallback = callback; }
+
+    float getFilteredTemperature() const { return filteredTemperature; }
+    unsigned long getPassCount() const { return passCount; }
+
+private:
+    void applyOutput(float output);
+    void updateOptimumStart(ControlInterface* controller);
+
+    ThermostatState* thermostatState;
+    PIDController* pidController;
+    ControllerFactory* controllers;
+    ControlInterface* activeController;
+    ValveGovernor* valveGovernor;
+    PwmOutput* pwmOutput;
+    CascadeController* cascade;
+    OptimumStart* optimumStart;
+    SetpointCallback setpointCallback;
+    FailsafeConfig failsafe;
+    bool failsafeActive;
+    unsigned long lastSampleTime;
+    float filterCoefficient;
+    float filteredTemperature;
+    bool filterPrimed;
+    unsigned long passCount;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "interfaces/control_interface.h"
+#include "thermostat_types.h"
+
+class PIDController;
+class HysteresisController;
+
+enum class ControlEngine : uint8_t {
+    PID = 0,
+    HYSTERESIS
+};
+
+const char* getControlEngineName(ControlEngine engine);
+bool parseControlEngine(const char* name, ControlEngine& engine);
+
+// Hands out the control engine selected for each zone.
+//
+// Zone 0 is the device's own loop, 1 to MAX_ZONES the rooms of the zone hub.
+// The engines are built once at startup and handed out by reference, so a
+// new selection needs no allocation. select() may run on any task; the
+// control task picks the change up on its next pass, without a reboot.
+class ControllerFactory {
+public:
+    static constexpr uint8_t MAX_ZONES = ThermostatLimits::MAX_ZONES;
+
+    ControllerFactory(PIDController* pid, HysteresisController* hysteresis);
+
+    void select(uint8_t zone, ControlEngine engine);
+    ControlEngine getEngine(uint8_t zone) const;
+
+    // Controller of the device's own loop for an engine
+    ControlInterface* create(ControlEngine engine) const;
+    ControlInterface* current() const { return create(getEngine(0)); }
+
+    PIDController* getPid() const { return pid; }
+    HysteresisController* getHysteresis() const { return hysteresis; }
+
+private:
+    PIDController* pid;
+    HysteresisController* hysteresis;
+    std::atomic<uint8_t> engines[MAX_ZONES + 1];
+};
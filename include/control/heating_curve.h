@@ -0,0 +1,18 @@
+#pragma once
+
+// Weather compensation: the valve position that holds a room at its
+// setpoint for a given outdoor temperature. Heat loss grows with the
+// difference between room and outdoor, so the curve is linear in it.
+struct HeatingCurve {
+    float slope;   // Percent per degree of setpoint above outdoor, 0 disables
+    float offset;  // Percent added at any outdoor temperature
+
+    bool isEnabled() const { return slope > 0.0f || offset != 0.0f; }
+
+    float baseOutput(float setpoint, float outdoor) const {
+        float base = slope * (setpoint - outdoor) + offset;
+        return base > 0.0f ? base : 0.0f;
+    }
+};
+
+constexpr HeatingCurve DEFAULT_HEATING_CURVE = {0.0f, 0.0f};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+// Online model of how fast a room heats up.
+//
+// The room is treated as first order: its temperature rises in proportion
+// to the heating output and falls in proportion to its difference to the
+// outdoor temperature,
+//
+//     dT/dt = gain * u - loss * (T - outdoor) + bias
+//
+// with u the output as a fraction and the rate in K per hour. The bias
+// takes up internal gains, and the whole loss term when no outdoor
+// temperature is known. Recursive least squares with a forgetting factor
+// fits the three parameters, one fixed-size update per sample, so the
+// model follows slow changes such as the season. Dead time between output
+// and room is handled by the caller delaying the output.
+class HeatupEstimator {
+public:
+    HeatupEstimator();
+
+    // Back to the prior, forgetting everything learnt
+    void reset();
+    void setForgetting(float lambda);
+
+    // One observation: rate in K/h over an interval, the mean output as a
+    // fraction, and the mean room and outdoor temperature of that interval
+    void sample(float rate, float output, float temperature, float outdoor);
+
+    float getGain() const { return theta[0]; }
+    float getLoss() const { return theta[1]; }
+    float getBias() const { return theta[2]; }
+    uint32_t getSampleCount() const { return samples; }
+
+    // Rate in K/h at the given output fraction and temperatures
+    float predictRate(float output, float temperature, float outdoor) const;
+
+    // Hours at full output from one temperature to another, negative when
+    // the model cannot reach it
+    float hoursToReach(float from, float to, float outdoor) const;
+
+    // Output fraction that holds a temperature, 0 to 1
+    float holdingOutput(float temperature, float outdoor) const;
+
+private:
+    static constexpr int N = 3;
+
+    float theta[N];  // gain, loss, bias
+    float P[N][N];   // Covariance of the estimate
+    float lambda;
+    uint32_t samples;
+};
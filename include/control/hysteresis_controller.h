@@ -0,0 +1,79 @@
+#pragma once
+
+#include "interfaces/control_interface.h"
+#include "thermostat_types.h"
+#include "thermostat_state.h"
+#include <atomic>
+
+// Two-point control settings. Each band is centred on the setpoint: heating
+// switches on at setpoint - band / 2 and off at setpoint + band / 2.
+struct HysteresisConfig {
+    float bands[THERMOSTAT_MODE_COUNT];  // Band width in K, indexed by ThermostatMode
+    float onOutput;                      // Output while heating, in percent
+};
+
+// Narrow in comfort and boost, wide when nobody is home
+constexpr HysteresisConfig DEFAULT_HYSTERESIS_CONFIG = {{0.4f, 0.4f, 0.8f, 1.0f, 0.2f, 1.0f}, 100.0f};
+
+// On/off controller for slow emitters such as underfloor heating.
+//
+// Instead of modulating, the output is fully on below the band and fully
+// off above it, so the actuator switches once per heating cycle and the
+// floor's own inertia does the smoothing. The band follows the operating
+// mode of the thermostat state; control stops only when the state is
+// disabled. There is no separate active flag: setActive(true) only
+// restarts the switching state.
+class HysteresisController : public ControlInterface {
+public:
+    HysteresisController(ThermostatState* state);
+
+    // ControlInterface methods
+    bool begin() override;
+    void loop() override;
+    void setUpdateInterval(unsigned long interval) override;
+    void setSetpoint(float value) override;
+    void setInput(float value) override;
+    float getOutput() const override;
+    void update(float newInput) override;
+    float getKp() const override { return 0.0f; }
+    float getKi() const override { return 0.0f; }
+    float getKd() const override { return 0.0f; }
+    // Active whenever the thermostat state is enabled
+    bool isActive() const override;
+    // Safe from any task, activating restarts the switching state on the next pass
+    void setActive(bool state) override;
+    ThermostatStatus getLastError() const override;
+    const char* getLastErrorMessage() const override;
+    void clearError() override;
+    void reset() override;
+    void configure(const void* config) override;
+    bool saveConfig() override;
+
+    // Configuration in use, for the control task
+    const HysteresisConfig& getConfig() const { return config; }
+    float getBand(ThermostatMode mode) const;
+    bool isHeating() const { return heating; }
+    uint32_t getSwitchCount() const { return switches; }
+
+    // The switching rule, shared with the zone hub
+    static bool step(bool heating, float setpoint, float input, float band);
+
+private:
+    void compute();
+    bool readPendingConfig(HysteresisConfig& copy) const;
+
+    HysteresisConfig config;         // In use, control task only
+    HysteresisConfig pendingConfig;  // Written under configSequence by configure()
+    std::atomic<uint32_t> configSequence;  // Odd while a write is in progress
+    std::atomic<bool> configPending;  // pendingConfig changed since it was taken over
+    float setpoint;
+    float input;
+    float output;
+    bool heating;
+    uint32_t switches;
+    unsigned long updateInterval;
+    unsigned long lastTime;
+    std::atomic<bool> resetPending;  // setActive() may run on another task
+    ThermostatStatus lastError;
+    ThermostatState* thermostatState;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include "control/heatup_estimator.h"
+
+// Learning and preheat settings
+struct OptimumStartConfig {
+    bool enabled;
+    unsigned long interval;   // Estimator sample period in ms
+    uint8_t deadTime;         // Delay between output and room response, in intervals
+    float forgetting;         // RLS forgetting factor per interval
+    unsigned long maxLead;    // Longest preheat in ms
+    float setpoint;           // Comfort setpoint of the device, hub zones use their configured one
+};
+
+// Samples every 5 minutes, remembers about a day, preheats at most 6 hours
+constexpr OptimumStartConfig DEFAULT_OPTIMUM_START_CONFIG = {false, 300000, 1, 0.995f, 21600000, 21.0f};
+
+enum class PreheatEvent : uint8_t {
+    NONE,
+    START,  // Switch to the comfort setpoint and heat at full output
+    END     // Comfort setpoint reached, back to normal control
+};
+
+// Optimum start for one room.
+//
+// Learns the room's heat-up behaviour from every control pass and, once a
+// comfort time is scheduled, starts heating at full output just early
+// enough to reach the comfort setpoint at that time. The caller applies
+// the setpoint and output; this class only decides when. Memory is fixed
+// and each pass costs the same whatever the history.
+class OptimumStart {
+public:
+    static constexpr uint8_t MAX_DEAD_TIME = 8;
+
+    // A preheat ends this close below the setpoint
+    static constexpr float END_BAND = 0.2f;
+
+    OptimumStart();
+
+    // Leaves the comfort setpoint alone, see setSetpoint()
+    void configure(const OptimumStartConfig& newConfig);
+    const OptimumStartConfig& getConfig() const { return config; }
+    void setSetpoint(float value) { setpoint = value; }
+    float getSetpoint() const { return setpoint; }
+
+    // Comfort due in the given minutes, 0 or less cancels a preheat that
+    // has not started yet
+    void schedule(float minutes, unsigned long now);
+    bool isScheduled() const { return scheduled; }
+    bool isPreheating() const { return preheating; }
+
+    // Once per control pass with the room temperature and the output that
+    // drove the room since the previous call, in percent
+    PreheatEvent update(float temperature, float output, float outdoor, unsigned long now);
+
+    // Preheat time from a temperature at full output in ms, at most maxLead
+    unsigned long predictLead(float temperature, float outdoor) const;
+    // Output in percent that holds the comfort setpoint
+    float getHoldingOutput(float outdoor) const;
+
+    const HeatupEstimator& getEstimator() const { return estimator; }
+    // Time the last preheat reached the setpoint after the comfort time in ms, negative when early
+    long getLastLateness() const { return lastLateness; }
+
+private:
+    void learn(float temperature, float outdoor, unsigned long now);
+
+    OptimumStartConfig config;
+    HeatupEstimator estimator;
+    float setpoint;
+
+    // Current estimator interval
+    bool primed;
+    unsigned long intervalStart;
+    float startTemperature;
+    float outputTime;         // Output integrated over the interval, percent times ms
+    unsigned long lastUpdate;
+
+    // Mean outputs of the last intervals, for the dead time
+    float history[MAX_DEAD_TIME + 1];
+    uint8_t historyIndex;
+    uint8_t historyCount;
+
+    bool scheduled;
+    bool preheating;
+    unsigned long deadline;
+    unsigned long startTime;
+    long lastLateness;
+};
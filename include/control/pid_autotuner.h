@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// Tuning rules applied to the ultimate gain and period
+enum class AutotuneRule : uint8_t {
+    ZIEGLER_NICHOLS = 0,  // Fast, noticeable overshoot
+    TYREUS_LUYBEN,        // Conservative, well suited to slow thermal loads
+    NO_OVERSHOOT,         // Ziegler-Nichols variant without overshoot
+    COUNT
+};
+
+enum class AutotuneState : uint8_t {
+    IDLE = 0,
+    RUNNING,
+    DONE,
+    FAILED
+};
+
+const char* getAutotuneRuleName(AutotuneRule rule);
+const char* getAutotuneStateName(AutotuneState state);
+bool parseAutotuneRule(const char* name, AutotuneRule& rule);
+
+// Gains per nominal sample, as used by PIDConfig
+struct AutotuneResult {
+    float ultimateGain;     // Ku in output units per degree
+    float ultimatePeriod;   // Tu in milliseconds
+    float kp;
+    float ki;
+    float kd;
+};
+
+// Progress of a relay test as other tasks see it
+struct AutotuneStatus {
+    AutotuneState state;
+    AutotuneRule rule;
+    uint8_t cycles;
+    AutotuneResult result;      // Valid in DONE
+    const char* failureReason;  // Valid in FAILED
+};
+
+// Åström-Hägglund relay feedback experiment.
+//
+// While running, the output switches between bias + amplitude and
+// bias - amplitude whenever the input leaves a hysteresis band around the
+// setpoint. This makes the loop oscillate at its ultimate period; the
+// oscillation amplitude gives the ultimate gain via the describing function
+// Ku = 4d / (pi * sqrt(a^2 - e^2)). The tuner is fed one sample at a time
+// and never blocks. Only the control task drives it; other tasks read a
+// copy of its progress through getStatus(), which is published under a
+// sequence lock at every change and reaches DONE once the gains are in.
+class PidAutotuner {
+public:
+    PidAutotuner();
+
+    void start(float setpoint, float bias, float amplitude, float hysteresis,
+               AutotuneRule rule, unsigned long now);
+    void cancel();
+
+    // Returns the relay output for this sample
+    float update(float input, unsigned long now);
+
+    // Converts the measured Ku/Tu into gains for the given sample time
+    bool computeGains(float sampleTime);
+
+    AutotuneState getState() const { return state; }
+    AutotuneRule getRule() const { return rule; }
+    uint8_t getCycles() const { return cycles; }
+    const AutotuneResult& getResult() const { return result; }
+    const char* getFailureReason() const { return failureReason; }
+
+    // Safe from any task
+    AutotuneStatus getStatus() const;
+
+    static constexpr uint8_t MIN_CYCLES = 3;           // Full cycles before checking convergence
+    static constexpr uint8_t MAX_CYCLES = 10;
+    static constexpr float CONVERGENCE = 0.1f;         // Allowed relative change between cycles
+    static constexpr unsigned long MAX_DURATION = 12UL * 3600UL * 1000UL;
+    static constexpr float MAX_DEVIATION = 5.0f;       // Abort if the input leaves setpoint +- this
+
+private:
+    void finishCycle(unsigned long now);
+    void fail(const char* reason);
+    void publish();
+    bool readStatus(AutotuneStatus& copy) const;
+
+    AutotuneState state;
+    AutotuneRule rule;
+    float setpoint;
+    float bias;
+    float amplitude;
+    float hysteresis;
+    bool relayHigh;
+    unsigned long startTime;
+    unsigned long cycleStart;    // Time of the last switch to high, 0 before the first
+    float cycleMax;
+    float cycleMin;
+    uint8_t cycles;
+    float lastPeriod;
+    float lastAmplitude;
+    AutotuneResult result;
+    const char* failureReason;
+    AutotuneStatus status;                 // Written by the control task under statusSequence
+    std::atomic<uint32_t> statusSequence;  // Odd while a write is in progress
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stddef.h>
+#include "control/pid_kernel.h"
+
+// A bank of up to N PID controllers stored as structure of arrays.
+//
+// Every controller follows exactly the PidKernel equations, but the state
+// of all controllers lives in one array per term, and one call to compute()
+// steps all of them over the same interval. The loop has no branches apart
+// from clamping, so it stays in cache and the float version vectorizes.
+// Output limits and the derivative filter are shared by the bank, the
+// filter coefficient is computed once per pass.
+template <typename Math, size_t N>
+class PidBank {
+public:
+    using Value = typename Math::Value;
+    static constexpr size_t CAPACITY = N;
+
+    PidBank()
+        : minOutput(Math::fromFloat(0.0f))
+        , maxOutput(Math::fromFloat(100.0f))
+        , filterTime(Math::fromFloat(0.0f)) {
+        for (size_t i = 0; i < N; i++) {
+            kp[i] = ki[i] = kd[i] = Math::fromFloat(0.0f);
+            trackingGain[i] = Math::fromFloat(1.0f);
+            reset(i, Math::fromFloat(0.0f));
+        }
+    }
+
+    // Same bumpless gain change as PidKernel::setGains
+    void setGains(size_t i, float newKp, float newKi, float newKd) {
+        Value oldTerms = Math::sub(Math::mul(kp[i], lastError[i]), Math::mul(kd[i], filteredRate[i]));
+
+        kp[i] = Math::fromFloat(newKp);
+        ki[i] = Math::fromFloat(newKi);
+        kd[i] = Math::fromFloat(newKd);
+
+        Value newTerms = Math::sub(Math::mul(kp[i], lastError[i]), Math::mul(kd[i], filteredRate[i]));
+        integral[i] = Math::add(integral[i], Math::sub(oldTerms, newTerms));
+        boundIntegral(i);
+
+        float tracking = newKp > 0.0f ? newKi / newKp : 1.0f;
+        tracking = tracking < 0.1f ? 0.1f : (tracking > 1.0f ? 1.0f : tracking);
+        trackingGain[i] = Math::fromFloat(tracking);
+    }
+
+    void setDerivativeFilter(float samples) {
+        filterTime = Math::fromFloat(samples < 0.0f ? 0.0f : samples);
+    }
+
+    void setOutputLimits(float min, float max) {
+        minOutput = Math::fromFloat(min);
+        maxOutput = Math::fromFloat(max);
+        for (size_t i = 0; i < N; i++) {
+            boundIntegral(i);
+        }
+    }
+
+    void reset(size_t i, Value input) {
+        integral[i] = Math::fromFloat(0.0f);
+        lastInput[i] = input;
+        lastError[i] = Math::fromFloat(0.0f);
+        filteredRate[i] = Math::fromFloat(0.0f);
+    }
+
+    // Same as PidKernel::offsetIntegral
+    void offsetIntegral(size_t i, Value delta) {
+        integral[i] = Math::sub(integral[i], delta);
+    }
+
+    // Steps controllers [0, count) by dt nominal samples
+    void compute(const Value* setpoint, const Value* input, Value dt, Value* output, size_t count) {
+        Value alpha = Math::div(dt, Math::add(filterTime, dt));
+
+        for (size_t i = 0; i < count; i++) {
+            Value error = Math::sub(setpoint[i], input[i]);
+
+            Value rate = Math::div(Math::sub(input[i], lastInput[i]), dt);
+            filteredRate[i] = Math::add(filteredRate[i], Math::mul(alpha, Math::sub(rate, filteredRate[i])));
+
+            Value p = Math::mul(kp[i], error);
+            Value d = Math::neg(Math::mul(kd[i], filteredRate[i]));
+            integral[i] = Math::add(integral[i], Math::mul(Math::mul(ki[i], error), dt));
+
+            Value unclamped = Math::add(Math::add(p, integral[i]), d);
+            Value result = clamp(unclamped);
+
+            Value excess = Math::sub(result, unclamped);
+            integral[i] = Math::add(integral[i], Math::mul(Math::mul(trackingGain[i], excess), dt));
+
+            lastInput[i] = input[i];
+            lastError[i] = error;
+            output[i] = result;
+        }
+    }
+
+    Value getIntegral(size_t i) const { return integral[i]; }
+
+private:
+    Value clamp(Value value) const {
+        if (value < minOutput) return minOutput;
+        if (value > maxOutput) return maxOutput;
+        return value;
+    }
+
+    // Same bound as PidKernel, the bank has no feed-forward
+    void boundIntegral(size_t i) {
+        Value terms = Math::sub(Math::mul(kp[i], lastError[i]), Math::mul(kd[i], filteredRate[i]));
+        integral[i] = Math::sub(clamp(Math::add(integral[i], terms)), terms);
+    }
+
+    Value minOutput;
+    Value maxOutput;
+    Value filterTime;
+
+    Value kp[N];
+    Value ki[N];
+    Value kd[N];
+    Value trackingGain[N];
+    Value integral[N];
+    Value lastInput[N];
+    Value lastError[N];
+    Value filteredRate[N];
+};
@@ -3,6 +3,22 @@
 #include "interfaces/control_interface.h"
 #include "thermostat_types.h"
 #include "thermostat_state.h"
+#include "control/pid_kernel.h"
+#include "control/pid_autotuner.h"
+#include "control/heating_curve.h"
+#include "control/pid_telemetry.h"
+#include "system/delegate.h"
+#include <atomic>
+
+// Derivative filter time constant in samples
+#ifndef PID_DERIVATIVE_FILTER_SAMPLES
+#define PID_DERIVATIVE_FILTER_SAMPLES 2.0f
+#endif
+
+// Relay hysteresis of the autotuner, should exceed the sensor noise
+#ifndef PID_AUTOTUNE_HYSTERESIS
+#define PID_AUTOTUNE_HYSTERESIS 0.1f
+#endif
 
 // PID configuration structure
 struct PIDConfig {
@@ -25,6 +41,7 @@ public:
     void setSetpoint(float sp) override;
     void setInput(float in) override;
     float getOutput() const override;
+    // Safe from any task, applied by the control task on its next pass
     void setActive(bool state) override;
     bool isActive() const override;
     ThermostatStatus getLastError() const override;
@@ -34,34 +51,82 @@ public:
     void reset() override;
     bool saveConfig() override;
 
-    // PID specific methods
+    // PID specific methods. Configuration changes are safe from any task
+    // and taken over by the control task on its next pass; the getters
+    // return the latest requested configuration.
     void setOutputLimits(float min, float max);
     void setDirection(bool reverse);
-    float getKp() const { return config.kp; }
-    float getKi() const { return config.ki; }
-    float getKd() const { return config.kd; }
-    float getMinOutput() const { return config.minOutput; }
-    float getMaxOutput() const { return config.maxOutput; }
-    float getSampleTime() const { return config.sampleTime; }
+    PIDConfig getConfig() const;
+    float getKp() const { return getConfig().kp; }
+    float getKi() const { return getConfig().ki; }
+    float getKd() const { return getConfig().kd; }
+    float getMinOutput() const { return getConfig().minOutput; }
+    float getMaxOutput() const { return getConfig().maxOutput; }
+    float getSampleTime() const { return getConfig().sampleTime; }
+    
+    // Compute a new output for a fresh input sample
+    void update(float newInput) override;
+
+    // Weather-compensated feed-forward: the heating curve gives a base
+    // output for the outdoor temperature and the PID corrects around it.
+    // Inactive until the first outdoor temperature arrives.
+    void setHeatingCurve(const HeatingCurve& curve) { heatingCurve = curve; }
+    const HeatingCurve& getHeatingCurve() const { return heatingCurve; }
+    void setOutdoorTemperature(float temperature);
+    float getFeedForward() const { return feedForward; }
+
+    // Restarts the integral so that control continues from this output
+    // without a jump, e.g. after a preheat at full output
+    void restartFrom(float value);
+
+    // Optional ring that receives the terms of every computation
+    void setTelemetry(PidTelemetry* ring) { telemetry = ring; }
     
-    // Update method that combines setInput and loop
-    void update(float newInput);
+    // Relay autotune, runs in place of the PID on the following samples.
+    // Requests may come from any task and are picked up by update().
+    using AutotuneCallback = Delegate<void(const PIDConfig&)>;
+    void startAutotune(AutotuneRule rule);
+    void cancelAutotune();
+    bool isAutotuning() const { return autotuner.getState() == AutotuneState::RUNNING; }
+    const PidAutotuner& getAutotuner() const { return autotuner; }
+    void onAutotuneComplete(AutotuneCallback cb) { autotuneCallback = cb; }
 
 protected:
     // Helper methods
     float computePID();
     void resetIntegral();
     float clamp(float value, float min, float max) const;
+    void applyConfig();
+    uint32_t beginConfigWrite();
+    void endConfigWrite(uint32_t sequence);
+    bool readRequestedConfig(PIDConfig& copy) const;
+    void processConfigRequest();
+    void processActiveRequest();
+    void processAutotuneRequest();
+    void finishAutotune();
 
 private:
-    PIDConfig config;
+    PIDConfig config;           // In use, control task only
+    PIDConfig requestedConfig;  // Written under configSequence by any task
+    std::atomic<uint32_t> configSequence;  // Odd while a write is in progress
     float setpoint;
     float input;
     float output;
-    float integral;
-    float lastInput;
+    PidKernel<PidMath> kernel;  // Arithmetic core, float or Q16.16 (PID_FIXED_POINT)
+    HeatingCurve heatingCurve;
+    float outdoorTemperature;
+    bool hasOutdoorTemperature;
+    float feedForward;
+    bool feedForwardActive;
+    std::atomic<bool> configPending;  // requestedConfig changed since it was taken over
+    bool hasLastSample;
+    PidAutotuner autotuner;
+    std::atomic<uint8_t> autotuneRequest;
+    AutotuneCallback autotuneCallback;
+    PidTelemetry* telemetry;
     unsigned long lastTime;
-    bool active;
+    std::atomic<bool> active;          // Written by the control task only
+    std::atomic<uint8_t> activeRequest;
     ThermostatStatus lastError;
     char lastErrorMessage[128];
     ThermostatState* thermostatState;  // Added thermostat state pointer
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <stdint.h>
+
+// Numeric policies for PidKernel. A policy defines the value type and the
+// handful of operations the kernel needs; clamping and anti-windup live in
+// the kernel, so every policy behaves the same apart from rounding.
+
+// Plain single precision float
+struct FloatMath {
+    using Value = float;
+
+    static constexpr Value fromFloat(float value) { return value; }
+    static constexpr float toFloat(Value value) { return value; }
+    static constexpr Value add(Value a, Value b) { return a + b; }
+    static constexpr Value sub(Value a, Value b) { return a - b; }
+    static constexpr Value mul(Value a, Value b) { return a * b; }
+    static constexpr Value div(Value a, Value b) { return a / b; }
+    static constexpr Value neg(Value a) { return -a; }
+};
+
+// Q16.16 fixed point with saturating arithmetic. Results are bit-identical
+// on every target, and need no FPU.
+struct Q16Math {
+    using Value = int32_t;
+
+    static constexpr int FRACTION_BITS = 16;
+    static constexpr Value ONE = 1 << FRACTION_BITS;
+
+    static constexpr Value saturate(int64_t value) {
+        return value > INT32_MAX ? INT32_MAX : (value < INT32_MIN ? INT32_MIN : static_cast<Value>(value));
+    }
+
+    static constexpr Value fromFloat(float value) {
+        return saturate(static_cast<int64_t>(value * ONE + (value >= 0.0f ? 0.5f : -0.5f)));
+    }
+    static constexpr float toFloat(Value value) { return static_cast<float>(value) / ONE; }
+    static constexpr Value add(Value a, Value b) { return saturate(static_cast<int64_t>(a) + b); }
+    static constexpr Value sub(Value a, Value b) { return saturate(static_cast<int64_t>(a) - b); }
+    static constexpr Value neg(Value a) { return saturate(-static_cast<int64_t>(a)); }
+
+    // Rounds to nearest; the bias is applied before the arithmetic shift
+    static constexpr Value mul(Value a, Value b) {
+        return saturate((static_cast<int64_t>(a) * b + (ONE >> 1)) >> FRACTION_BITS);
+    }
+
+    // Truncates toward zero; division by zero saturates. Scaled by a
+    // multiplication, a left shift of a negative value is not portable.
+    static constexpr Value div(Value a, Value b) {
+        return b == 0 ? (a >= 0 ? INT32_MAX : INT32_MIN)
+                      : saturate(static_cast<int64_t>(a) * ONE / b);
+    }
+};
+
+// Arithmetic core of the PID controller, independent of timing and state.
+//
+// Positional form with derivative on measurement. Time is passed as the
+// ratio of the actual interval to the nominal sample time, so gains keep
+// their per-sample meaning while jittered or changed intervals integrate
+// and differentiate correctly. The derivative is low-pass filtered, and the
+// integral is unwound by back-calculation: the amount the output was
+// clamped by is fed back into the integral with a tracking gain. Gain
+// changes adjust the integral so the output does not jump. An optional
+// feed-forward term is added before clamping, so the integral only
+// carries what the feed-forward misses.
+template <typename Math>
+class PidKernel {
+public:
+    using Value = typename Math::Value;
+
+    PidKernel()
+        : kp(Math::fromFloat(0.0f))
+        , ki(Math::fromFloat(0.0f))
+        , kd(Math::fromFloat(0.0f))
+        , minOutput(Math::fromFloat(0.0f))
+        , maxOutput(Math::fromFloat(100.0f))
+        , trackingGain(Math::fromFloat(1.0f))
+        , filterTime(Math::fromFloat(0.0f))
+        , integral(Math::fromFloat(0.0f))
+        , lastInput(Math::fromFloat(0.0f))
+        , lastError(Math::fromFloat(0.0f))
+        , filteredRate(Math::fromFloat(0.0f))
+        , feedForward(Math::fromFloat(0.0f))
+        , proportional(Math::fromFloat(0.0f))
+        , derivative(Math::fromFloat(0.0f)) {}
+
+    // Gains are per nominal sample. Changing them while running moves the
+    // difference of the proportional and derivative terms into the integral.
+    void setGains(float newKp, float newKi, float newKd) {
+        Value oldTerms = Math::sub(Math::mul(kp, lastError), Math::mul(kd, filteredRate));
+
+        kp = Math::fromFloat(newKp);
+        ki = Math::fromFloat(newKi);
+        kd = Math::fromFloat(newKd);
+
+        Value newTerms = Math::sub(Math::mul(kp, lastError), Math::mul(kd, filteredRate));
+        integral = Math::add(integral, Math::sub(oldTerms, newTerms));
+        boundIntegral();
+
+        // Track saturation with Tt = Ti, bounded to keep unwinding responsive
+        float tracking = newKp > 0.0f ? newKi / newKp : 1.0f;
+        tracking = tracking < 0.1f ? 0.1f : (tracking > 1.0f ? 1.0f : tracking);
+        trackingGain = Math::fromFloat(tracking);
+    }
+
+    // Derivative filter time constant in nominal samples, 0 disables it
+    void setDerivativeFilter(float samples) {
+        filterTime = Math::fromFloat(samples < 0.0f ? 0.0f : samples);
+    }
+
+    void setOutputLimits(float min, float max) {
+        minOutput = Math::fromFloat(min);
+        maxOutput = Math::fromFloat(max);
+        boundIntegral();
+    }
+
+    // Clears the integral and starts the derivative from the given input
+    void reset(Value input) {
+        integral = Math::fromFloat(0.0f);
+        lastInput = input;
+        lastError = Math::fromFloat(0.0f);
+        filteredRate = Math::fromFloat(0.0f);
+    }
+
+    // Takes delta out of the integral, so a feed-forward of delta can start
+    // without a jump in the output
+    void offsetIntegral(Value delta) {
+        integral = Math::sub(integral, delta);
+    }
+
+    // dt is the elapsed time in nominal samples and must be positive
+    Value compute(Value setpoint, Value input, Value dt, Value newFeedForward = Math::fromFloat(0.0f)) {
+        feedForward = newFeedForward;
+        Value error = Math::sub(setpoint, input);
+
+        // Rate of change of the measurement per sample, first-order filtered
+        Value rate = Math::div(Math::sub(input, lastInput), dt);
+        Value alpha = Math::div(dt, Math::add(filterTime, dt));
+        filteredRate = Math::add(filteredRate, Math::mul(alpha, Math::sub(rate, filteredRate)));
+
+        Value p = Math::mul(kp, error);
+        Value d = Math::neg(Math::mul(kd, filteredRate));  // Negative because the rate is of the input
+        integral = Math::add(integral, Math::mul(Math::mul(ki, error), dt));
+
+        Value unclamped = Math::add(Math::add(Math::add(p, integral), d), feedForward);
+        Value result = clamp(unclamped);
+
+        // Back-calculation anti-windup
+        Value excess = Math::sub(result, unclamped);
+        integral = Math::add(integral, Math::mul(Math::mul(trackingGain, excess), dt));
+
+        lastInput = input;
+        lastError = error;
+        proportional = p;
+        derivative = d;
+        return result;
+    }
+
+    // Terms of the last compute(), the integral after anti-windup
+    Value getIntegral() const { return integral; }
+    Value getProportional() const { return proportional; }
+    Value getDerivative() const { return derivative; }
+
+private:
+    Value clamp(Value value) const {
+        if (value < minOutput) return minOutput;
+        if (value > maxOutput) return maxOutput;
+        return value;
+    }
+
+    // The integral may be negative, when the feed-forward or the proportional
+    // term carry more than the output needs; only the output it makes up
+    // with the other terms of the last sample is bounded by the limits
+    void boundIntegral() {
+        Value terms = Math::add(Math::sub(Math::mul(kp, lastError), Math::mul(kd, filteredRate)), feedForward);
+        integral = Math::sub(clamp(Math::add(integral, terms)), terms);
+    }
+
+    Value kp;
+    Value ki;
+    Value kd;
+    Value minOutput;
+    Value maxOutput;
+    Value trackingGain;
+    Value filterTime;
+    Value integral;
+    Value lastInput;
+    Value lastError;
+    Value filteredRate;
+    Value feedForward;  // Of the last compute()
+    Value proportional;
+    Value derivative;
+};
+
+// Compile-time choice of the controller arithmetic
+#ifdef PID_FIXED_POINT
+using PidMath = Q16Math;
+#else
+using PidMath = FloatMath;
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include "system/telemetry_ring.h"
+
+// Samples kept for the telemetry stream, a power of two
+#ifndef PID_TELEMETRY_SAMPLES
+#define PID_TELEMETRY_SAMPLES 128
+#endif
+
+// One PID computation. Streamed as is, so the layout is part of the
+// /telemetry wire format: eight little-endian 32-bit fields.
+struct PidSample {
+    uint32_t time;          // millis() of the computation
+    float setpoint;
+    float input;
+    float proportional;
+    float integral;
+    float derivative;
+    float feedForward;
+    float output;
+};
+
+using PidTelemetry = TelemetryRing<PidSample, PID_TELEMETRY_SAMPLES>;
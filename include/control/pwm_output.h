@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// Time-proportional output settings, times in milliseconds
+struct PwmOutputConfig {
+    bool enabled;
+    unsigned long cycleTime;   // Period of the on/off pattern
+    unsigned long minOnTime;   // Shortest on pulse
+    unsigned long minOffTime;  // Shortest pause
+    float accuracy;            // Duty error per cycle accepted to save a switch, in percent
+};
+
+// 15 minute cycle, 2 minute minimum pulse and pause, 2 % accuracy
+constexpr PwmOutputConfig DEFAULT_PWM_CONFIG = {false, 900000, 120000, 120000, 2.0f};
+
+// Turns a 0-100 % controller output into on/off switching for two-point
+// actuators such as thermoelectric valve drives.
+//
+// Each cycle is on for duty * cycleTime, then off. A pulse or pause shorter
+// than the minimum on/off time or the accuracy is not switched: the cycle
+// stays fully off or on, and the on-time it missed or exceeded is carried
+// into the next cycle. Small duties thus become occasional minimum-length
+// pulses instead of many short ones, which keeps the average duty exact
+// with the fewest switching operations the limits allow.
+class PwmOutput {
+public:
+    PwmOutput();
+
+    void configure(const PwmOutputConfig& newConfig);
+    const PwmOutputConfig& getConfig() const { return config; }
+
+    // Controller output in percent, takes effect from the next cycle
+    void setDuty(float percent);
+    float getDuty() const { return duty; }
+
+    // Advances the pattern and returns whether the actuator should be on
+    bool update(unsigned long now);
+
+    void reset();
+
+    struct Stats {
+        uint32_t switches;  // On/off transitions
+        uint32_t cycles;
+        uint32_t merged;    // Cycles kept fully on or off instead of a short pulse or pause
+    };
+    // Counted by the control task, safe to read from any task
+    Stats getStats() const {
+        return {switches.load(std::memory_order_relaxed), cycles.load(std::memory_order_relaxed),
+                merged.load(std::memory_order_relaxed)};
+    }
+
+private:
+    void startCycle(unsigned long now);
+
+    PwmOutputConfig config;
+    float duty;
+    bool on;
+    bool running;
+    unsigned long cycleStart;
+    float onTime;   // On-time of the current cycle
+    float carry;    // On-time owed to (positive) or taken from (negative) later cycles
+    std::atomic<uint32_t> switches;
+    std::atomic<uint32_t> cycles;
+    std::atomic<uint32_t> merged;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+
+// Output stage settings, all limits in percent of valve travel
+struct ValveGovernorConfig {
+    float step;                     // Quantization step, 0 disables
+    float maxSlewRate;              // Maximum change per second, 0 disables
+    float minDelta;                 // Smallest change that is sent, 0 disables
+    unsigned long refreshInterval;  // Resend an unchanged position after this many ms, 0 disables
+};
+
+// 1 % steps, no rate limit, 2 % minimum move, refresh every 15 minutes
+constexpr ValveGovernorConfig DEFAULT_VALVE_CONFIG = {1.0f, 0.0f, 2.0f, 900000};
+
+enum class ValveAction : uint8_t {
+    NONE = 0,   // Nothing to send
+    MOVE,       // Send the new position
+    REFRESH     // Resend the current position
+};
+
+// Shapes the raw PID output into valve moves worth sending.
+//
+// The requested position is quantized to the step size and rate limited,
+// and only sent once it differs from the last sent position by at least
+// minDelta. Fully closed and fully open are always sent, so the valve can
+// always reach its end stops. Without a move the position is sent again
+// every refreshInterval: a held change below minDelta goes out as a move,
+// an unchanged position is resent to recover actuators that missed a
+// telegram.
+class ValveGovernor {
+public:
+    ValveGovernor();
+
+    void configure(const ValveGovernorConfig& newConfig);
+    const ValveGovernorConfig& getConfig() const { return config; }
+
+    // Feeds one requested position. On MOVE or REFRESH, position is the
+    // value to send.
+    ValveAction update(float requested, unsigned long now, float& position);
+
+    void reset();
+
+    struct Stats {
+        uint32_t moves;       // Positions sent
+        uint32_t suppressed;  // Requests that sent nothing
+        uint32_t refreshes;   // Unchanged positions resent
+    };
+    const Stats& getStats() const { return stats; }
+
+    static constexpr float MIN_POSITION = 0.0f;
+    static constexpr float MAX_POSITION = 100.0f;
+
+private:
+    float quantize(float value) const;
+
+    ValveGovernorConfig config;
+    bool hasPosition;
+    float commanded;      // Position after slew limiting, follows the request
+    float lastSent;
+    unsigned long lastUpdate;
+    unsigned long lastSendTime;
+    Stats stats;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include "thermostat_state.h"
+#include "thermostat_types.h"
+#include "control/pid_bank.h"
+#include "control/pid_controller.h"
+#include "control/valve_governor.h"
+#include "control/controller_factory.h"
+#include "control/optimum_start.h"
+#include "system/delegate.h"
+
+// Drives the rooms of a hub device besides its own.
+//
+// Each zone has its own ThermostatState and valve governor; room
+// temperatures and setpoints arrive over KNX or MQTT. All zone controllers
+// share one PidBank and are stepped together in a single pass per sample
+// time; zones the factory switches to hysteresis control keep their PID
+// idle and switch on/off instead. With optimum start each zone learns its
+// own heat-up rate and preheats to its configured setpoint. Zone numbers on the protocol side start at 1, 0 is the device's
+// own thermostat; indices into the hub start at 0.
+class ZoneHub {
+public:
+    static constexpr uint8_t MAX_ZONES = ThermostatLimits::MAX_ZONES;
+
+    // A zone closes its valve when its temperature is older than this
+    static constexpr unsigned long READING_TIMEOUT = 30UL * 60UL * 1000UL;
+
+    // Called with the zone number and the position or setpoint to send
+    using ValveCallback = Delegate<void(uint8_t, float)>;
+    using SetpointCallback = Delegate<void(uint8_t, float)>;
+
+    ZoneHub();
+
+    // Zones are added once at startup
+    bool addZone(const char* name, float setpoint, bool enabled);
+
+    // Gains, limits and sample time are shared by all zones
+    void configure(const PIDConfig& config);
+    void setValveConfig(const ValveGovernorConfig& config);
+    void onValveChange(ValveCallback callback) { valveCallback = callback; }
+    // Engine selection per zone number, bands from the factory's hysteresis controller
+    void setControllerFactory(const ControllerFactory* factory) { controllers = factory; }
+    // Comfort schedules per zone, the comfort setpoint is the one given to addZone()
+    void setOptimumStartConfig(const OptimumStartConfig& config);
+    void onSetpointChange(SetpointCallback callback) { setpointCallback = callback; }
+    void setOutdoorTemperature(float temperature);
+
+    // Inbound value for a zone number, called on the control task
+    bool handleCommand(uint8_t zone, CommandType type, float value, unsigned long now);
+
+    // One batched control pass over all zones
+    void update(unsigned long now);
+
+    uint8_t getZoneCount() const { return zoneCount; }
+    ThermostatState& getState(uint8_t index) { return states[index]; }
+    const char* getName(uint8_t index) const { return names[index]; }
+    const OptimumStart& getOptimumStart(uint8_t index) const { return starts[index]; }
+    float getSampleTime() const { return config.sampleTime; }
+
+    // Zone number for a hub index and back
+    static uint8_t zoneNumber(uint8_t index) { return index + 1; }
+    static uint8_t zoneIndex(uint8_t zone) { return zone - 1; }
+
+private:
+    bool isReady(uint8_t index, unsigned long now) const;
+    float updateHysteresis(uint8_t index);
+    void updateOptimumStart(uint8_t index, unsigned long now);
+
+    PIDConfig config;
+    uint8_t zoneCount;
+    unsigned long lastPass;
+    ValveCallback valveCallback;
+    SetpointCallback setpointCallback;
+    const ControllerFactory* controllers;
+    bool optimumStartEnabled;
+    float outdoorTemperature;
+    bool hasOutdoorTemperature;
+
+    PidBank<PidMath, MAX_ZONES> bank;
+    PidMath::Value setpoints[MAX_ZONES];
+    PidMath::Value inputs[MAX_ZONES];
+    PidMath::Value outputs[MAX_ZONES];
+
+    ThermostatState states[MAX_ZONES];
+    ValveGovernor governors[MAX_ZONES];
+    OptimumStart starts[MAX_ZONES];
+    unsigned long lastReading[MAX_ZONES];
+    uint16_t hasReading;    // Bit per zone, set once a temperature arrived
+    uint16_t primed;        // Bit per zone, set while its controller runs
+    uint16_t heating;       // Bit per zone, hysteresis output of two-point zones
+    char names[MAX_ZONES][16];
+};
@@ -17,6 +17,9 @@ public:
     virtual void setInput(float value) = 0;
     virtual float getOutput() const = 0;
 
+    // Compute a new output for a fresh input sample
+    virtual void update(float input) = 0;
+
     // PID parameters
     virtual float getKp() const = 0;
     virtual float getKi() const = 0;
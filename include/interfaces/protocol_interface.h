@@ -35,6 +35,17 @@ public:
     virtual bool sendMode(ThermostatMode mode) = 0;
     virtual bool sendHeatingState(bool isHeating) = 0;
 
+    // Hub zone values, numbered from 1; only called with PROTOCOL_CAP_ZONES
+    virtual bool sendZoneValue(uint8_t /*zone*/, CommandType /*type*/, float /*value*/) { return false; }
+
+    // What the ProtocolManager may send through this protocol, read once
+    // when the protocol is added. Defaults to the device's own values.
+    virtual uint32_t getCapabilities() const {
+        return protocolCapability(CommandType::CMD_SET_TEMPERATURE) | protocolCapability(CommandType::CMD_SETPOINT) |
+               protocolCapability(CommandType::CMD_MODE) | protocolCapability(CommandType::CMD_VALVE) |
+               protocolCapability(CommandType::CMD_HEATING);
+    }
+
     // Error handling
     virtual ThermostatStatus getLastError() const = 0;
     virtual const char* getLastErrorMessage() const = 0;
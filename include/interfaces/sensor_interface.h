@@ -2,9 +2,13 @@
 #define SENSOR_INTERFACE_H
 
 #include "thermostat_types.h"
+#include "system/delegate.h"
 
 class SensorInterface {
 public:
+    // Fired once for every fresh, valid sample
+    using SampleCallback = Delegate<void(float temperature, float humidity, float pressure)>;
+
     virtual ~SensorInterface() = default;
 
     // Initialization and update
@@ -17,6 +21,7 @@ public:
     virtual float getTemperature() const = 0;
     virtual float getHumidity() const = 0;
     virtual float getPressure() const = 0;
+    virtual void onNewSample(SampleCallback callback) = 0;
     
     // Status
     virtual bool isAvailable() const = 0;
@@ -1,16 +1,29 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include "interfaces/protocol_interface.h"
 #include "thermostat_state.h"
 #include "communication/knx/knx_interface.h"
 #include "communication/mqtt/mqtt_interface.h"
 #include "protocol_types.h"
-#include <mutex>
+#include "system/mpsc_queue.h"
+#include "system/latest_value_table.h"
+#include "system/delegate.h"
+#include "communication/echo_cache.h"
+
 // Forward declarations
 class KNXInterface;
 class MQTTInterface;
 
+// Command or state update crossing between the network and control tasks
+struct ProtocolCommand {
+    CommandSource source;
+    CommandType type;
+    float value;
+    uint8_t zone;  // Hub zone number, 0 for the device's own thermostat
+};
+
 class ProtocolManager {
 public:
     ProtocolManager(ThermostatState* state);
@@ -27,32 +40,101 @@ public:
     void registerProtocols(KNXInterface* knx, MQTTInterface* mqtt);
 
     // Protocol command handling
-    bool handleIncomingCommand(CommandSource source, CommandType cmd, float value);
+    // Safe from any task, commands are applied by processCommands()
+    bool handleIncomingCommand(CommandSource source, CommandType cmd, float value, uint8_t zone = 0);
+    // Called by protocols on the network task for every value they receive.
+    // Drops echoes of values recently sent to any protocol, see EchoCache,
+    // and passes the rest to handleIncomingCommand().
+    bool receiveCommand(CommandSource source, CommandType cmd, float value, uint8_t zone = 0);
+    const EchoCache& getEchoCache() const { return echoes; }
+    // Called from web handlers, applied without priority arbitration
+    bool queueLocalUpdate(CommandType cmd, float value);
+    // Called from the control task once per tick. Of the commands queued
+    // since the last call, only the highest priority one per datapoint is
+    // applied, the latest among equals.
+    void processCommands();
+    uint32_t getDroppedCommandCount() const { return commands.getDroppedCount(); }
+    // Receives commands for hub zones on the control task
+    void onZoneCommand(Delegate<void(const ProtocolCommand&)> handler) { zoneHandler = handler; }
+    // Receives the device's comfort time in minutes on the control task
+    void onComfortTime(Delegate<void(float)> handler) { comfortHandler = handler; }
     void propagateCommand(CommandSource source, CommandType cmd, float value);
 
+    // Called from the network task every OutboundConfig::interval, sends
+    // the newest value of each changed datapoint, at most burst per protocol
+    void configureOutbound(const OutboundConfig& config);
+    const OutboundConfig& getOutboundConfig() const { return outboundConfig; }
+    void flushOutbound();
+
+    // Outbound counters since boot
+    struct OutboundStats {
+        uint32_t updates;    // Values queued by the control task
+        uint32_t coalesced;  // Values replaced by a newer one before they were sent
+        uint32_t sent;       // Sends a protocol accepted
+        uint32_t dropped;    // Sends a protocol refused, and values without a datapoint
+        uint32_t echoes;     // Incoming values dropped as echoes of sent ones
+    };
+    OutboundStats getOutboundStats() const;
+
     // State updates
     void sendTemperature(float temperature);
     void sendSetpoint(float setpoint);
     void sendValvePosition(float position);
     void sendMode(ThermostatMode mode);
     void sendHeatingState(bool isHeating);
+    void sendZoneValvePosition(uint8_t zone, float position);
+    void sendZoneSetpoint(uint8_t zone, float setpoint);
 
 private:
+    // One latest-value slot per command type of the device and of each hub zone
+    static constexpr size_t OUTBOUND_DATAPOINTS = (ThermostatLimits::MAX_ZONES + 1) * COMMAND_TYPE_COUNT;
+    using OutboundTable = LatestValueTable<ProtocolCommand, OUTBOUND_DATAPOINTS>;
+
+    // Fan-out entry of a registered protocol, built when it is added
+    struct ProtocolRoute {
+        ProtocolInterface* protocol;
+        CommandSource source;    // Updates from this source are not echoed back to it
+        uint32_t capabilities;   // Masked to what the manager can send
+        uint32_t pending[OutboundTable::WORDS];  // Datapoints not sent to it yet
+        uint16_t cursor;         // Datapoint the next flush starts at
+    };
+
     ThermostatState* thermostatState;
     std::vector<ProtocolInterface*> protocols;
-    
-    // Protocol instances
-    KNXInterface* knxInterface;
-    MQTTInterface* mqttInterface;
+    std::vector<ProtocolRoute> routes;
     
     // Command tracking
     CommandSource lastCommandSource;
     CommandType lastCommandType;
     float lastCommandValue;
+    Delegate<void(const ProtocolCommand&)> zoneHandler;
+    Delegate<void(float)> comfortHandler;
+
+    // Network and AsyncTCP tasks -> control task
+    static const size_t QUEUE_SIZE = 32;
+    MpscQueue<ProtocolCommand, QUEUE_SIZE> commands;
+
+    // Control task -> network task, only the newest value of each datapoint
+    OutboundTable outbound;
+    std::atomic<uint32_t> queuedUpdates;
+    std::atomic<uint32_t> rejectedUpdates;
+
+    // Network task side of the outbound path
+    OutboundConfig outboundConfig;
+    ProtocolCommand outboundValues[OUTBOUND_DATAPOINTS];  // Newest collected value per datapoint
+    uint32_t coalescedSends;
+    uint32_t sentUpdates;
+    uint32_t refusedSends;
+    EchoCache echoes;
 
     // Helper methods
+    static int getPriority(CommandSource source);
     bool hasHigherPriority(CommandSource newSource, CommandSource currentSource);
-
-    // avoid race conditions
-    std::mutex commandMutex;
+    void applyQueued(const ProtocolCommand& command);
+    bool applyCommand(const ProtocolCommand& command);
+    void applyLocalUpdate(const ProtocolCommand& command);
+    void queueOutbound(CommandSource source, CommandType cmd, float value, uint8_t zone = 0);
+    void rebuildRoutes();
+    void routeUpdate(size_t datapoint, const ProtocolCommand& update);
+    bool sendUpdate(ProtocolRoute& route, const ProtocolCommand& update);
 };
\ No newline at end of file
@@ -16,6 +16,23 @@ enum class ProtocolStatus : int8_t {
     ERROR_AUTHENTICATION = -4   // Authentication failed
 };
 
+// Capability mask of a protocol: one bit per CommandType it can send,
+// plus PROTOCOL_CAP_ZONES when it also sends values of hub zones
+constexpr uint32_t protocolCapability(CommandType type) {
+    return 1u << static_cast<uint8_t>(type);
+}
+constexpr uint32_t PROTOCOL_CAP_ZONES = 1u << 31;
+
+// Pacing of outbound updates, see ProtocolManager::flushOutbound()
+struct OutboundConfig {
+    unsigned long interval;    // Flush period in ms
+    uint8_t burst;             // Sends per protocol and flush, the rest waits for the next one
+    unsigned long echoWindow;  // Incoming values equal to one sent this many ms ago are dropped, 0 disables
+};
+
+// Up to 8 updates per protocol every 50 ms, echoes recognised for 3 s
+constexpr OutboundConfig DEFAULT_OUTBOUND_CONFIG = {50, 8, 3000};
+
 // Helper functions
 inline const char* getCommandSourceName(CommandSource source) {
     switch (source) {
@@ -36,6 +53,10 @@ inline const char* getCommandTypeName(CommandType cmd) {
         case CommandType::CMD_VALVE: return "Set Valve Position";
         case CommandType::CMD_HEATING: return "Set Heating State";
         case CommandType::CMD_SET_TEMPERATURE: return "Set Temperature";
+        case CommandType::CMD_ENABLE: return "Set Enabled";
+        case CommandType::CMD_OUTDOOR_TEMPERATURE: return "Set Outdoor Temperature";
+        case CommandType::CMD_FLOW_TEMPERATURE: return "Set Flow Temperature";
+        case CommandType::CMD_COMFORT_TIME: return "Set Comfort Time";
         default: return "Unknown";
     }
 }
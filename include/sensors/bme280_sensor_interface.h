@@ -24,6 +24,7 @@ public:
     float getTemperature() const override;
     float getHumidity() const override;
     float getPressure() const override;
+    void onNewSample(SampleCallback callback) override;
     
     void setTemperatureOffset(float offset) override;
     void setHumidityOffset(float offset) override;
@@ -36,6 +37,7 @@ public:
 private:
     Adafruit_BME280 bme;
     void setSensorMode(); // Internal helper to configure the sensor mode
+    bool probe();         // Looks for the sensor at both addresses
     
     float temperature;
     float humidity;
@@ -47,7 +49,8 @@ private:
     unsigned long lastUpdateTime;
     unsigned long firstErrorTime;  // Time when sensor first reported as unavailable
     bool sensorAvailable;          // Track if sensor is properly initialized
-    bool stopErrorMessages;        // Flag to stop continuous error messages
+    bool stopErrorMessages;        // Flag to stop continuous error messages, set until a valid sample
     ThermostatStatus lastError;
     char lastErrorMessage[128];
+    SampleCallback sampleCallback;
 };
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+// Thin wrapper around pinned FreeRTOS tasks.
+//
+// On the ESP32 tasks are created with xTaskCreatePinnedToCore. On other
+// targets the same entry points run on std::thread, so code split across
+// the two cores can also be exercised on a host build.
+namespace CoreTask {
+
+using TaskFunction = void (*)(void*);
+
+// Protocol I/O shares core 0 with the WiFi stack, control runs on core 1
+constexpr int NETWORK_CORE = 0;
+constexpr int CONTROL_CORE = 1;
+
+bool start(const char* name, TaskFunction function, void* arg, int core,
+           uint32_t stackSize, unsigned priority);
+
+// Block the calling task for the given number of milliseconds
+void sleep(unsigned long ms);
+
+}  // namespace CoreTask
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <type_traits>
+
+// Non-owning, allocation-free callable reference.
+//
+// A Delegate is two words: a context pointer and a trampoline. It can refer
+// to a free function, a captureless lambda, a member function bound to an
+// object, or any other callable object. It never copies or owns the target,
+// so bound objects and callables must outlive the delegate.
+template <typename Signature>
+class Delegate;
+
+template <typename R, typename... Args>
+class Delegate<R(Args...)> {
+public:
+    using Function = R (*)(Args...);
+
+    Delegate() : invoker(nullptr) { target.object = nullptr; }
+
+    Delegate(Function function) : invoker(function ? &invokeFunction : nullptr) {
+        target.function = function;
+    }
+
+    // Captureless lambdas convert to plain functions
+    template <typename Callable,
+              typename = typename std::enable_if<std::is_convertible<Callable, Function>::value>::type>
+    Delegate(Callable callable) : Delegate(static_cast<Function>(callable)) {}
+
+    // Member function bound to an object
+    template <typename T, R (T::*Method)(Args...)>
+    static Delegate bind(T* object) {
+        Delegate delegate;
+        delegate.target.object = object;
+        delegate.invoker = &invokeMethod<T, Method>;
+        return delegate;
+    }
+
+    // Reference to a callable object that stays alive elsewhere
+    template <typename Callable>
+    static Delegate fromCallable(Callable& callable) {
+        Delegate delegate;
+        delegate.target.object = &callable;
+        delegate.invoker = &invokeCallable<Callable>;
+        return delegate;
+    }
+
+    R operator()(Args... args) const { return invoker(target, args...); }
+
+    explicit operator bool() const { return invoker != nullptr; }
+
+    bool operator==(const Delegate& other) const {
+        if (invoker != other.invoker) {
+            return false;
+        }
+        return invoker == &invokeFunction ? target.function == other.target.function
+                                          : target.object == other.target.object;
+    }
+    bool operator!=(const Delegate& other) const { return !(*this == other); }
+
+private:
+    union Target {
+        void* object;
+        Function function;
+    };
+
+    using Invoker = R (*)(const Target&, Args...);
+
+    static R invokeFunction(const Target& target, Args... args) {
+        return target.function(args...);
+    }
+
+    template <typename T, R (T::*Method)(Args...)>
+    static R invokeMethod(const Target& target, Args... args) {
+        return (static_cast<T*>(target.object)->*Method)(args...);
+    }
+
+    template <typename Callable>
+    static R invokeCallable(const Target& target, Args... args) {
+        return (*static_cast<Callable*>(target.object))(args...);
+    }
+
+    Target target;
+    Invoker invoker;
+};
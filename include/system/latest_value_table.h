@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free table that keeps only the newest value per slot.
+//
+// One producer writes slots by index and never waits: a value that was not
+// collected yet is simply overwritten. One consumer collects every slot
+// written since its previous call. Each slot has its own sequence lock; a
+// slot caught mid-write is left alone, since the write marks it again when
+// it completes and the next collect picks up the newer value.
+template <typename T, size_t Count>
+class LatestValueTable {
+public:
+    static constexpr size_t WORDS = (Count + 31) / 32;
+
+    LatestValueTable() : overwritten(0) {
+        for (size_t i = 0; i < Count; i++) {
+            slots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < WORDS; i++) {
+            dirty[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Producer side, returns false if an uncollected value was overwritten
+    bool write(size_t index, const T& value) {
+        Slot& slot = slots[index];
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value = value;
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+
+        uint32_t bit = 1u << (index & 31);
+        if (dirty[index / 32].fetch_or(bit, std::memory_order_release) & bit) {
+            overwritten.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    // Consumer side, calls handler(index, value) for each slot written since
+    // the last call and returns how many were handed over
+    template <typename Handler>
+    size_t collect(Handler&& handler) {
+        size_t count = 0;
+        for (size_t word = 0; word < WORDS; word++) {
+            uint32_t bits = dirty[word].exchange(0, std::memory_order_acquire);
+            while (bits != 0) {
+                size_t index = word * 32 + __builtin_ctz(bits);
+                bits &= bits - 1;
+
+                const Slot& slot = slots[index];
+                uint32_t before = slot.sequence.load(std::memory_order_acquire);
+                if (before & 1u) {
+                    continue;
+                }
+                T copy = slot.value;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != before) {
+                    continue;
+                }
+
+                handler(index, copy);
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // Number of values replaced before the consumer collected them
+    uint32_t getOverwrittenCount() const { return overwritten.load(std::memory_order_relaxed); }
+
+    static constexpr size_t capacity() { return Count; }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;  // Odd while the producer writes
+        T value;
+    };
+
+    Slot slots[Count];
+    std::atomic<uint32_t> dirty[WORDS];  // Slots written since the last collect
+    std::atomic<uint32_t> overwritten;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Phases of the main loop that are timed by the profiler
+enum class LoopPhase : uint8_t {
+    SENSOR = 0,
+    WEB,
+    KNX,
+    PID,
+    STATE,
+    PROTOCOLS,
+    COMMANDS,
+    OUTBOUND,
+    COUNT
+};
+
+inline const char* getLoopPhaseName(LoopPhase phase) {
+    switch (phase) {
+        case LoopPhase::SENSOR: return "sensor";
+        case LoopPhase::WEB: return "web";
+        case LoopPhase::KNX: return "knx";
+        case LoopPhase::PID: return "pid";
+        case LoopPhase::STATE: return "state";
+        case LoopPhase::PROTOCOLS: return "protocols";
+        case LoopPhase::COMMANDS: return "commands";
+        case LoopPhase::OUTBOUND: return "outbound";
+        default: return "unknown";
+    }
+}
+
+#ifdef LOOP_PROFILER
+
+#ifndef LOOP_PROFILER_BUDGET_US
+#define LOOP_PROFILER_BUDGET_US 5000  // Default per-phase budget in microseconds
+#endif
+
+// Cycle-counter based profiler for the main loop phases.
+//
+// All storage is static and fixed-size; recording a sample is a handful of
+// integer operations and never allocates. Each phase must only be recorded
+// from one task, which is also the one that clears it after requestReset().
+// Define LOOP_PROFILER to enable it, otherwise PROFILE_PHASE compiles to
+// nothing.
+class LoopProfiler {
+public:
+    static constexpr size_t PHASE_COUNT = static_cast<size_t>(LoopPhase::COUNT);
+    static constexpr size_t BUCKET_COUNT = 32;  // Bucket n holds durations in [2^n, 2^(n+1)) cycles
+
+    struct PhaseStats {
+        uint32_t count;
+        uint32_t overBudget;
+        uint32_t minCycles;
+        uint32_t maxCycles;
+        uint32_t budgetCycles;
+        uint32_t histogram[BUCKET_COUNT];
+    };
+
+    static uint32_t cycles();
+    static uint32_t cyclesPerMicrosecond();
+
+    static void record(LoopPhase phase, uint32_t elapsedCycles);
+    static void setBudget(LoopPhase phase, uint32_t budgetUs);
+    // Clears all phases at once, only before the recording tasks start
+    static void reset();
+    // Safe from any task, each phase is cleared by its next record()
+    static void requestReset();
+
+    static const PhaseStats& getStats(LoopPhase phase) { return stats[static_cast<size_t>(phase)]; }
+    static uint32_t getPercentileCycles(LoopPhase phase, uint8_t percentile);
+
+private:
+    static void clear(size_t index);
+
+    static PhaseStats stats[PHASE_COUNT];
+    static std::atomic<uint32_t> resetRequests;  // One bit per phase
+};
+
+// Records the time spent in the enclosing scope
+class ScopedPhaseTimer {
+public:
+    explicit ScopedPhaseTimer(LoopPhase phase) : phase(phase), start(LoopProfiler::cycles()) {}
+    ~ScopedPhaseTimer() { LoopProfiler::record(phase, LoopProfiler::cycles() - start); }
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    LoopPhase phase;
+    uint32_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_PHASE(phase) ScopedPhaseTimer PROFILE_CONCAT(phaseTimer_, __LINE__)(phase)
+
+#else
+
+#define PROFILE_PHASE(phase) do {} while (0)
+
+#endif // LOOP_PROFILER
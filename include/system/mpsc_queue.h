@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free multi-producer/single-consumer queue.
+//
+// Any number of threads may call push(); exactly one thread may call pop().
+// Producers claim a slot with one compare-and-swap on the tail and publish
+// it through the slot's own sequence number, so they never wait for each
+// other or for the consumer. Items come out in the order their slots were
+// claimed, which keeps each producer's own order. A producer preempted
+// between claiming and publishing holds back the items behind it until it
+// resumes; pop() then reports the queue as empty. Capacity must be a power
+// of two.
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "MpscQueue capacity must be a power of two");
+
+public:
+    MpscQueue() : tail(0), head(0), dropped(0) {
+        for (size_t i = 0; i < Capacity; i++) {
+            cells[i].sequence.store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+        }
+    }
+
+    // Producer side, returns false if the queue is full
+    bool push(const T& item) {
+        uint32_t position = tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[position & MASK];
+            int32_t lag = static_cast<int32_t>(cell->sequence.load(std::memory_order_acquire) - position);
+            if (lag == 0) {
+                // Free and not yet claimed, try to take it
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                // Still holds the item from one lap ago
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                // Another producer claimed it first
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->item = item;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, returns false if no published item is waiting
+    bool pop(T& item) {
+        Cell& cell = cells[head & MASK];
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+        item = cell.item;
+        cell.sequence.store(head + Capacity, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+    // Number of items rejected because the queue was full
+    uint32_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr uint32_t MASK = Capacity - 1;
+
+    struct Cell {
+        std::atomic<uint32_t> sequence;  // position when free, position + 1 when published
+        T item;
+    };
+
+    Cell cells[Capacity];
+    std::atomic<uint32_t> tail;  // Next position to claim, shared by the producers
+    uint32_t head;               // Next position to read, owned by the consumer
+    std::atomic<uint32_t> dropped;
+};
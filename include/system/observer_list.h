@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "system/delegate.h"
+
+// Fixed-capacity list of listeners for one event.
+//
+// Listener storage is sized at compile time and never allocates. Listeners
+// are expected to be registered during setup; add/remove are not safe to
+// call concurrently with notify().
+template <typename Signature, size_t Capacity>
+class ObserverList;
+
+template <size_t Capacity, typename... Args>
+class ObserverList<void(Args...), Capacity> {
+    static_assert(Capacity > 0 && Capacity <= 255, "ObserverList capacity must be 1..255");
+
+public:
+    using Listener = Delegate<void(Args...)>;
+
+    ObserverList() : count(0) {}
+
+    // Returns false if the listener is empty or the list is full
+    bool add(Listener listener) {
+        if (!listener || count >= Capacity) {
+            return false;
+        }
+        listeners[count++] = listener;
+        return true;
+    }
+
+    bool remove(Listener listener) {
+        for (uint8_t i = 0; i < count; i++) {
+            if (listeners[i] == listener) {
+                // Shift down to keep notification order stable
+                for (uint8_t j = i + 1; j < count; j++) {
+                    listeners[j - 1] = listeners[j];
+                }
+                count--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void notify(Args... args) const {
+        for (uint8_t i = 0; i < count; i++) {
+            listeners[i](args...);
+        }
+    }
+
+    void clear() { count = 0; }
+    size_t size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    Listener listeners[Capacity];
+    uint8_t count;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Cooperative deadline scheduler for the main loop.
+//
+// Each subsystem registers a period; the next deadline of every task is kept
+// in a min-heap so runDue() only executes what is actually due and the caller
+// can sleep until the earliest deadline instead of polling on a fixed quantum.
+// The clock is injected so the scheduler can be driven by a virtual clock on a
+// host build.
+class TaskScheduler {
+public:
+    using TaskCallback = std::function<void()>;
+    using ClockFunction = unsigned long (*)();
+
+    static constexpr size_t MAX_TASKS = 8;
+    static constexpr int INVALID_TASK = -1;
+
+    // Per-task timing statistics
+    struct TaskStats {
+        const char* name;
+        unsigned long period;         // Period in ms
+        uint32_t runs;                // Number of executions
+        uint32_t overruns;            // Runs that missed their next deadline
+        unsigned long lastJitter;     // Lateness of the last run in ms
+        unsigned long maxJitter;      // Worst lateness seen in ms
+        unsigned long lastDuration;   // Execution time of the last run in ms
+        unsigned long maxDuration;    // Worst execution time seen in ms
+    };
+
+    explicit TaskScheduler(ClockFunction clock);
+
+    // Task registration, returns the task id or INVALID_TASK
+    int addTask(const char* name, unsigned long period, TaskCallback callback);
+    void setPeriod(int taskId, unsigned long period);
+    void triggerNow(int taskId);
+
+    // Run every task whose deadline has passed
+    void runDue();
+
+    // Milliseconds until the earliest deadline, 0 if something is due
+    unsigned long timeUntilNextDeadline() const;
+
+    // Statistics
+    size_t getTaskCount() const { return taskCount; }
+    const TaskStats& getStats(int taskId) const { return tasks[taskId].stats; }
+    void resetStats();
+    void logStats() const;
+
+private:
+    struct Task {
+        TaskCallback callback;
+        unsigned long deadline;
+        TaskStats stats;
+    };
+
+    ClockFunction clock;
+    Task tasks[MAX_TASKS];
+    uint8_t heap[MAX_TASKS];      // Task ids ordered by deadline
+    uint8_t heapPosition[MAX_TASKS];
+    size_t taskCount;
+
+    // Heap helpers
+    bool isEarlier(uint8_t a, uint8_t b) const;
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void swapHeap(size_t a, size_t b);
+};
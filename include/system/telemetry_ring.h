@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free ring that keeps the newest samples.
+//
+// One producer appends and never waits: once the ring is full, every push
+// overwrites the oldest sample. Readers follow with their own cursor, the
+// running sequence number of the next sample they want, so any number of
+// them can read at their own pace without the producer knowing. A reader
+// that fell more than the capacity behind skips to the oldest sample still
+// held; a sample overwritten while it was being copied is detected and
+// skipped the same way. Like a sequence lock writer, the producer announces
+// the slot it is about to overwrite before writing it, so readers can tell
+// a copy that overlapped the write. Capacity must be a power of two, and
+// readers see at most Capacity - 1 samples of history.
+template <typename T, size_t Capacity>
+class TelemetryRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "TelemetryRing capacity must be a power of two");
+
+public:
+    TelemetryRing() : head(0), writeHead(0) {}
+
+    // Producer side, never blocks and never fails
+    void push(const T& item) {
+        uint32_t sequence = head.load(std::memory_order_relaxed);
+        writeHead.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        buffer[sequence & MASK] = item;
+        head.store(sequence + 1, std::memory_order_release);
+    }
+
+    // Sequence number the next push will get
+    uint32_t getHead() const { return head.load(std::memory_order_acquire); }
+
+    // Copies up to max samples from cursor on, every step-th one, and
+    // advances the cursor past them. Returns the number copied; samples
+    // lost to overwriting are added to skipped if given.
+    size_t read(uint32_t& cursor, T* out, size_t max, uint32_t step = 1, uint32_t* skipped = nullptr) const {
+        if (step == 0) step = 1;
+        size_t count = 0;
+        uint32_t end = head.load(std::memory_order_acquire);
+
+        while (count < max && cursor != end) {
+            // The slot after the newest may be mid-write, so Capacity - 1 are readable
+            if (end - cursor > Capacity - 1) {
+                if (skipped) *skipped += end - (Capacity - 1) - cursor;
+                cursor = end - (Capacity - 1);
+            }
+
+            out[count] = buffer[cursor & MASK];
+
+            // The copy is valid unless the producer started on its slot meanwhile
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t started = writeHead.load(std::memory_order_relaxed);
+            end = head.load(std::memory_order_acquire);
+            if (started - cursor > Capacity) {
+                continue;
+            }
+
+            count++;
+            uint32_t available = end - cursor;
+            cursor += step < available ? step : available;
+        }
+        return count;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr uint32_t MASK = Capacity - 1;
+
+    T buffer[Capacity];
+    std::atomic<uint32_t> head;       // Sequence number of the next sample, owned by the producer
+    std::atomic<uint32_t> writeHead;  // Bumped before the slot is written, head after
+};
@@ -2,24 +2,98 @@
 #define THERMOSTAT_STATE_H
 
 #include <Arduino.h>
-#include <functional>
+#include <atomic>
 #include "thermostat_types.h"
+#include "thermostat_units.h"
+#include "system/observer_list.h"
 
+// Maximum number of listeners per state field
+#ifndef THERMOSTAT_MAX_LISTENERS
+#define THERMOSTAT_MAX_LISTENERS 4
+#endif
+
+// State fields, used as bit positions in change masks
+enum class StateField : uint8_t {
+  TEMPERATURE = 0,
+  HUMIDITY,
+  PRESSURE,
+  TARGET_TEMPERATURE,
+  VALVE_POSITION,
+  MODE,
+  HEATING,
+  STATUS,
+  ENABLED,
+  OUTDOOR_TEMPERATURE,
+  FLOW_TEMPERATURE,
+  COUNT
+};
+
+inline uint16_t stateFieldBit(StateField field) {
+  return static_cast<uint16_t>(1u << static_cast<uint8_t>(field));
+}
+
+// Consistent copy of all state fields, see ThermostatState::snapshot()
+struct ThermostatSnapshot {
+  float currentTemperature;
+  float currentHumidity;
+  float currentPressure;
+  float targetTemperature;
+  float valvePosition;
+  ThermostatMode mode;
+  bool heating;
+  ThermostatStatus status;
+  bool enabled;
+  float outdoorTemperature;
+  float flowTemperature;
+  uint32_t version;  // State version the copy was taken at
+
+  CompactReading compact() const {
+    return Units::makeCompactReading(currentTemperature, currentHumidity, currentPressure, valvePosition);
+  }
+};
+
+// Fields that changed after a given version, see ThermostatState::changesSince()
+struct ThermostatDelta {
+  uint16_t changedFields;  // Mask of stateFieldBit()s
+  ThermostatSnapshot values;
+
+  bool has(StateField field) const { return changedFields & stateFieldBit(field); }
+};
+
+// State is written by a single task (the control task). Other tasks must read
+// it through snapshot(), which is protected by a sequence lock: readers never
+// block the writer and retry if a write overlapped their copy.
 class ThermostatState {
 public:
   // Constructor with default values
   ThermostatState();
   
   // Getters
-  float getCurrentTemperature() const { return currentTemperature; }
-  float getCurrentHumidity() const { return currentHumidity; }
-  float getCurrentPressure() const { return currentPressure; }
-  float getTargetTemperature() const { return targetTemperature; }
-  float getValvePosition() const { return valvePosition; }
+  float getCurrentTemperature() const { return loadTemperature(currentTemperature); }
+  float getCurrentHumidity() const { return loadPercent(currentHumidity); }
+  float getCurrentPressure() const { return loadPressure(currentPressure); }
+  float getTargetTemperature() const { return loadTemperature(targetTemperature); }
+  float getValvePosition() const { return loadPercent(valvePosition); }
   ThermostatMode getMode() const { return operatingMode; }
   bool isHeating() const { return heatingActive; }
   ThermostatStatus getStatus() const { return status; }
   bool isEnabled() const { return enabled; }
+  float getOutdoorTemperature() const { return loadTemperature(outdoorTemperature); }
+  // False until the first outdoor reading arrived
+  bool hasOutdoorTemperature() const { return fieldVersions[static_cast<uint8_t>(StateField::OUTDOOR_TEMPERATURE)] != 0; }
+  float getFlowTemperature() const { return loadTemperature(flowTemperature); }
+  bool hasFlowTemperature() const { return fieldVersions[static_cast<uint8_t>(StateField::FLOW_TEMPERATURE)] != 0; }
+  
+  // Lock-free consistent read for tasks other than the writer
+  ThermostatSnapshot snapshot() const;
+  
+  // The version increases with every change; all changes of one
+  // beginUpdate()/endUpdate() batch share a version. Pass the version of the
+  // previous read to get only the fields changed since. A version of 0, or
+  // one newer than the current state (e.g. from before a reboot), reports
+  // all fields.
+  ThermostatDelta changesSince(uint32_t since) const;
+  uint32_t getVersion() const { return version; }
   
   // Setters
   void setTemperature(float value);
@@ -28,62 +102,134 @@ public:
   void setTargetTemperature(float value);
   void setValvePosition(float value);
   void setMode(ThermostatMode mode);
-  void setHeating(bool active) { heatingActive = active; }
-  void setStatus(ThermostatStatus newStatus) { status = newStatus; }
+  void setHeating(bool active);
+  void setStatus(ThermostatStatus newStatus);
   void setEnabled(bool state);
+  void setOutdoorTemperature(float value);
+  // Heating circuit flow, every reading notifies so a silent sensor can be told from a steady one
+  void setFlowTemperature(float value);
   
   // Alias methods for clarity
   void setCurrentTemperature(float value) { setTemperature(value); }
   void setCurrentHumidity(float value) { setHumidity(value); }
   void setCurrentPressure(float value) { setPressure(value); }
   
-  // Callback function types
-  using TemperatureCallback = std::function<void(float)>;
-  using HumidityCallback = std::function<void(float)>;
-  using PressureCallback = std::function<void(float)>;
-  using TargetTemperatureCallback = std::function<void(float)>;
-  using ValvePositionCallback = std::function<void(float)>;
-  using ModeCallback = std::function<void(ThermostatMode)>;
-  using HeatingCallback = std::function<void(bool)>;
-  using StatusCallback = std::function<void(ThermostatStatus)>;
+  // Listener types, non-owning delegates that never allocate
+  using TemperatureCallback = Delegate<void(float)>;
+  using HumidityCallback = Delegate<void(float)>;
+  using PressureCallback = Delegate<void(float)>;
+  using TargetTemperatureCallback = Delegate<void(float)>;
+  using ValvePositionCallback = Delegate<void(float)>;
+  using ModeCallback = Delegate<void(ThermostatMode)>;
+  using HeatingCallback = Delegate<void(bool)>;
+  using StatusCallback = Delegate<void(ThermostatStatus)>;
+  using EnabledCallback = Delegate<void(bool)>;
+  using OutdoorTemperatureCallback = Delegate<void(float)>;
+  using FlowTemperatureCallback = Delegate<void(float)>;
+  using BatchCallback = Delegate<void(uint16_t)>;  // Receives a mask of stateFieldBit()s
+  
+  // Register listeners, each field supports up to THERMOSTAT_MAX_LISTENERS.
+  // Returns false if the listener table for the field is full.
+  bool onTemperatureChange(TemperatureCallback cb) { return temperatureListeners.add(cb); }
+  bool onHumidityChange(HumidityCallback cb) { return humidityListeners.add(cb); }
+  bool onPressureChange(PressureCallback cb) { return pressureListeners.add(cb); }
+  bool onTargetTemperatureChange(TargetTemperatureCallback cb) { return targetTemperatureListeners.add(cb); }
+  bool onValvePositionChange(ValvePositionCallback cb) { return valvePositionListeners.add(cb); }
+  bool onModeChange(ModeCallback cb) { return modeListeners.add(cb); }
+  bool onHeatingChange(HeatingCallback cb) { return heatingListeners.add(cb); }
+  bool onStatusChange(StatusCallback cb) { return statusListeners.add(cb); }
+  bool onEnabledChange(EnabledCallback cb) { return enabledListeners.add(cb); }
+  bool onOutdoorTemperatureChange(OutdoorTemperatureCallback cb) { return outdoorTemperatureListeners.add(cb); }
+  bool onFlowTemperatureChange(FlowTemperatureCallback cb) { return flowTemperatureListeners.add(cb); }
+  bool onBatchChange(BatchCallback cb) { return batchListeners.add(cb); }
   
-  // Register callbacks
-  void onTemperatureChange(TemperatureCallback cb) { temperatureCallback = cb; }
-  void onHumidityChange(HumidityCallback cb) { humidityCallback = cb; }
-  void onPressureChange(PressureCallback cb) { pressureCallback = cb; }
-  void onTargetTemperatureChange(TargetTemperatureCallback cb) { targetTemperatureCallback = cb; }
-  void onValvePositionChange(ValvePositionCallback cb) { valvePositionCallback = cb; }
-  void onModeChange(ModeCallback cb) { modeCallback = cb; }
-  void onHeatingChange(HeatingCallback cb) { heatingCallback = cb; }
-  void onStatusChange(StatusCallback cb) { statusCallback = cb; }
+  // Notify the listeners of a field with its unchanged value, e.g. to
+  // refresh a value on the bus. The version is not changed.
+  void republish(StateField field) { fieldChanged(field); }
+  
+  // Coalesce notifications: between beginUpdate() and endUpdate() setters only
+  // record which fields changed. endUpdate() then notifies each changed field
+  // once with its final value, followed by a single batch notification.
+  // Snapshot readers see all changes of the batch at once.
+  void beginUpdate();
+  void endUpdate();
 
 private:
+  // Storage units, see thermostat_units.h
+#ifdef THERMOSTAT_FIXED_POINT
+  using TemperatureValue = CentiDegrees;
+  using PressureValue = DeciHectopascal;
+  using PercentValue = HalfPercent;
+  static constexpr TemperatureValue storeTemperature(float value) { return Units::toCentiDegrees(value); }
+  static constexpr PressureValue storePressure(float value) { return Units::toDeciHectopascal(value); }
+  static constexpr PercentValue storePercent(float value) { return Units::toHalfPercent(value); }
+  static constexpr float loadTemperature(TemperatureValue value) { return Units::fromCentiDegrees(value); }
+  static constexpr float loadPressure(PressureValue value) { return Units::fromDeciHectopascal(value); }
+  static constexpr float loadPercent(PercentValue value) { return Units::fromHalfPercent(value); }
+#else
+  using TemperatureValue = float;
+  using PressureValue = float;
+  using PercentValue = float;
+  static constexpr float storeTemperature(float value) { return value; }
+  static constexpr float storePressure(float value) { return value; }
+  static constexpr float storePercent(float value) { return value; }
+  static constexpr float loadTemperature(float value) { return value; }
+  static constexpr float loadPressure(float value) { return value; }
+  static constexpr float loadPercent(float value) { return value; }
+#endif
+
   // Current state
-  float currentTemperature;
-  float currentHumidity;
-  float currentPressure;
-  float targetTemperature;
-  float valvePosition;
+  TemperatureValue currentTemperature;
+  PercentValue currentHumidity;
+  PressureValue currentPressure;
+  TemperatureValue targetTemperature;
+  PercentValue valvePosition;
   ThermostatMode operatingMode;
   bool heatingActive;
   ThermostatStatus status;
   bool enabled;  // New member for ON/OFF state
+  TemperatureValue outdoorTemperature;
+  TemperatureValue flowTemperature;
   
   // Validation helpers
   bool isValidTemperature(float value) const;
   bool isValidHumidity(float value) const;
   bool isValidPressure(float value) const;
   bool isValidValvePosition(float value) const;
+  bool isValidOutdoorTemperature(float value) const;
+  bool isValidFlowTemperature(float value) const;
+  
+  // Versioning, written inside the sequence lock
+  uint32_t version;
+  uint32_t writeVersion;
+  uint32_t fieldVersions[static_cast<uint8_t>(StateField::COUNT)];
+  
+  // Sequence lock, odd while a write is in progress
+  std::atomic<uint32_t> sequence;
+  void beginWrite();
+  void endWrite(StateField field);
+  void readConsistent(ThermostatSnapshot& copy, uint32_t* versions) const;
+  
+  // Change notification
+  void notifyField(StateField field);
+  void fieldChanged(StateField field);
+  
+  uint8_t updateDepth;
+  uint16_t pendingChanges;
   
-  // Callbacks
-  TemperatureCallback temperatureCallback;
-  HumidityCallback humidityCallback;
-  PressureCallback pressureCallback;
-  TargetTemperatureCallback targetTemperatureCallback;
-  ValvePositionCallback valvePositionCallback;
-  ModeCallback modeCallback;
-  HeatingCallback heatingCallback;
-  StatusCallback statusCallback;
+  // Listeners
+  ObserverList<void(float), THERMOSTAT_MAX_LISTENERS> temperatureListeners;
+  ObserverList<void(float), THERMOSTAT_MAX_LISTENERS> humidityListeners;
+  ObserverList<void(float), THERMOSTAT_MAX_LISTENERS> pressureListeners;
+  ObserverList<void(float), THERMOSTAT_MAX_LISTENERS> targetTemperatureListeners;
+  ObserverList<void(float), THERMOSTAT_MAX_LISTENERS> valvePositionListeners;
+  ObserverList<void(ThermostatMode), THERMOSTAT_MAX_LISTENERS> modeListeners;
+  ObserverList<void(bool), THERMOSTAT_MAX_LISTENERS> heatingListeners;
+  ObserverList<void(ThermostatStatus), THERMOSTAT_MAX_LISTENERS> statusListeners;
+  ObserverList<void(bool), THERMOSTAT_MAX_LISTENERS> enabledListeners;
+  ObserverList<void(float), THERMOSTAT_MAX_LISTENERS> outdoorTemperatureListeners;
+  ObserverList<void(float), THERMOSTAT_MAX_LISTENERS> flowTemperatureListeners;
+  ObserverList<void(uint16_t), THERMOSTAT_MAX_LISTENERS> batchListeners;
 };
 
 #endif // THERMOSTAT_STATE_H
\ No newline at end of file
@@ -12,14 +12,20 @@ enum class ThermostatMode : uint8_t {
     BOOST = 4,
     ANTIFREEZE = 5
 };
+constexpr uint8_t THERMOSTAT_MODE_COUNT = 6;
 
 // Temperature ranges and limits
 struct ThermostatLimits {
     static constexpr float MIN_TEMPERATURE = 5.0f;      // Minimum allowed temperature
     static constexpr float MAX_TEMPERATURE = 30.0f;     // Maximum allowed temperature
     static constexpr float DEFAULT_TEMPERATURE = 21.0f; // Default target temperature
+    static constexpr float MIN_OUTDOOR_TEMPERATURE = -50.0f;
+    static constexpr float MAX_OUTDOOR_TEMPERATURE = 60.0f;
+    static constexpr float MIN_FLOW_TEMPERATURE = 0.0f;
+    static constexpr float MAX_FLOW_TEMPERATURE = 95.0f;
     static constexpr float MIN_VALVE_POSITION = 0.0f;   // Valve fully closed
     static constexpr float MAX_VALVE_POSITION = 100.0f; // Valve fully open
+    static constexpr uint8_t MAX_ZONES = 16;            // Rooms a hub drives besides its own
     
     // Prevent instantiation
     ThermostatLimits() = delete;
@@ -55,8 +61,13 @@ enum class CommandType : uint8_t {
     CMD_MODE,
     CMD_VALVE,
     CMD_HEATING,
-    CMD_SET_TEMPERATURE  // Added for temperature setting commands
+    CMD_SET_TEMPERATURE,  // Added for temperature setting commands
+    CMD_ENABLE,           // Thermostat on/off
+    CMD_OUTDOOR_TEMPERATURE,
+    CMD_FLOW_TEMPERATURE,
+    CMD_COMFORT_TIME      // Minutes until the comfort setpoint is due
 };
+constexpr uint8_t COMMAND_TYPE_COUNT = 10;
 
 // Helper functions
 inline const char* getThermostatModeName(ThermostatMode mode) {
@@ -71,6 +82,19 @@ inline const char* getThermostatModeName(ThermostatMode mode) {
     }
 }
 
+// Lower-case mode name used as a key in config.json
+inline const char* getThermostatModeKey(ThermostatMode mode) {
+    switch (mode) {
+        case ThermostatMode::OFF: return "off";
+        case ThermostatMode::COMFORT: return "comfort";
+        case ThermostatMode::ECO: return "eco";
+        case ThermostatMode::AWAY: return "away";
+        case ThermostatMode::BOOST: return "boost";
+        case ThermostatMode::ANTIFREEZE: return "antifreeze";
+        default: return "unknown";
+    }
+}
+
 inline const char* getThermostatStatusString(ThermostatStatus status) {
     switch (status) {
         case ThermostatStatus::OK:
@@ -129,38 +153,38 @@ inline ThermostatStatus intToThermostatStatus(int value) {
     return static_cast<ThermostatStatus>(value);
 }
 
-// Add JSON serialization support
+// Add JSON serialization support. Converter is declared in ArduinoJson's
+// inline version namespace, whose name differs between the ESP32 and the
+// host build
 namespace ArduinoJson {
-    namespace V6215PB2 {
-        template<>
-        struct Converter<ThermostatMode> {
-            static void toJson(const ThermostatMode& src, JsonVariant dst) {
-                switch (src) {
-                    case ThermostatMode::OFF: dst.set("OFF"); break;
-                    case ThermostatMode::COMFORT: dst.set("COMFORT"); break;
-                    case ThermostatMode::ECO: dst.set("ECO"); break;
-                    case ThermostatMode::AWAY: dst.set("AWAY"); break;
-                    case ThermostatMode::BOOST: dst.set("BOOST"); break;
-                    case ThermostatMode::ANTIFREEZE: dst.set("ANTIFREEZE"); break;
-                }
+    template<>
+    struct Converter<ThermostatMode> {
+        static void toJson(const ThermostatMode& src, JsonVariant dst) {
+            switch (src) {
+                case ThermostatMode::OFF: dst.set("OFF"); break;
+                case ThermostatMode::COMFORT: dst.set("COMFORT"); break;
+                case ThermostatMode::ECO: dst.set("ECO"); break;
+                case ThermostatMode::AWAY: dst.set("AWAY"); break;
+                case ThermostatMode::BOOST: dst.set("BOOST"); break;
+                case ThermostatMode::ANTIFREEZE: dst.set("ANTIFREEZE"); break;
             }
-        };
-
-        template<>
-        struct Converter<ThermostatStatus> {
-            static void toJson(const ThermostatStatus& src, JsonVariant dst) {
-                switch (src) {
-                    case ThermostatStatus::OK: dst.set("OK"); break;
-                    case ThermostatStatus::WARNING: dst.set("WARNING"); break;
-                    case ThermostatStatus::ERROR_CONFIGURATION: dst.set("Configuration Error"); break;
-                    case ThermostatStatus::ERROR_COMMUNICATION: dst.set("Communication Error"); break;
-                    case ThermostatStatus::ERROR_SENSOR: dst.set("Sensor Error"); break;
-                    case ThermostatStatus::ERROR_SENSOR_READ: dst.set("Sensor Read Error"); break;
-                    case ThermostatStatus::ERROR_CONTROL: dst.set("Control Error"); break;
-                    case ThermostatStatus::ERROR_STORAGE: dst.set("Storage Error"); break;
-                    case ThermostatStatus::ERROR_FILESYSTEM: dst.set("Filesystem Error"); break;
-                }
+        }
+    };
+
+    template<>
+    struct Converter<ThermostatStatus> {
+        static void toJson(const ThermostatStatus& src, JsonVariant dst) {
+            switch (src) {
+                case ThermostatStatus::OK: dst.set("OK"); break;
+                case ThermostatStatus::WARNING: dst.set("WARNING"); break;
+                case ThermostatStatus::ERROR_CONFIGURATION: dst.set("Configuration Error"); break;
+                case ThermostatStatus::ERROR_COMMUNICATION: dst.set("Communication Error"); break;
+                case ThermostatStatus::ERROR_SENSOR: dst.set("Sensor Error"); break;
+                case ThermostatStatus::ERROR_SENSOR_READ: dst.set("Sensor Read Error"); break;
+                case ThermostatStatus::ERROR_CONTROL: dst.set("Control Error"); break;
+                case ThermostatStatus::ERROR_STORAGE: dst.set("Storage Error"); break;
+                case ThermostatStatus::ERROR_FILESYSTEM: dst.set("Filesystem Error"); break;
             }
-        };
-    }
+        }
+    };
 } 
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compact fixed-point units for readings.
+//
+// Temperatures are stored in hundredths of a degree, pressure in tenths of a
+// hPa and humidity/valve position in half percent steps. All conversions are
+// constexpr, round to the nearest step and saturate at the range of the type,
+// so values that compare equal as integers are exactly equal.
+//
+// Define THERMOSTAT_FIXED_POINT to store ThermostatState in these units and
+// to encode KNX and MQTT payloads from the integers instead of floats.
+using CentiDegrees = int16_t;      // 0.01 °C
+using DeciHectopascal = uint16_t;  // 0.1 hPa
+using HalfPercent = uint8_t;       // 0.5 %
+
+// Reading of all sensor and output values in 6 bytes, for history buffers
+struct CompactReading {
+    CentiDegrees temperature;
+    DeciHectopascal pressure;
+    HalfPercent humidity;
+    HalfPercent valvePosition;
+};
+static_assert(sizeof(CompactReading) == 6, "CompactReading must stay packed");
+
+namespace Units {
+
+constexpr long roundScaled(float value, float scale) {
+    return static_cast<long>(value * scale + (value >= 0.0f ? 0.5f : -0.5f));
+}
+
+constexpr long clampLong(long value, long low, long high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+constexpr CentiDegrees toCentiDegrees(float celsius) {
+    return static_cast<CentiDegrees>(clampLong(roundScaled(celsius, 100.0f), INT16_MIN, INT16_MAX));
+}
+
+constexpr float fromCentiDegrees(CentiDegrees value) {
+    return value / 100.0f;
+}
+
+constexpr DeciHectopascal toDeciHectopascal(float hpa) {
+    return static_cast<DeciHectopascal>(clampLong(roundScaled(hpa, 10.0f), 0, UINT16_MAX));
+}
+
+constexpr float fromDeciHectopascal(DeciHectopascal value) {
+    return value / 10.0f;
+}
+
+constexpr HalfPercent toHalfPercent(float percent) {
+    return static_cast<HalfPercent>(clampLong(roundScaled(percent, 2.0f), 0, UINT8_MAX));
+}
+
+constexpr float fromHalfPercent(HalfPercent value) {
+    return value / 2.0f;
+}
+
+// Common scale for the wire encoders
+constexpr int32_t hundredths(CentiDegrees value) { return value; }
+constexpr int32_t hundredths(DeciHectopascal value) { return static_cast<int32_t>(value) * 10; }
+constexpr int32_t hundredths(HalfPercent value) { return static_cast<int32_t>(value) * 50; }
+
+constexpr CompactReading makeCompactReading(float temperature, float humidity,
+                                            float pressure, float valvePosition) {
+    return CompactReading{toCentiDegrees(temperature), toDeciHectopascal(pressure),
+                          toHalfPercent(humidity), toHalfPercent(valvePosition)};
+}
+
+// KNX DPT 9.xxx 2-byte float from a value in hundredths:
+// value = 0.01 * M * 2^E with a 12-bit two's complement mantissa M and 4-bit exponent E
+constexpr uint16_t encodeDpt9(int32_t hundredthsValue) {
+    int32_t mantissa = hundredthsValue;
+    uint8_t exponent = 0;
+    while ((mantissa < -2048 || mantissa > 2047) && exponent < 15) {
+        mantissa = mantissa >= 0 ? (mantissa + 1) / 2 : (mantissa - 1) / 2;
+        exponent++;
+    }
+    mantissa = clampLong(mantissa, -2048, 2047);
+    return static_cast<uint16_t>((mantissa < 0 ? 0x8000 : 0) |
+                                 (exponent << 11) |
+                                 (static_cast<uint16_t>(mantissa) & 0x07FF));
+}
+
+// Writes a scaled integer as decimal text, e.g. (2150, 2) -> "21.50".
+// Returns the number of characters written, 0 if the buffer is too small.
+inline size_t formatScaled(char* buffer, size_t size, int32_t value, uint8_t decimals) {
+    char digits[12];
+    size_t count = 0;
+    uint32_t magnitude = value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0 || count <= decimals);
+
+    size_t length = count + (value < 0 ? 1 : 0) + (decimals ? 1 : 0);
+    if (length + 1 > size) {
+        if (size) buffer[0] = '\0';
+        return 0;
+    }
+
+    size_t pos = 0;
+    if (value < 0) buffer[pos++] = '-';
+    while (count > 0) {
+        if (count == decimals) buffer[pos++] = '.';
+        buffer[pos++] = digits[--count];
+    }
+    buffer[pos] = '\0';
+    return pos;
+}
+
+}  // namespace Units
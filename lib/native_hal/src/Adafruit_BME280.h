@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "native_hal.h"
+
+// Host stand-in for the BME280 driver, readings come from the simulated room
+class Adafruit_BME280 {
+public:
+    enum sensor_mode { MODE_SLEEP = 0, MODE_FORCED = 1, MODE_NORMAL = 3 };
+    enum sensor_sampling { SAMPLING_NONE = 0, SAMPLING_X1, SAMPLING_X2, SAMPLING_X4, SAMPLING_X8, SAMPLING_X16 };
+    enum sensor_filter { FILTER_OFF = 0, FILTER_X2, FILTER_X4, FILTER_X8, FILTER_X16 };
+    enum standby_duration { STANDBY_MS_0_5 = 0, STANDBY_MS_62_5, STANDBY_MS_125, STANDBY_MS_250,
+                            STANDBY_MS_500, STANDBY_MS_1000, STANDBY_MS_10, STANDBY_MS_20 };
+
+    bool begin(uint8_t address = 0x77) { return address == NativeHal::BME280_ADDRESS && !NativeHal::hasSensorFault(); }
+
+    void setSampling(sensor_mode mode = MODE_NORMAL,
+                     sensor_sampling tempSampling = SAMPLING_X16,
+                     sensor_sampling pressSampling = SAMPLING_X16,
+                     sensor_sampling humSampling = SAMPLING_X16,
+                     sensor_filter filter = FILTER_OFF,
+                     standby_duration duration = STANDBY_MS_0_5) {
+        (void)mode; (void)tempSampling; (void)pressSampling;
+        (void)humSampling; (void)filter; (void)duration;
+    }
+
+    float readTemperature() { return NativeHal::hasSensorFault() ? NAN : NativeHal::getRoomTemperature(); }
+    float readHumidity() { return NativeHal::hasSensorFault() ? NAN : NativeHal::getRoomHumidity(); }
+    float readPressure() { return NativeHal::hasSensorFault() ? NAN : NativeHal::getRoomPressure() * 100.0f; }  // Pa, like the driver
+};
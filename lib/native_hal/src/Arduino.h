@@ -0,0 +1,44 @@
+#pragma once
+
+// Host stand-in for the subset of the Arduino core used by the firmware
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <math.h>
+#include "esp_log.h"
+#include "native_hal.h"
+#include "Esp.h"
+#include "HardwareSerial.h"
+#include "WString.h"
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// Overloads next to the C library's random(void)
+long random(long howBig);
+long random(long howSmall, long howBig);
+
+// glibc has its own from 2.38 on
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char* destination, const char* source, size_t size) {
+    size_t length = strlen(source);
+    if (size > 0) {
+        size_t count = length < size - 1 ? length : size - 1;
+        memcpy(destination, source, count);
+        destination[count] = '\0';
+    }
+    return length;
+}
+#endif
+
+template <typename T, typename L, typename H>
+inline T constrain(T value, L low, H high) {
+    return value < low ? low : (value > high ? high : value);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+// Host stand-in for the captive portal DNS server, answers nothing
+
+#include <cstdint>
+#include "IPAddress.h"
+
+class DNSServer {
+public:
+    bool start(uint16_t port, const char* domain, IPAddress ip) {
+        (void)port;
+        (void)domain;
+        (void)ip;
+        return true;
+    }
+    void stop() {}
+    void processNextRequest() {}
+};
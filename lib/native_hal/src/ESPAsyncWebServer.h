@@ -0,0 +1,355 @@
+#pragma once
+
+// Host stand-in for the async web server. Nothing listens on a socket: a
+// started server registers under its port, and a test hands it requests it
+// built itself with AsyncWebServer::dispatch(). Handlers answer through the
+// request, which keeps the response for the test to inspect.
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "FS.h"
+#include "IPAddress.h"
+#include "WString.h"
+
+enum WebRequestMethod {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111,
+};
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                           size_t len, bool final)> ArUploadHandlerFunction;
+
+class AsyncWebParameter {
+public:
+    AsyncWebParameter(const String& name, const String& value, bool form = false, bool file = false)
+        : _name(name), _value(value), _form(form), _file(file) {}
+
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+    bool isPost() const { return _form; }
+    bool isFile() const { return _file; }
+
+private:
+    String _name;
+    String _value;
+    bool _form;
+    bool _file;
+};
+
+class AsyncWebHeader {
+public:
+    AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {}
+
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+
+private:
+    String _name;
+    String _value;
+};
+
+class AsyncWebServerResponse {
+public:
+    AsyncWebServerResponse(int code, const String& contentType, const String& content)
+        : _code(code), _contentType(contentType), _content(content) {}
+
+    void addHeader(const String& name, const String& value) { _headers.emplace_back(name, value); }
+
+    int code() const { return _code; }
+    const String& contentType() const { return _contentType; }
+    const String& content() const { return _content; }
+    String header(const String& name) const {
+        for (const AsyncWebHeader& header : _headers) {
+            if (header.name() == name) return header.value();
+        }
+        return String();
+    }
+
+private:
+    int _code;
+    String _contentType;
+    String _content;
+    std::vector<AsyncWebHeader> _headers;
+};
+
+class AsyncClient {
+public:
+    IPAddress remoteIP() const { return IPAddress(127, 0, 0, 1); }
+};
+
+class AsyncWebServerRequest {
+public:
+    AsyncWebServerRequest(WebRequestMethodComposite method, const String& url) : _method(method), _url(url) {}
+    ~AsyncWebServerRequest() { free(_tempObject); }
+    AsyncWebServerRequest(const AsyncWebServerRequest&) = delete;
+    AsyncWebServerRequest& operator=(const AsyncWebServerRequest&) = delete;
+
+    // Filled in by the test before the request is dispatched
+    void addParam(const String& name, const String& value, bool form = false) { _params.emplace_back(name, value, form); }
+    void addHeader(const String& name, const String& value) { _headers.emplace_back(name, value); }
+    void setCredentials(const String& username, const String& password) {
+        _username = username;
+        _password = password;
+    }
+
+    WebRequestMethodComposite method() const { return _method; }
+    const String& url() const { return _url; }
+    AsyncClient* client() { return &_client; }
+
+    bool authenticate(const char* username, const char* password) const {
+        return _username == username && _password == password;
+    }
+    void requestAuthentication(const char* realm = nullptr) {
+        AsyncWebServerResponse* response = beginResponse(401, "text/plain", "Unauthorized");
+        response->addHeader("WWW-Authenticate", String("Basic realm=\"") + (realm ? realm : "Login Required") + "\"");
+        send(response);
+    }
+
+    bool hasHeader(const String& name) const { return findHeader(name) != nullptr; }
+    String header(const String& name) const {
+        const AsyncWebHeader* header = findHeader(name);
+        return header ? header->value() : String();
+    }
+
+    size_t params() const { return _params.size(); }
+    AsyncWebParameter* getParam(size_t index) { return index < _params.size() ? &_params[index] : nullptr; }
+    bool hasParam(const String& name, bool post = false, bool file = false) const {
+        return const_cast<AsyncWebServerRequest*>(this)->getParam(name, post, file) != nullptr;
+    }
+    AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) {
+        for (AsyncWebParameter& param : _params) {
+            if (param.name() == name && param.isPost() == post && param.isFile() == file) return &param;
+        }
+        return nullptr;
+    }
+
+    AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(),
+                                          const String& content = String()) {
+        return new AsyncWebServerResponse(code, contentType, content);
+    }
+    AsyncWebServerResponse* beginResponse(fs::FS& fs, const String& path, const String& contentType = String(),
+                                          bool download = false) {
+        (void)download;
+        fs::File file = fs.open(path, "r");
+        if (!file || file.isDirectory()) {
+            return new AsyncWebServerResponse(404, "text/plain", "Not found");
+        }
+        return new AsyncWebServerResponse(200, contentType, file.readString());
+    }
+    void send(AsyncWebServerResponse* response) {
+        // Only the first response goes out, like on the device
+        if (_response) {
+            delete response;
+            return;
+        }
+        _response.reset(response);
+    }
+    void send(int code, const String& contentType = String(), const String& content = String()) {
+        send(beginResponse(code, contentType, content));
+    }
+
+    // What the handler sent, null when it sent nothing
+    const AsyncWebServerResponse* response() const { return _response.get(); }
+
+    void* _tempObject = nullptr;
+
+private:
+    const AsyncWebHeader* findHeader(const String& name) const {
+        for (const AsyncWebHeader& header : _headers) {
+            if (header.name() == name) return &header;
+        }
+        return nullptr;
+    }
+
+    WebRequestMethodComposite _method;
+    String _url;
+    String _username;
+    String _password;
+    std::vector<AsyncWebParameter> _params;
+    std::vector<AsyncWebHeader> _headers;
+    AsyncClient _client;
+    std::unique_ptr<AsyncWebServerResponse> _response;
+};
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+    virtual bool canHandle(AsyncWebServerRequest* request) = 0;
+    virtual void handleRequest(AsyncWebServerRequest* request) = 0;
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+    AsyncCallbackWebHandler(const String& uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                            ArUploadHandlerFunction onUpload)
+        : _uri(uri), _method(method), _onRequest(onRequest), _onUpload(onUpload) {}
+
+    bool canHandle(AsyncWebServerRequest* request) override {
+        return (request->method() & _method) && request->url() == _uri;
+    }
+    void handleRequest(AsyncWebServerRequest* request) override {
+        if (_onRequest) _onRequest(request);
+    }
+
+private:
+    String _uri;
+    WebRequestMethodComposite _method;
+    ArRequestHandlerFunction _onRequest;
+    ArUploadHandlerFunction _onUpload;
+};
+
+// Maps a URI prefix onto a path of the file system
+class AsyncStaticWebHandler : public AsyncWebHandler {
+public:
+    AsyncStaticWebHandler(const String& uri, fs::FS& fs, const String& path, const char* cacheControl)
+        : _uri(uri), _fs(fs), _path(path), _cacheControl(cacheControl ? cacheControl : "") {}
+
+    AsyncStaticWebHandler& setDefaultFile(const char* filename) {
+        _defaultFile = filename ? filename : "";
+        return *this;
+    }
+
+    bool canHandle(AsyncWebServerRequest* request) override {
+        return request->method() == HTTP_GET && request->url().startsWith(_uri) && _fs.exists(filePath(request));
+    }
+    void handleRequest(AsyncWebServerRequest* request) override {
+        AsyncWebServerResponse* response = request->beginResponse(_fs, filePath(request));
+        if (_cacheControl.length() > 0) response->addHeader("Cache-Control", _cacheControl);
+        request->send(response);
+    }
+
+private:
+    String filePath(AsyncWebServerRequest* request) const {
+        String path = _path + request->url().substring(_uri.length());
+        if (path.endsWith("/")) path += _defaultFile;
+        return path;
+    }
+
+    String _uri;
+    fs::FS& _fs;
+    String _path;
+    String _cacheControl;
+    String _defaultFile;
+};
+
+// Telemetry stream, no client ever connects on the host
+class AsyncWebSocket : public AsyncWebHandler {
+public:
+    explicit AsyncWebSocket(const String& url) : _url(url) {}
+
+    void setAuthentication(const char* username, const char* password) {
+        _username = username;
+        _password = password;
+    }
+    void cleanupClients(uint16_t maxClients = 8) { (void)maxClients; }
+    size_t count() const { return 0; }
+    bool availableForWriteAll() { return true; }
+    void binaryAll(const uint8_t* data, size_t length) {
+        (void)data;
+        (void)length;
+    }
+    void textAll(const String& text) { (void)text; }
+
+    bool canHandle(AsyncWebServerRequest* request) override { return request->url() == _url; }
+    void handleRequest(AsyncWebServerRequest* request) override { request->send(400, "text/plain", "WebSocket only"); }
+
+private:
+    String _url;
+    String _username;
+    String _password;
+};
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) : _port(port) {}
+    ~AsyncWebServer() { end(); }
+    AsyncWebServer(const AsyncWebServer&) = delete;
+    AsyncWebServer& operator=(const AsyncWebServer&) = delete;
+
+    void begin() { listening()[_port] = this; }
+    void end() {
+        auto it = listening().find(_port);
+        if (it != listening().end() && it->second == this) listening().erase(it);
+    }
+    void reset() {
+        _handlers.clear();
+        _notFound = nullptr;
+    }
+
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload = nullptr) {
+        AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler(uri, method, onRequest, onUpload);
+        _handlers.emplace_back(handler, true);
+        return *handler;
+    }
+    AsyncStaticWebHandler& serveStatic(const char* uri, fs::FS& fs, const char* path, const char* cacheControl = nullptr) {
+        AsyncStaticWebHandler* handler = new AsyncStaticWebHandler(uri, fs, path, cacheControl);
+        _handlers.emplace_back(handler, true);
+        return *handler;
+    }
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler) {
+        _handlers.emplace_back(handler, false);
+        return *handler;
+    }
+    void onNotFound(ArRequestHandlerFunction fn) { _notFound = fn; }
+
+    // Hands a request to the first matching handler of the server started
+    // on the port, false when no server runs there
+    static bool dispatch(uint16_t port, AsyncWebServerRequest& request) {
+        auto it = listening().find(port);
+        if (it == listening().end()) return false;
+        it->second->handle(&request);
+        return true;
+    }
+
+private:
+    struct Entry {
+        Entry(AsyncWebHandler* handler, bool owned) : handler(handler), owned(owned) {}
+        Entry(Entry&& other) noexcept : handler(other.handler), owned(other.owned) { other.owned = false; }
+        ~Entry() {
+            if (owned) delete handler;
+        }
+        AsyncWebHandler* handler;
+        bool owned;
+    };
+
+    static std::map<uint16_t, AsyncWebServer*>& listening() {
+        static std::map<uint16_t, AsyncWebServer*> servers;
+        return servers;
+    }
+
+    void handle(AsyncWebServerRequest* request) {
+        for (Entry& entry : _handlers) {
+            if (entry.handler->canHandle(request)) {
+                entry.handler->handleRequest(request);
+                return;
+            }
+        }
+        if (_notFound) {
+            _notFound(request);
+        } else {
+            request->send(404);
+        }
+    }
+
+    uint16_t _port;
+    std::vector<Entry> _handlers;
+    ArRequestHandlerFunction _notFound;
+};
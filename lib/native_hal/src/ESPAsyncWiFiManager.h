@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for the WiFi setup portal. Nobody can join it on the host,
+// so the portal always times out without new credentials.
+
+#include "DNSServer.h"
+#include "ESPAsyncWebServer.h"
+
+class AsyncWiFiManager {
+public:
+    AsyncWiFiManager(AsyncWebServer* server, DNSServer* dns) {
+        (void)server;
+        (void)dns;
+    }
+    void setConfigPortalTimeout(unsigned long seconds) { (void)seconds; }
+    bool startConfigPortal(const char* apName, const char* apPassword = nullptr) {
+        (void)apName;
+        (void)apPassword;
+        return false;
+    }
+    bool autoConnect(const char* apName, const char* apPassword = nullptr) { return startConfigPortal(apName, apPassword); }
+};
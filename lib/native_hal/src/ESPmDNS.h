@@ -0,0 +1,19 @@
+#pragma once
+
+// Host stand-in for the mDNS responder, announces nothing
+
+#include <cstdint>
+
+class MDNSResponder {
+public:
+    bool begin(const char* hostName) { return hostName && hostName[0]; }
+    void end() {}
+    bool addService(const char* service, const char* protocol, uint16_t port) {
+        (void)service;
+        (void)protocol;
+        (void)port;
+        return true;
+    }
+};
+
+extern MDNSResponder MDNS;
@@ -0,0 +1,15 @@
+#pragma once
+
+// Host stand-in for the chip object, restarts are counted by NativeHal
+
+#include <cstdint>
+#include "native_hal.h"
+
+class EspClass {
+public:
+    // Returns on the host, the caller carries on
+    void restart() { NativeHal::recordRestart(); }
+    uint32_t getFreeHeap() const { return 200 * 1024; }
+};
+
+extern EspClass ESP;
@@ -0,0 +1,176 @@
+#pragma once
+
+// Host stand-in for the Arduino file system API on a host directory, see
+// NativeHal::setFilesystemRoot(). A file is read whole when it is opened and
+// written back when the last copy of a written File is closed.
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "WString.h"
+#include "native_hal.h"
+
+namespace fs {
+
+class File {
+public:
+    File() {}
+
+    explicit operator bool() const { return entry != nullptr; }
+
+    size_t size() const { return entry ? entry->content.size() : 0; }
+    const char* name() const { return entry ? entry->name.c_str() : ""; }
+    const char* path() const { return entry ? entry->path.c_str() : ""; }
+    bool isDirectory() const { return entry && entry->directory; }
+
+    int available() const { return entry ? static_cast<int>(entry->content.size() - entry->position) : 0; }
+    int read() {
+        if (!available()) return -1;
+        return static_cast<uint8_t>(entry->content[entry->position++]);
+    }
+    int peek() const { return available() ? static_cast<uint8_t>(entry->content[entry->position]) : -1; }
+    size_t read(uint8_t* buffer, size_t length) {
+        size_t count = std::min(length, static_cast<size_t>(available()));
+        if (count > 0) {
+            memcpy(buffer, entry->content.data() + entry->position, count);
+            entry->position += count;
+        }
+        return count;
+    }
+    size_t readBytes(char* buffer, size_t length) { return read(reinterpret_cast<uint8_t*>(buffer), length); }
+    String readString() {
+        if (!available()) return String();
+        String text(entry->content.substr(entry->position));
+        entry->position = entry->content.size();
+        return text;
+    }
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t length) {
+        if (!entry || !entry->writable) return 0;
+        entry->content.append(reinterpret_cast<const char*>(buffer), length);
+        entry->dirty = true;
+        return length;
+    }
+    size_t print(const char* text) { return write(reinterpret_cast<const uint8_t*>(text), strlen(text)); }
+    size_t print(const String& text) { return print(text.c_str()); }
+    size_t println(const String& text) { return print(text) + print("\n"); }
+    void flush() {
+        if (entry) entry->save();
+    }
+
+    void close() {
+        if (entry) entry->save();
+        entry.reset();
+    }
+
+    // Directory entries in name order, a closed File after the last one
+    File openNextFile() {
+        if (!isDirectory() || entry->position >= entry->children.size()) return File();
+        return openEntry(entry->path + (entry->path == "/" ? "" : "/") + entry->children[entry->position++], "r");
+    }
+
+    static File openEntry(const std::string& path, const char* mode) {
+        const std::string& root = NativeHal::getFilesystemRoot();
+        if (root.empty() || path.empty() || path[0] != '/') return File();
+
+        std::shared_ptr<Entry> entry(new Entry);
+        entry->path = path;
+        entry->hostPath = root + path;
+        entry->name = path.substr(path.find_last_of('/') + 1);
+        entry->writable = mode[0] == 'w' || mode[0] == 'a';
+
+        struct stat info;
+        bool exists = stat(entry->hostPath.c_str(), &info) == 0;
+        if (exists && S_ISDIR(info.st_mode)) {
+            if (entry->writable) return File();
+            entry->directory = true;
+            DIR* dir = opendir(entry->hostPath.c_str());
+            if (!dir) return File();
+            while (struct dirent* child = readdir(dir)) {
+                if (child->d_name[0] != '.') entry->children.push_back(child->d_name);
+            }
+            closedir(dir);
+            std::sort(entry->children.begin(), entry->children.end());
+        } else if (mode[0] == 'w') {
+            entry->dirty = true;
+        } else if (exists) {
+            FILE* file = fopen(entry->hostPath.c_str(), "rb");
+            if (!file) return File();
+            char buffer[4096];
+            size_t count;
+            while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                entry->content.append(buffer, count);
+            }
+            fclose(file);
+            if (mode[0] == 'a') entry->position = entry->content.size();
+        } else if (mode[0] != 'a') {
+            return File();
+        }
+
+        File file;
+        file.entry = entry;
+        return file;
+    }
+
+private:
+    struct Entry {
+        std::string path;
+        std::string hostPath;
+        std::string name;
+        std::string content;
+        std::vector<std::string> children;
+        size_t position = 0;
+        bool directory = false;
+        bool writable = false;
+        bool dirty = false;
+
+        ~Entry() { save(); }
+
+        void save() {
+            if (!dirty) return;
+            dirty = false;
+            FILE* file = fopen(hostPath.c_str(), "wb");
+            if (!file) return;
+            fwrite(content.data(), 1, content.size(), file);
+            fclose(file);
+        }
+    };
+
+    std::shared_ptr<Entry> entry;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = "r") { return File::openEntry(path ? path : "", mode); }
+    File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+
+    bool exists(const char* path) const {
+        struct stat info;
+        const std::string& root = NativeHal::getFilesystemRoot();
+        return !root.empty() && path && stat((root + path).c_str(), &info) == 0;
+    }
+    bool exists(const String& path) const { return exists(path.c_str()); }
+    bool remove(const char* path) {
+        const std::string& root = NativeHal::getFilesystemRoot();
+        return !root.empty() && path && ::remove((root + path).c_str()) == 0;
+    }
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool mkdir(const char* path) {
+        const std::string& root = NativeHal::getFilesystemRoot();
+        return !root.empty() && path && (::mkdir((root + path).c_str(), 0755) == 0 || errno == EEXIST);
+    }
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
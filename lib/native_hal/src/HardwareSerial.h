@@ -0,0 +1,25 @@
+#pragma once
+
+// Host stand-in for the UART console, written to stdout
+
+#include <cstdarg>
+#include <cstdio>
+#include "WString.h"
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t print(const char* text) { return fputs(text, stdout) >= 0 ? strlen(text) : 0; }
+    size_t print(const String& text) { return print(text.c_str()); }
+    size_t println(const char* text = "") { return print(text) + print("\n"); }
+    size_t println(const String& text) { return println(text.c_str()); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int written = vprintf(format, args);
+        va_end(args);
+        return written > 0 ? static_cast<size_t>(written) : 0;
+    }
+};
+
+extern HardwareSerial Serial;
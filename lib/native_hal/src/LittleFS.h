@@ -0,0 +1,25 @@
+#pragma once
+
+// Host stand-in for LittleFS, mounted on NativeHal's file system root
+
+#include <sys/stat.h>
+#include "FS.h"
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+    // Fails while no root is set, formatting creates the directory
+    bool begin(bool formatOnFail = false) {
+        const std::string& root = NativeHal::getFilesystemRoot();
+        struct stat info;
+        if (root.empty()) return false;
+        if (stat(root.c_str(), &info) == 0) return S_ISDIR(info.st_mode);
+        return formatOnFail && ::mkdir(root.c_str(), 0755) == 0;
+    }
+    void end() {}
+};
+
+}  // namespace fs
+
+extern fs::LittleFSFS LittleFS;
@@ -0,0 +1,82 @@
+#pragma once
+
+// Host stand-in for the NVS key-value store. Namespaces live in memory for
+// the life of the process, so a second Preferences sees what the first one
+// wrote, like after a restart on the device.
+
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include "WString.h"
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        if (!name || !name[0]) return false;
+        space = &storage()[name];
+        this->readOnly = readOnly;
+        return true;
+    }
+    void end() { space = nullptr; }
+
+    bool clear() {
+        if (!space || readOnly) return false;
+        space->clear();
+        return true;
+    }
+    bool remove(const char* key) { return space && !readOnly && space->erase(key) > 0; }
+    bool isKey(const char* key) const { return space && space->count(key) > 0; }
+
+    size_t putString(const char* key, const char* value) { return put(key, value ? value : ""); }
+    size_t putString(const char* key, const String& value) { return put(key, value.c_str()); }
+    size_t putInt(const char* key, int32_t value) { return put(key, std::to_string(value)) ? sizeof(value) : 0; }
+    size_t putUInt(const char* key, uint32_t value) { return put(key, std::to_string(value)) ? sizeof(value) : 0; }
+    size_t putULong(const char* key, uint32_t value) { return putUInt(key, value); }
+    size_t putFloat(const char* key, float value) { return put(key, std::to_string(value)) ? sizeof(value) : 0; }
+    size_t putBool(const char* key, bool value) { return put(key, value ? "1" : "0") ? 1 : 0; }
+
+    String getString(const char* key, const String& fallback = String()) const {
+        const std::string* value = find(key);
+        return value ? String(*value) : fallback;
+    }
+    int32_t getInt(const char* key, int32_t fallback = 0) const {
+        const std::string* value = find(key);
+        return value ? static_cast<int32_t>(strtol(value->c_str(), nullptr, 10)) : fallback;
+    }
+    uint32_t getUInt(const char* key, uint32_t fallback = 0) const {
+        const std::string* value = find(key);
+        return value ? static_cast<uint32_t>(strtoul(value->c_str(), nullptr, 10)) : fallback;
+    }
+    uint32_t getULong(const char* key, uint32_t fallback = 0) const { return getUInt(key, fallback); }
+    float getFloat(const char* key, float fallback = 0.0f) const {
+        const std::string* value = find(key);
+        return value ? strtof(value->c_str(), nullptr) : fallback;
+    }
+    bool getBool(const char* key, bool fallback = false) const {
+        const std::string* value = find(key);
+        return value ? *value == "1" : fallback;
+    }
+
+private:
+    typedef std::map<std::string, std::string> Namespace;
+
+    static std::map<std::string, Namespace>& storage() {
+        static std::map<std::string, Namespace> namespaces;
+        return namespaces;
+    }
+
+    size_t put(const char* key, const std::string& value) {
+        if (!space || readOnly || !key) return 0;
+        (*space)[key] = value;
+        return value.size() + 1;
+    }
+    const std::string* find(const char* key) const {
+        if (!space || !key) return nullptr;
+        auto it = space->find(key);
+        return it == space->end() ? nullptr : &it->second;
+    }
+
+    Namespace* space = nullptr;
+    bool readOnly = false;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+// Host stand-in for the MQTT client, connected to the in-process broker of
+// NativeHal. Incoming messages are not delivered.
+
+#include <cstdint>
+#include <functional>
+#include "WiFiClient.h"
+#include "native_hal.h"
+
+class PubSubClient {
+public:
+    typedef std::function<void(char*, uint8_t*, unsigned int)> Callback;
+
+    PubSubClient() {}
+    explicit PubSubClient(WiFiClient& client) { (void)client; }
+
+    PubSubClient& setServer(const char* host, uint16_t port) {
+        (void)host;
+        (void)port;
+        return *this;
+    }
+    PubSubClient& setCallback(Callback callback) {
+        this->callback = callback;
+        return *this;
+    }
+    bool setBufferSize(uint16_t size) { return size > 0; }
+    PubSubClient& setSocketTimeout(uint16_t timeout) {
+        (void)timeout;
+        return *this;
+    }
+
+    bool connect(const char* id) {
+        (void)id;
+        session = NativeHal::isMqttBrokerRunning();
+        generation = NativeHal::getMqttBrokerGeneration();
+        return session;
+    }
+    bool connect(const char* id, const char* user, const char* pass) {
+        (void)user;
+        (void)pass;
+        return connect(id);
+    }
+    void disconnect() { session = false; }
+    bool connected() {
+        if (!NativeHal::isMqttBrokerRunning() || generation != NativeHal::getMqttBrokerGeneration()) {
+            session = false;
+        }
+        return session;
+    }
+    int state() { return connected() ? 0 : -2; }  // MQTT_CONNECTED or MQTT_CONNECT_FAILED
+
+    bool loop() { return connected(); }
+    bool subscribe(const char* topic) {
+        (void)topic;
+        return connected();
+    }
+    bool publish(const char* topic, const char* payload, bool retained = false) {
+        return connected() && NativeHal::acceptMqttPublish({topic, payload, retained});
+    }
+
+private:
+    Callback callback;
+    bool session = false;
+    uint32_t generation = 0;
+};
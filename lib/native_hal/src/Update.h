@@ -0,0 +1,38 @@
+#pragma once
+
+// Host stand-in for the OTA updater, counts the image bytes and flashes nothing
+
+#include <cstddef>
+#include <cstdint>
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+class UpdateClass {
+public:
+    bool begin(size_t size = UPDATE_SIZE_UNKNOWN) {
+        (void)size;
+        written = 0;
+        running = true;
+        return true;
+    }
+    size_t write(uint8_t* data, size_t length) {
+        (void)data;
+        if (!running) return 0;
+        written += length;
+        return length;
+    }
+    bool end(bool evenIfRemaining = false) {
+        (void)evenIfRemaining;
+        bool ok = running && written > 0;
+        running = false;
+        return ok;
+    }
+    bool hasError() const { return false; }
+    size_t progress() const { return written; }
+
+private:
+    size_t written = 0;
+    bool running = false;
+};
+
+extern UpdateClass Update;
@@ -0,0 +1,82 @@
+#pragma once
+
+// Host stand-in for the Arduino String, backed by std::string
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class String {
+public:
+    String(const char* text = "") : text(text ? text : "") {}
+    String(const std::string& text) : text(text) {}
+    explicit String(char c) : text(1, c) {}
+    explicit String(int value) : text(std::to_string(value)) {}
+    explicit String(unsigned int value) : text(std::to_string(value)) {}
+    explicit String(long value) : text(std::to_string(value)) {}
+    explicit String(unsigned long value) : text(std::to_string(value)) {}
+    explicit String(double value, unsigned char decimals = 2) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+        text = buffer;
+    }
+
+    const char* c_str() const { return text.c_str(); }
+    unsigned int length() const { return static_cast<unsigned int>(text.size()); }
+    void reserve(unsigned int size) { text.reserve(size); }
+
+    String& operator+=(const String& other) { text += other.text; return *this; }
+    String& operator+=(const char* other) { text += other ? other : ""; return *this; }
+    String& operator+=(char c) { text += c; return *this; }
+    bool concat(const String& other) { text += other.text; return true; }
+    bool concat(char c) { text += c; return true; }
+    bool concat(const char* other) { text += other ? other : ""; return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.text + b.text); }
+    friend String operator+(const String& a, const char* b) { return String(a.text + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String((a ? a : "") + b.text); }
+    bool operator==(const String& other) const { return text == other.text; }
+    bool operator==(const char* other) const { return text == (other ? other : ""); }
+    bool operator!=(const String& other) const { return text != other.text; }
+    char operator[](unsigned int index) const { return index < text.size() ? text[index] : '\0'; }
+    char& operator[](unsigned int index) { return text[index]; }
+
+    bool equals(const String& other) const { return text == other.text; }
+    bool startsWith(const String& prefix) const { return text.compare(0, prefix.text.size(), prefix.text) == 0; }
+    bool endsWith(const String& suffix) const {
+        return text.size() >= suffix.text.size() &&
+               text.compare(text.size() - suffix.text.size(), suffix.text.size(), suffix.text) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t found = text.find(c, from);
+        return found == std::string::npos ? -1 : static_cast<int>(found);
+    }
+    int indexOf(const String& other, unsigned int from = 0) const {
+        size_t found = text.find(other.text, from);
+        return found == std::string::npos ? -1 : static_cast<int>(found);
+    }
+    String substring(unsigned int from) const { return from < text.size() ? String(text.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (to > text.size()) to = static_cast<unsigned int>(text.size());
+        return from < to ? String(text.substr(from, to - from)) : String();
+    }
+    void replace(const String& find, const String& replacement) {
+        if (find.text.empty()) return;
+        for (size_t at = text.find(find.text); at != std::string::npos;
+             at = text.find(find.text, at + replacement.text.size())) {
+            text.replace(at, find.text.size(), replacement.text);
+        }
+    }
+    float toFloat() const { return strtof(text.c_str(), nullptr); }
+    long toInt() const { return strtol(text.c_str(), nullptr, 10); }
+
+private:
+    std::string text;
+};
+
+// Result type of String concatenation in the Arduino core, named by ArduinoJson
+class StringSumHelper : public String {
+public:
+    using String::String;
+};
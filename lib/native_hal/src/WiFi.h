@@ -0,0 +1,44 @@
+#pragma once
+
+// Host stand-in for the WiFi station, always connected
+
+#include "IPAddress.h"
+#include "WString.h"
+#include "WiFiClient.h"
+
+enum wl_status_t {
+    WL_IDLE_STATUS = 0,
+    WL_CONNECTED = 3,
+    WL_DISCONNECTED = 6,
+};
+
+enum wifi_mode_t {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3,
+};
+
+class WiFiClass {
+public:
+    wl_status_t status() const { return WL_CONNECTED; }
+    bool isConnected() const { return true; }
+    bool mode(wifi_mode_t mode) {
+        (void)mode;
+        return true;
+    }
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr) {
+        this->ssid = ssid ? ssid : "";
+        this->passphrase = passphrase ? passphrase : "";
+        return WL_CONNECTED;
+    }
+    String SSID() const { return ssid; }
+    String psk() const { return passphrase; }
+    IPAddress localIP() const { return IPAddress(127, 0, 0, 1); }
+
+private:
+    String ssid;
+    String passphrase;
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,6 @@
+#pragma once
+
+// Host stand-in for the network client handed to PubSubClient
+
+class WiFiClient {
+};
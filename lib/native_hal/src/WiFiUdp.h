@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for the UDP socket, joins every multicast group and sends
+// nothing. The KNX stand-in exchanges telegrams through NativeHal instead.
+
+#include <cstdint>
+#include "IPAddress.h"
+
+class WiFiUDP {
+public:
+    uint8_t begin(uint16_t port) {
+        (void)port;
+        return 1;
+    }
+    uint8_t beginMulticast(IPAddress address, uint16_t port) {
+        (void)address;
+        (void)port;
+        return 1;
+    }
+    void stop() {}
+    int parsePacket() { return 0; }
+};
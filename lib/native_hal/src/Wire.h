@@ -0,0 +1,14 @@
+#pragma once
+
+// Host stand-in for the I2C bus, the simulated BME280 does not use it
+
+class TwoWire {
+public:
+    bool begin(int sda = -1, int scl = -1) {
+        (void)sda;
+        (void)scl;
+        return true;
+    }
+};
+
+extern TwoWire Wire;
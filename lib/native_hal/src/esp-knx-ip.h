@@ -0,0 +1,160 @@
+#pragma once
+
+// Host stand-in for the KNX library, connected to the KNX/IP bus of
+// NativeHal. Sent telegrams are recorded there, injected ones are handed to
+// the callbacks assigned to their group address from loop().
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "WString.h"
+#include "WiFi.h"
+#include "WiFiUdp.h"
+#include "native_hal.h"
+
+class AsyncWebServer;
+
+#define MAX_CALLBACKS 10
+#define MAX_CALLBACK_ASSIGNMENTS 10
+
+typedef union __address {
+    uint16_t value;
+    struct {
+        uint8_t high;
+        uint8_t low;
+    } bytes;
+    struct __attribute__((packed)) {
+        uint8_t line : 3;
+        uint8_t area : 5;
+        uint8_t member;
+    } ga;
+    struct __attribute__((packed)) {
+        uint8_t line : 4;
+        uint8_t area : 4;
+        uint8_t member;
+    } pa;
+    uint8_t array[2];
+} address_t;
+
+typedef enum __knx_command_type {
+    KNX_CT_READ = 0x00,
+    KNX_CT_ANSWER = 0x01,
+    KNX_CT_WRITE = 0x02,
+} knx_command_type_t;
+
+typedef struct __message {
+    knx_command_type_t ct;
+    address_t received_on;
+    uint8_t data_len;
+    uint8_t* data;
+} message_t;
+
+typedef uint8_t callback_id_t;
+typedef uint8_t callback_assignment_id_t;
+typedef void (*callback_fptr_t)(message_t const& msg, void* arg);
+
+class ESPKNXIP {
+public:
+    void start(AsyncWebServer* server = nullptr) { (void)server; }
+
+    // Delivers every telegram injected into the bus since the last call
+    void loop() {
+        NativeHal::KnxTelegram telegram;
+        while (NativeHal::takeInjectedKnxTelegram(telegram)) {
+            std::vector<uint8_t> data(1, 0);
+            data.insert(data.end(), telegram.data.begin(), telegram.data.end());
+            message_t message;
+            message.ct = static_cast<knx_command_type_t>(telegram.command);
+            message.received_on.bytes.high = static_cast<uint8_t>(telegram.address >> 8);
+            message.received_on.bytes.low = static_cast<uint8_t>(telegram.address & 0xFF);
+            message.data_len = static_cast<uint8_t>(data.size());
+            message.data = data.data();
+            for (const Assignment& assignment : assignments) {
+                if (assignment.address.value == message.received_on.value && assignment.callback < callbacks.size()) {
+                    const Callback& callback = callbacks[assignment.callback];
+                    callback.function(message, callback.arg);
+                }
+            }
+        }
+    }
+
+    callback_id_t callback_register(String name, callback_fptr_t function, void* arg = nullptr) {
+        (void)name;
+        if (callbacks.size() >= MAX_CALLBACKS) {
+            return static_cast<callback_id_t>(-1);
+        }
+        callbacks.push_back({function, arg});
+        return static_cast<callback_id_t>(callbacks.size() - 1);
+    }
+    callback_assignment_id_t callback_assign(callback_id_t id, address_t address) {
+        if (id >= callbacks.size() || assignments.size() >= MAX_CALLBACK_ASSIGNMENTS) {
+            return static_cast<callback_assignment_id_t>(-1);
+        }
+        assignments.push_back({address, id});
+        return static_cast<callback_assignment_id_t>(assignments.size() - 1);
+    }
+
+    void physical_address_set(address_t address) { physicalAddress = address; }
+    address_t physical_address_get() { return physicalAddress; }
+
+    static address_t GA_to_address(uint8_t area, uint8_t line, uint8_t member) {
+        address_t address;
+        address.ga.area = area;
+        address.ga.line = line;
+        address.ga.member = member;
+        return address;
+    }
+    static address_t PA_to_address(uint8_t area, uint8_t line, uint8_t member) {
+        address_t address;
+        address.pa.area = area;
+        address.pa.line = line;
+        address.pa.member = member;
+        return address;
+    }
+
+    void write_1bit(address_t const& receiver, uint8_t bit) { send(receiver, {static_cast<uint8_t>(bit ? 1 : 0)}); }
+    void write_2byte_uint(address_t const& receiver, uint16_t value) {
+        send(receiver, {static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value & 0xFF)});
+    }
+    void write_2byte_float(address_t const& receiver, float value) { write_2byte_uint(receiver, encodeFloat(value)); }
+
+    // DPT 9 in data[1] and data[2], data[0] holds the APCI bits
+    float data_to_2byte_float(uint8_t* data) {
+        uint16_t raw = static_cast<uint16_t>(data[1] << 8 | data[2]);
+        int32_t mantissa = raw & 0x07FF;
+        if (raw & 0x8000) {
+            mantissa -= 0x0800;
+        }
+        int exponent = (raw >> 11) & 0x0F;
+        return 0.01f * static_cast<float>(mantissa * (1 << exponent));
+    }
+
+private:
+    struct Callback {
+        callback_fptr_t function;
+        void* arg;
+    };
+    struct Assignment {
+        address_t address;
+        callback_id_t callback;
+    };
+
+    static uint16_t encodeFloat(float value) {
+        int32_t mantissa = static_cast<int32_t>(lroundf(value * 100.0f));
+        int exponent = 0;
+        while ((mantissa < -2048 || mantissa > 2047) && exponent < 15) {
+            mantissa /= 2;
+            exponent++;
+        }
+        return static_cast<uint16_t>((mantissa < 0 ? 0x8000 : 0) | exponent << 11 | (mantissa & 0x07FF));
+    }
+
+    void send(address_t const& receiver, std::vector<uint8_t> data) {
+        uint16_t address = static_cast<uint16_t>(receiver.bytes.high << 8 | receiver.bytes.low);
+        NativeHal::acceptKnxTelegram({address, KNX_CT_WRITE, data});
+    }
+
+    std::vector<Callback> callbacks;
+    std::vector<Assignment> assignments;
+    address_t physicalAddress = {0};
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdio>
+
+unsigned long millis();
+
+// Host stand-in for the ESP-IDF log macros, timestamps are simulated milliseconds
+#define NATIVE_LOG(level, tag, format, ...) \
+    printf("[%8lu][%s][%s] " format "\n", millis(), level, tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) NATIVE_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) NATIVE_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) NATIVE_LOG("I", tag, format, ##__VA_ARGS__)
+
+#ifdef NATIVE_LOG_DEBUG
+#define ESP_LOGD(tag, format, ...) NATIVE_LOG("D", tag, format, ##__VA_ARGS__)
+#else
+#define ESP_LOGD(tag, format, ...) do {} while (0)
+#endif
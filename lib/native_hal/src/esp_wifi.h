@@ -0,0 +1,3 @@
+#pragma once
+
+// Host stand-in for the ESP-IDF WiFi driver header, nothing of it is used
@@ -0,0 +1,261 @@
+#include "Arduino.h"
+#include "ESPmDNS.h"
+#include "LittleFS.h"
+#include "Update.h"
+#include "WiFi.h"
+#include "Wire.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+TwoWire Wire;
+WiFiClass WiFi;
+HardwareSerial Serial;
+EspClass ESP;
+fs::LittleFSFS LittleFS;
+MDNSResponder MDNS;
+UpdateClass Update;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point startTime = Clock::now();
+float timeScale = 1.0f;
+
+std::mutex roomMutex;
+NativeHal::RoomModel room = {18.0f, 5.0f, 25.0f, 3600.0f, 45.0f, 1013.25f};
+NativeHal::FlowModel circuit = {false, 60.0f, 40.0f, 120.0f, 18.0f};
+float heatingPower = 0.0f;
+std::atomic<bool> sensorFault(false);
+unsigned long lastRoomUpdate = 0;
+
+bool brokerRunning = true;
+uint32_t brokerGeneration = 0;
+int publishLimit = -1;
+std::vector<NativeHal::MqttMessage> brokerMessages;
+
+std::mutex knxMutex;
+std::vector<NativeHal::KnxTelegram> knxSent;
+std::deque<NativeHal::KnxTelegram> knxInjected;
+
+std::string filesystemRoot;
+std::atomic<uint32_t> restarts(0);
+
+// Advance the room model to the current simulated time
+void advanceRoom() {
+    unsigned long now = millis();
+    float dt = (now - lastRoomUpdate) / 1000.0f;
+    lastRoomUpdate = now;
+
+    // Integrate in steps well below the time constant to stay stable
+    while (dt > 0.0f) {
+        float step = dt < 1.0f ? dt : 1.0f;
+        float power = heatingPower;
+        if (circuit.enabled) {
+            float flowTarget = room.temperature + heatingPower / 100.0f * (circuit.supply - room.temperature);
+            circuit.flow += (flowTarget - circuit.flow) * step / circuit.timeConstant;
+            power = 100.0f * (circuit.flow - room.temperature) / circuit.designRise;
+            power = power > 0.0f ? power : 0.0f;
+        }
+        float target = room.outdoor + room.heaterGain * power / 100.0f;
+        room.temperature += (target - room.temperature) * step / room.timeConstant;
+        dt -= step;
+    }
+}
+
+}  // namespace
+
+unsigned long millis() {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - startTime);
+    return static_cast<unsigned long>(elapsed.count() * timeScale / 1000.0);
+}
+
+unsigned long micros() {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - startTime);
+    return static_cast<unsigned long>(elapsed.count() * timeScale);
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::microseconds(static_cast<long long>(ms * 1000.0 / timeScale)));
+}
+
+long random(long howBig) {
+    return howBig > 0 ? random() % howBig : 0;
+}
+
+long random(long howSmall, long howBig) {
+    return howBig > howSmall ? howSmall + random(howBig - howSmall) : howSmall;
+}
+
+namespace NativeHal {
+
+void setTimeScale(float scale) {
+    // Changing the scale mid-run would make millis() jump, so only set it at startup
+    if (scale > 0.0f) {
+        timeScale = scale;
+    }
+}
+
+float getTimeScale() {
+    return timeScale;
+}
+
+void setRoomModel(const RoomModel& model) {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    advanceRoom();
+    room = model;
+}
+
+RoomModel getRoomModel() {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    advanceRoom();
+    return room;
+}
+
+void setFlowModel(const FlowModel& model) {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    advanceRoom();
+    circuit = model;
+}
+
+FlowModel getFlowModel() {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    advanceRoom();
+    return circuit;
+}
+
+void setSupplyTemperature(float temperature) {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    advanceRoom();
+    circuit.supply = temperature;
+}
+
+void setHeatingPower(float percent) {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    advanceRoom();
+    heatingPower = constrain(percent, 0.0f, 100.0f);
+}
+
+void setOutdoorTemperature(float temperature) {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    advanceRoom();
+    room.outdoor = temperature;
+}
+
+void setSensorFault(bool fault) {
+    sensorFault = fault;
+}
+
+bool hasSensorFault() {
+    return sensorFault;
+}
+
+float getRoomTemperature() {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    advanceRoom();
+    return room.temperature;
+}
+
+float getRoomHumidity() {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    return room.humidity;
+}
+
+float getRoomPressure() {
+    std::lock_guard<std::mutex> lock(roomMutex);
+    return room.pressure;
+}
+
+void setMqttBrokerRunning(bool running) {
+    if (running && !brokerRunning) {
+        brokerGeneration++;
+    }
+    brokerRunning = running;
+}
+
+bool isMqttBrokerRunning() {
+    return brokerRunning;
+}
+
+uint32_t getMqttBrokerGeneration() {
+    return brokerGeneration;
+}
+
+void setMqttPublishLimit(int publishes) {
+    publishLimit = publishes;
+}
+
+bool acceptMqttPublish(const MqttMessage& message) {
+    if (!brokerRunning) {
+        return false;
+    }
+    if (publishLimit == 0) {
+        brokerRunning = false;
+        publishLimit = -1;
+        return false;
+    }
+    if (publishLimit > 0) {
+        publishLimit--;
+    }
+    brokerMessages.push_back(message);
+    return true;
+}
+
+const std::vector<MqttMessage>& getMqttMessages() {
+    return brokerMessages;
+}
+
+void clearMqttMessages() {
+    brokerMessages.clear();
+}
+
+void acceptKnxTelegram(const KnxTelegram& telegram) {
+    std::lock_guard<std::mutex> lock(knxMutex);
+    knxSent.push_back(telegram);
+}
+
+const std::vector<KnxTelegram>& getKnxTelegrams() {
+    return knxSent;
+}
+
+void clearKnxTelegrams() {
+    std::lock_guard<std::mutex> lock(knxMutex);
+    knxSent.clear();
+    knxInjected.clear();
+}
+
+void injectKnxTelegram(const KnxTelegram& telegram) {
+    std::lock_guard<std::mutex> lock(knxMutex);
+    knxInjected.push_back(telegram);
+}
+
+bool takeInjectedKnxTelegram(KnxTelegram& telegram) {
+    std::lock_guard<std::mutex> lock(knxMutex);
+    if (knxInjected.empty()) {
+        return false;
+    }
+    telegram = knxInjected.front();
+    knxInjected.pop_front();
+    return true;
+}
+
+void setFilesystemRoot(const std::string& path) {
+    filesystemRoot = path;
+}
+
+const std::string& getFilesystemRoot() {
+    return filesystemRoot;
+}
+
+void recordRestart() {
+    restarts++;
+}
+
+uint32_t getRestartCount() {
+    return restarts;
+}
+
+}  // namespace NativeHal
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Controls for the host build: simulated clock and a first-order room model
+namespace NativeHal {
+
+constexpr uint8_t BME280_ADDRESS = 0x76;
+
+// Simulated time runs this many times faster than wall-clock time
+void setTimeScale(float scale);
+float getTimeScale();
+
+// Room model: dT/dt = (gain * heating / 100 - (T - outdoor)) / timeConstant
+struct RoomModel {
+    float temperature;      // Current room temperature in C
+    float outdoor;          // Outdoor temperature in C
+    float heaterGain;       // Steady-state rise above outdoor at 100% heating in C
+    float timeConstant;     // Thermal time constant in seconds
+    float humidity;         // Relative humidity in %
+    float pressure;         // Pressure in hPa
+};
+
+// Optional heating circuit between valve and room: the flow approaches
+// room + valve * (supply - room) with its own time constant, and the room
+// receives heating power in proportion to the flow's rise above it
+struct FlowModel {
+    bool enabled;
+    float supply;           // Supply temperature in C
+    float designRise;       // Flow above room that gives 100% heating in K
+    float timeConstant;     // Flow response time constant in seconds
+    float flow;             // Current flow temperature in C
+};
+
+void setRoomModel(const RoomModel& model);
+RoomModel getRoomModel();
+void setFlowModel(const FlowModel& model);
+FlowModel getFlowModel();
+void setHeatingPower(float percent);  // Valve position while the flow model is enabled
+void setOutdoorTemperature(float temperature);
+void setSupplyTemperature(float temperature);
+
+// A faulty sensor is not found and only returns NaN
+void setSensorFault(bool fault);
+bool hasSensorFault();
+
+float getRoomTemperature();
+float getRoomHumidity();
+float getRoomPressure();
+
+// In-process MQTT broker behind the PubSubClient stand-in
+struct MqttMessage {
+    std::string topic;
+    std::string payload;
+    bool retained;
+};
+
+// Stopping the broker ends every session, clients have to connect again
+void setMqttBrokerRunning(bool running);
+bool isMqttBrokerRunning();
+uint32_t getMqttBrokerGeneration();  // Counts the starts, a session belongs to one
+
+// The broker stops by itself after this many more publishes, negative for never
+void setMqttPublishLimit(int publishes);
+
+// False when the broker is down, otherwise the message is recorded
+bool acceptMqttPublish(const MqttMessage& message);
+const std::vector<MqttMessage>& getMqttMessages();
+void clearMqttMessages();
+
+// KNX/IP bus behind the esp-knx-ip stand-in, addresses as main/middle/sub
+// packed like on the wire and data without the APCI bits
+struct KnxTelegram {
+    uint16_t address;
+    uint8_t command;        // KNX_CT_READ, KNX_CT_ANSWER or KNX_CT_WRITE
+    std::vector<uint8_t> data;
+};
+
+constexpr uint16_t knxGroupAddress(uint8_t main, uint8_t middle, uint8_t sub) {
+    return static_cast<uint16_t>((main & 0x1F) << 11 | (middle & 0x07) << 8 | sub);
+}
+
+// Telegrams the device sent
+void acceptKnxTelegram(const KnxTelegram& telegram);
+const std::vector<KnxTelegram>& getKnxTelegrams();
+void clearKnxTelegrams();
+
+// Telegrams from other devices, delivered by the next ESPKNXIP::loop()
+void injectKnxTelegram(const KnxTelegram& telegram);
+bool takeInjectedKnxTelegram(KnxTelegram& telegram);
+
+// LittleFS stand-in: "/" is this host directory, nothing is mounted while
+// it is empty so a test never writes into the project's data/ by accident
+void setFilesystemRoot(const std::string& path);
+const std::string& getFilesystemRoot();
+
+// ESP.restart() returns on the host, callers can check it was asked for
+void recordRestart();
+uint32_t getRestartCount();
+
+}  // namespace NativeHal
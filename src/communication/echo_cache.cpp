@@ -0,0 +1,78 @@
+#include "communication/echo_cache.h"
+#include <math.h>
+
+// Half a DPT 9 step at any magnitude, and at least MQTT's 0.01
+static const float ABSOLUTE_TOLERANCE = 0.01f;
+static const float RELATIVE_TOLERANCE = 1.0f / 1024.0f;
+
+EchoCache::EchoCache()
+    : entries()
+    , next(0)
+    , window(0)
+    , suppressed() {
+}
+
+bool EchoCache::matches(float sent, float received) {
+    return fabsf(sent - received) <= ABSOLUTE_TOLERANCE + fabsf(sent) * RELATIVE_TOLERANCE;
+}
+
+EchoCache::Entry* EchoCache::find(uint8_t zone, CommandType type) {
+    for (uint8_t i = 0; i < ENTRIES; i++) {
+        Entry& entry = entries[i];
+        if (entry.used && entry.type == type && entry.zone == zone) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void EchoCache::record(uint8_t zone, CommandType type, float value, unsigned long now) {
+    if (window == 0) {
+        return;
+    }
+
+    // A newer value of the datapoint takes its entry, whichever protocol it went to
+    Entry* entry = find(zone, type);
+    if (!entry) {
+        entry = &entries[next];
+        next = (next + 1) % ENTRIES;
+    }
+    *entry = {now, value, zone, type, true, true};
+}
+
+void EchoCache::update(uint8_t zone, CommandType type, float value) {
+    Entry* entry = find(zone, type);
+    if (entry && !matches(entry->value, value)) {
+        entry->current = false;
+    }
+}
+
+bool EchoCache::isEcho(CommandSource source, uint8_t zone, CommandType type, float value, unsigned long now) {
+    if (window == 0) {
+        return false;
+    }
+
+    const Entry* entry = find(zone, type);
+    if (!entry || !entry->current || now - entry->time > window || !matches(entry->value, value)) {
+        return false;
+    }
+
+    uint8_t index = static_cast<uint8_t>(source);
+    if (index < SOURCE_COUNT) {
+        suppressed[index]++;
+    }
+    return true;
+}
+
+uint32_t EchoCache::getSuppressedCount(CommandSource source) const {
+    uint8_t index = static_cast<uint8_t>(source);
+    return index < SOURCE_COUNT ? suppressed[index] : 0;
+}
+
+uint32_t EchoCache::getSuppressedCount() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < SOURCE_COUNT; i++) {
+        total += suppressed[i];
+    }
+    return total;
+}
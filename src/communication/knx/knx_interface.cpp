@@ -4,9 +4,11 @@
 #include "communication/knx/knx_interface.h"
 #include "protocol_manager.h"
 #include "thermostat_state.h"
+#include "thermostat_units.h"
 #include <esp_log.h>
 #include <map>
 #include <string>
+#include <vector>
 #include <WiFiUdp.h>
 #include <esp_wifi.h>
 
@@ -15,8 +17,10 @@ static const char* TAG = "KNXInterface";
 // Implementation class definition
 class KNXInterface::Impl {
 public:
-    Impl(ThermostatState* state) : state(state), enabled(false), lastError(ThermostatStatus::OK) {
+    Impl(ThermostatState* state) : state(state), enabled(false), inboundRegistered(false), lastError(ThermostatStatus::OK) {
         memset(lastErrorMessage, 0, sizeof(lastErrorMessage));
+        memset(zoneSetpoint, 0, sizeof(zoneSetpoint));
+        memset(zoneValve, 0, sizeof(zoneValve));
     }
     
     WiFiUDP udp;
@@ -193,7 +197,27 @@ public:
             return false;
         }
         
-        knx.write_2byte_float(it->second, value);
+        writeValue(it->second, value);
+        return true;
+    }
+
+    void writeValue(address_t address, float value) {
+#ifdef THERMOSTAT_FIXED_POINT
+        // State values are already quantized, encode DPT 9 from the integer
+        knx.write_2byte_uint(address, Units::encodeDpt9(Units::roundScaled(value, 100.0f)));
+#else
+        knx.write_2byte_float(address, value);
+#endif
+    }
+
+    // Routes telegrams on an address to a command for a zone
+    bool listen(address_t address, CommandType type, uint8_t zone) {
+        if (knx.callback_assign(inboundCallback, address) == static_cast<callback_assignment_id_t>(-1)) {
+            ESP_LOGE(TAG, "No free KNX callback slot for %d/%d/%d, raise MAX_CALLBACK_ASSIGNMENTS",
+                     address.ga.area, address.ga.line, address.ga.member);
+            return false;
+        }
+        inbound.push_back({address, type, zone});
         return true;
     }
     
@@ -211,6 +235,20 @@ public:
     
     // Expose group addresses to KNXInterface
     std::map<std::string, address_t> groupAddresses;
+
+    // Group addresses received, mapped to a command for a zone
+    struct InboundAddress {
+        address_t address;
+        CommandType type;
+        uint8_t zone;
+    };
+    std::vector<InboundAddress> inbound;
+    callback_id_t inboundCallback;
+    bool inboundRegistered;
+
+    // Outbound addresses of the hub zones by zone index, 0 when unused
+    address_t zoneSetpoint[ThermostatLimits::MAX_ZONES];
+    address_t zoneValve[ThermostatLimits::MAX_ZONES];
     
     // Make KNXInterface a friend class so it can access private members
     friend class KNXInterface;
@@ -226,7 +264,7 @@ private:
 };
 
 // Use raw pointer initialization
-KNXInterface::KNXInterface(ThermostatState* state) : pimpl(new Impl(state)) {}
+KNXInterface::KNXInterface(ThermostatState* state) : pimpl(new Impl(state)), protocolManager(nullptr) {}
 KNXInterface::~KNXInterface() = default;
 
 bool KNXInterface::begin() {
@@ -330,6 +368,30 @@ void KNXInterface::setHeatingStateGA(const KnxGroupAddress& ga) {
     pimpl->setGroupAddress("heating", ga.main, ga.middle, ga.sub);
 }
 
+void KNXInterface::setOutdoorTemperatureGA(const KnxGroupAddress& ga) {
+    setupCallbacks();
+    address_t addr = pimpl->knx.GA_to_address(ga.main, ga.middle, ga.sub);
+    if (pimpl->listen(addr, CommandType::CMD_OUTDOOR_TEMPERATURE, 0)) {
+        ESP_LOGI(TAG, "Listening for outdoor temperature on %d/%d/%d", ga.main, ga.middle, ga.sub);
+    }
+}
+
+void KNXInterface::setFlowTemperatureGA(const KnxGroupAddress& ga) {
+    setupCallbacks();
+    address_t addr = pimpl->knx.GA_to_address(ga.main, ga.middle, ga.sub);
+    if (pimpl->listen(addr, CommandType::CMD_FLOW_TEMPERATURE, 0)) {
+        ESP_LOGI(TAG, "Listening for flow temperature on %d/%d/%d", ga.main, ga.middle, ga.sub);
+    }
+}
+
+void KNXInterface::setComfortTimeGA(const KnxGroupAddress& ga) {
+    setupCallbacks();
+    address_t addr = pimpl->knx.GA_to_address(ga.main, ga.middle, ga.sub);
+    if (pimpl->listen(addr, CommandType::CMD_COMFORT_TIME, 0)) {
+        ESP_LOGI(TAG, "Listening for the comfort time on %d/%d/%d", ga.main, ga.middle, ga.sub);
+    }
+}
+
 bool KNXInterface::sendTemperature(float value) {
     return pimpl->sendValue("temperature", value);
 }
@@ -358,6 +420,73 @@ bool KNXInterface::sendHeatingState(bool isHeating) {
     return pimpl->sendStatus("heating", isHeating);
 }
 
+void KNXInterface::setZoneGroupAddresses(uint8_t zone, const KnxZoneAddresses& addresses) {
+    if (zone == 0 || zone > ThermostatLimits::MAX_ZONES) {
+        ESP_LOGE(TAG, "Invalid zone %u", zone);
+        return;
+    }
+    setupCallbacks();
+
+    auto toAddress = [this](const KnxGroupAddress& ga) {
+        return pimpl->knx.GA_to_address(ga.main, ga.middle, ga.sub);
+    };
+    address_t temperature = toAddress(addresses.temperature);
+    address_t setpoint = toAddress(addresses.setpoint);
+    address_t valve = toAddress(addresses.valve);
+    address_t comfort = toAddress(addresses.comfort);
+
+    if (temperature.value != 0) {
+        pimpl->listen(temperature, CommandType::CMD_SET_TEMPERATURE, zone);
+    }
+    if (setpoint.value != 0) {
+        pimpl->listen(setpoint, CommandType::CMD_SETPOINT, zone);
+    }
+    if (comfort.value != 0) {
+        pimpl->listen(comfort, CommandType::CMD_COMFORT_TIME, zone);
+    }
+    pimpl->zoneSetpoint[zone - 1] = setpoint;
+    pimpl->zoneValve[zone - 1] = valve;
+
+    ESP_LOGI(TAG, "Zone %u: temperature %d/%d/%d, setpoint %d/%d/%d, valve %d/%d/%d", zone,
+             addresses.temperature.main, addresses.temperature.middle, addresses.temperature.sub,
+             addresses.setpoint.main, addresses.setpoint.middle, addresses.setpoint.sub,
+             addresses.valve.main, addresses.valve.middle, addresses.valve.sub);
+}
+
+bool KNXInterface::sendZoneValue(uint8_t zone, CommandType type, float value) {
+    if (zone == 0 || zone > ThermostatLimits::MAX_ZONES) {
+        return false;
+    }
+
+    address_t address;
+    switch (type) {
+        case CommandType::CMD_SETPOINT: address = pimpl->zoneSetpoint[zone - 1]; break;
+        case CommandType::CMD_VALVE: address = pimpl->zoneValve[zone - 1]; break;
+        default: return false;  // Temperatures come from the zone's own sensor
+    }
+    if (address.value == 0) {
+        return false;
+    }
+
+    pimpl->writeValue(address, value);
+    return true;
+}
+
+void KNXInterface::handleTelegram(message_t const& msg, void* arg) {
+    KNXInterface* self = static_cast<KNXInterface*>(arg);
+    if (!self->protocolManager || (msg.ct != KNX_CT_WRITE && msg.ct != KNX_CT_ANSWER) || msg.data_len < 3) {
+        return;
+    }
+
+    // Runs inside knx.loop() on the network task
+    for (const auto& entry : self->pimpl->inbound) {
+        if (entry.address.value == msg.received_on.value) {
+            float value = self->pimpl->knx.data_to_2byte_float(msg.data);
+            self->protocolManager->receiveCommand(CommandSource::SOURCE_KNX, entry.type, value, entry.zone);
+        }
+    }
+}
+
 // Core functionality
 bool KNXInterface::reconnect() {
     return begin();
@@ -402,7 +531,11 @@ bool KNXInterface::validateGroupAddress(const KnxGroupAddress& ga) const {
 }
 
 void KNXInterface::setupCallbacks() {
-    // Simplified implementation
+    // One callback serves every received group address
+    if (!pimpl->inboundRegistered) {
+        pimpl->inboundCallback = pimpl->knx.callback_register("inbound", &KNXInterface::handleTelegram, this);
+        pimpl->inboundRegistered = true;
+    }
 }
 
 void KNXInterface::cleanupCallbacks() {
@@ -0,0 +1,151 @@
+#include "communication/mqtt/mqtt_backlog.h"
+#include <stdio.h>
+#include <esp_log.h>
+
+static const char* TAG = "MqttBacklog";
+
+MqttBacklog::MqttBacklog(const char* path)
+    : path(path)
+    , config(DEFAULT_MQTT_BACKLOG_CONFIG)
+    , stats()
+    , ramHead(0)
+    , ramCount(0)
+    , fileSize(0)
+    , fileRead(0)
+    , readIndex(0)
+    , readCount(0) {
+}
+
+void MqttBacklog::configure(const MqttBacklogConfig& newConfig) {
+    config = newConfig;
+    if (config.replayRate <= 0.0f) config.replayRate = DEFAULT_MQTT_BACKLOG_CONFIG.replayRate;
+}
+
+void MqttBacklog::begin() {
+    FILE* file = fopen(path, "rb");
+    if (file) {
+        fclose(file);
+        ESP_LOGW(TAG, "Discarding backlog of an earlier boot");
+        remove(path);
+    }
+    fileSize = 0;
+    fileRead = 0;
+}
+
+void MqttBacklog::store(const BacklogRecord& record) {
+    if (ramCount == RAM_RECORDS) {
+        spill();
+    }
+    if (ramCount == RAM_RECORDS) {
+        // Nowhere to spill, keep the newest values
+        ramHead = (ramHead + 1) % RAM_RECORDS;
+        ramCount--;
+        stats.dropped++;
+    }
+
+    ram[(ramHead + ramCount) % RAM_RECORDS] = record;
+    ramCount++;
+    stats.stored++;
+}
+
+void MqttBacklog::spill() {
+    uint32_t bytes = ramCount * sizeof(BacklogRecord);
+    if (fileSize + bytes > config.maxFileSize) {
+        return;
+    }
+
+    FILE* file = fopen(path, "ab");
+    if (!file) {
+        ESP_LOGE(TAG, "Cannot open %s", path);
+        return;
+    }
+
+    // The ring wraps at most once, so two writes append it in order
+    size_t first = ramHead + ramCount <= RAM_RECORDS ? ramCount : RAM_RECORDS - ramHead;
+    size_t written = fwrite(&ram[ramHead], sizeof(BacklogRecord), first, file);
+    if (written == first && first < ramCount) {
+        written += fwrite(&ram[0], sizeof(BacklogRecord), ramCount - first, file);
+    }
+    fclose(file);
+
+    // A short write leaves a partial segment, its records count as lost
+    fileSize += written * sizeof(BacklogRecord);
+    stats.spilled += written;
+    stats.dropped += ramCount - written;
+    if (written != ramCount) {
+        ESP_LOGE(TAG, "Short write to %s, %u values lost", path, static_cast<unsigned>(ramCount - written));
+    }
+    ramHead = 0;
+    ramCount = 0;
+}
+
+bool MqttBacklog::fill() {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        ESP_LOGE(TAG, "Cannot read %s, %u values lost", path,
+                 static_cast<unsigned>((fileSize - fileRead) / sizeof(BacklogRecord)));
+        stats.dropped += (fileSize - fileRead) / sizeof(BacklogRecord);
+        fileSize = 0;
+        fileRead = 0;
+        return false;
+    }
+
+    size_t wanted = (fileSize - fileRead) / sizeof(BacklogRecord);
+    if (wanted > READ_RECORDS) wanted = READ_RECORDS;
+    readCount = 0;
+    if (fseek(file, fileRead, SEEK_SET) == 0) {
+        readCount = fread(chunk, sizeof(BacklogRecord), wanted, file);
+    }
+    fclose(file);
+    readIndex = 0;
+
+    if (readCount == 0) {
+        stats.dropped += (fileSize - fileRead) / sizeof(BacklogRecord);
+        removeSegment();
+        return false;
+    }
+    fileRead += readCount * sizeof(BacklogRecord);
+    return true;
+}
+
+void MqttBacklog::removeSegment() {
+    remove(path);
+    fileSize = 0;
+    fileRead = 0;
+}
+
+bool MqttBacklog::peek(BacklogRecord& record) {
+    if (readIndex == readCount) {
+        if (fileRead < fileSize) {
+            fill();
+        } else if (fileSize > 0) {
+            removeSegment();
+        }
+    }
+
+    if (readIndex < readCount) {
+        record = chunk[readIndex];
+        return true;
+    }
+    if (ramCount > 0) {
+        record = ram[ramHead];
+        return true;
+    }
+    return false;
+}
+
+void MqttBacklog::pop() {
+    if (readIndex < readCount) {
+        readIndex++;
+    } else if (ramCount > 0) {
+        ramHead = (ramHead + 1) % RAM_RECORDS;
+        ramCount--;
+    } else {
+        return;
+    }
+    stats.replayed++;
+}
+
+size_t MqttBacklog::size() const {
+    return ramCount + (readCount - readIndex) + (fileSize - fileRead) / sizeof(BacklogRecord);
+}
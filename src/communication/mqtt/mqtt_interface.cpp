@@ -1,5 +1,6 @@
 #include "communication/mqtt/mqtt_interface.h"
 #include "thermostat_state.h"
+#include "thermostat_units.h"
 #include "protocol_manager.h"
 #include <ArduinoJson.h>
 #include <PubSubClient.h>
@@ -9,6 +10,34 @@
 
 static const char* TAG = "MQTTInterface";
 
+// Readings are published with two decimals
+static void formatValue(char* buffer, size_t size, float value) {
+#ifdef THERMOSTAT_FIXED_POINT
+    // State values are already quantized, format the integer without float printf
+    Units::formatScaled(buffer, size, Units::roundScaled(value, 100.0f), 2);
+#else
+    snprintf(buffer, size, "%.2f", value);
+#endif
+}
+
+// Payload of a datapoint as on its live topic
+static void formatPayload(CommandType type, float value, char* buffer, size_t size) {
+    switch (type) {
+        case CommandType::CMD_MODE:
+            strlcpy(buffer, getThermostatModeName(static_cast<ThermostatMode>(static_cast<int>(value))), size);
+            break;
+        case CommandType::CMD_HEATING:
+            strlcpy(buffer, value != 0.0f ? "ON" : "OFF", size);
+            break;
+        default:
+            formatValue(buffer, size, value);
+            break;
+    }
+}
+
+// Buffered values live next to the configuration
+static const char* BACKLOG_PATH = "/littlefs/mqtt_backlog.bin";
+
 // Define make_unique for C++11 compatibility
 #if __cplusplus < 201402L
 namespace std {
@@ -54,9 +83,22 @@ public:
     char valveTopic[128] = {0};
     char heatingTopic[128] = {0};
     char statusTopic[128] = {0};
+    char comfortTopic[128] = {0};
+    char outdoorTopic[64] = {0};  // Full topic of an outdoor sensor
+
+    // Topic prefixes of the hub zones by zone index, empty when unused
+    char zonePrefixes[ThermostatLimits::MAX_ZONES][32] = {};
+
+    // Store-and-forward while offline
+    static constexpr size_t DATAPOINTS = (ThermostatLimits::MAX_ZONES + 1) * COMMAND_TYPE_COUNT;
+    MqttBacklog backlog;
+    float offlineValues[DATAPOINTS] = {};        // Newest value per datapoint while offline
+    uint32_t offlineChanged[(DATAPOINTS + 31) / 32] = {};
+    float publishTokens = 0.0f;                  // Publishes replay may still use, live ones always go
+    unsigned long lastRefill = 0;
     
     // Constructor
-    Impl() : client(espClient) {
+    Impl() : client(espClient), backlog(BACKLOG_PATH) {
         client.setBufferSize(512); // Increase buffer size for larger messages
         // Initialize with default values
         enabled = false;
@@ -72,6 +114,7 @@ public:
         strcpy(valveTopic, "valve");
         strcpy(heatingTopic, "heating");
         strcpy(statusTopic, "status");
+        strcpy(comfortTopic, "comfort");
         
         // Initialize client
         client.setCallback([](char* topic, byte* payload, unsigned int length) {
@@ -86,6 +129,36 @@ public:
     
     // Message handler
     void handleMessage(char* topic, byte* payload, unsigned int length);
+
+    // Topic below the prefix of a device or zone datapoint, false if it has none
+    bool datapointTopic(uint8_t zone, CommandType type, char* topic, size_t size) const {
+        if (zone == 0) {
+            const char* name;
+            switch (type) {
+                case CommandType::CMD_SET_TEMPERATURE: name = temperatureTopic; break;
+                case CommandType::CMD_SETPOINT: name = setpointTopic; break;
+                case CommandType::CMD_VALVE: name = valveTopic; break;
+                case CommandType::CMD_MODE: name = modeTopic; break;
+                case CommandType::CMD_HEATING: name = heatingTopic; break;
+                default: return false;
+            }
+            strlcpy(topic, name, size);
+            return true;
+        }
+
+        if (zone > ThermostatLimits::MAX_ZONES || zonePrefixes[zone - 1][0] == '\0') {
+            return false;
+        }
+        const char* name;
+        switch (type) {
+            case CommandType::CMD_SET_TEMPERATURE: name = "temperature"; break;
+            case CommandType::CMD_SETPOINT: name = "setpoint"; break;
+            case CommandType::CMD_VALVE: name = "valve"; break;
+            default: return false;
+        }
+        snprintf(topic, size, "%s%s", zonePrefixes[zone - 1], name);
+        return true;
+    }
 };
 
 // Constructor implementation
@@ -111,6 +184,8 @@ bool MQTTInterface::begin() {
         ESP_LOGI(TAG, "MQTT disabled, not connecting");
         return false;
     }
+
+    pimpl->backlog.begin();
     
     ESP_LOGI(TAG, "Connecting to MQTT broker at %s:%d", pimpl->server, pimpl->port);
     pimpl->client.setServer(pimpl->server, pimpl->port);
@@ -141,7 +216,13 @@ void MQTTInterface::loop() {
     }
     
     // Process MQTT messages
-    pimpl->client.loop();
+    if (!pimpl->client.loop()) {
+        ESP_LOGW(TAG, "Connection to the MQTT broker lost, buffering values");
+        pimpl->connected = false;
+        return;
+    }
+
+    replayBacklog(millis());
 }
 
 bool MQTTInterface::isConnected() const {
@@ -199,6 +280,7 @@ bool MQTTInterface::reconnect() {
         // Subscribe to topics with error handling
         String setpointTopicFull = String(pimpl->topicPrefix) + pimpl->setpointTopic + "/set";
         String modeTopicFull = String(pimpl->topicPrefix) + pimpl->modeTopic + "/set";
+        String comfortTopicFull = String(pimpl->topicPrefix) + pimpl->comfortTopic + "/set";
         
         if (!pimpl->client.subscribe(setpointTopicFull.c_str())) {
             ESP_LOGW(TAG, "Failed to subscribe to %s", setpointTopicFull.c_str());
@@ -207,11 +289,37 @@ bool MQTTInterface::reconnect() {
         if (!pimpl->client.subscribe(modeTopicFull.c_str())) {
             ESP_LOGW(TAG, "Failed to subscribe to %s", modeTopicFull.c_str());
         }
+
+        if (!pimpl->client.subscribe(comfortTopicFull.c_str())) {
+            ESP_LOGW(TAG, "Failed to subscribe to %s", comfortTopicFull.c_str());
+        }
+
+        if (pimpl->outdoorTopic[0] != '\0' && !pimpl->client.subscribe(pimpl->outdoorTopic)) {
+            ESP_LOGW(TAG, "Failed to subscribe to %s", pimpl->outdoorTopic);
+        }
+
+        // Zone temperatures and setpoints
+        for (uint8_t i = 0; i < ThermostatLimits::MAX_ZONES; i++) {
+            if (pimpl->zonePrefixes[i][0] == '\0') {
+                continue;
+            }
+            String zoneTopic = String(pimpl->topicPrefix) + pimpl->zonePrefixes[i] + "+/set";
+            if (!pimpl->client.subscribe(zoneTopic.c_str())) {
+                ESP_LOGW(TAG, "Failed to subscribe to %s", zoneTopic.c_str());
+            }
+        }
         
         // Publish initial status
         if (!publish(pimpl->statusTopic, "online", true)) {
             ESP_LOGW(TAG, "Failed to publish initial status");
         }
+
+        // Live topics first, the history follows at the replay rate
+        publishOfflineValues();
+        if (!pimpl->backlog.isEmpty()) {
+            ESP_LOGI(TAG, "Replaying %u buffered values", static_cast<unsigned>(pimpl->backlog.size()));
+        }
+        pimpl->lastRefill = millis();
         
         pimpl->lastError = ThermostatStatus::OK;
         memset(pimpl->lastErrorMessage, 0, sizeof(pimpl->lastErrorMessage));
@@ -290,46 +398,164 @@ void MQTTInterface::getConfig(JsonDocument& config) const {
 
 // Data transmission
 bool MQTTInterface::sendTemperature(float temperature) {
-    char buffer[10];
-    snprintf(buffer, sizeof(buffer), "%.2f", temperature);
-    return publish(pimpl->temperatureTopic, buffer);
+    return publishValue(0, CommandType::CMD_SET_TEMPERATURE, temperature);
 }
 
 bool MQTTInterface::sendHumidity(float humidity) {
     char buffer[10];
-    snprintf(buffer, sizeof(buffer), "%.2f", humidity);
+    formatValue(buffer, sizeof(buffer), humidity);
     return publish(pimpl->humidityTopic, buffer);
 }
 
 bool MQTTInterface::sendPressure(float value) {
     char payload[16];
-    snprintf(payload, sizeof(payload), "%.2f", value);
+    formatValue(payload, sizeof(payload), value);
     return publish(getFullTopic("pressure").c_str(), payload);
 }
 
 bool MQTTInterface::sendSetpoint(float setpoint) {
-    char buffer[10];
-    snprintf(buffer, sizeof(buffer), "%.2f", setpoint);
-    return publish(pimpl->setpointTopic, buffer);
+    return publishValue(0, CommandType::CMD_SETPOINT, setpoint);
 }
 
 bool MQTTInterface::sendValvePosition(float position) {
-    char buffer[10];
-    snprintf(buffer, sizeof(buffer), "%.2f", position);
-    return publish(pimpl->valveTopic, buffer);
+    return publishValue(0, CommandType::CMD_VALVE, position);
 }
 
 bool MQTTInterface::sendMode(ThermostatMode mode) {
-    if (!isConnected()) {
+    return publishValue(0, CommandType::CMD_MODE, static_cast<float>(mode));
+}
+
+bool MQTTInterface::sendHeatingState(bool isHeating) {
+    return publishValue(0, CommandType::CMD_HEATING, isHeating ? 1.0f : 0.0f);
+}
+
+void MQTTInterface::setZoneTopicPrefix(uint8_t zone, const char* prefix) {
+    if (zone == 0 || zone > ThermostatLimits::MAX_ZONES) {
+        ESP_LOGE(TAG, "Invalid zone %u", zone);
+        return;
+    }
+    strlcpy(pimpl->zonePrefixes[zone - 1], prefix, sizeof(pimpl->zonePrefixes[zone - 1]));
+}
+
+bool MQTTInterface::sendZoneValue(uint8_t zone, CommandType type, float value) {
+    if (zone == 0) {
+        return false;
+    }
+    return publishValue(zone, type, value);
+}
+
+bool MQTTInterface::publishValue(uint8_t zone, CommandType type, float value) {
+    char topic[128];
+    if (!pimpl->datapointTopic(zone, type, topic, sizeof(topic))) {
+        return false;
+    }
+    if (!pimpl->enabled || !pimpl->connected) {
+        return storeOffline(zone, type, value);
+    }
+
+    // Live values never wait, replay makes up for the publishes they use
+    float burst = pimpl->backlog.getConfig().replayRate;
+    pimpl->publishTokens -= 1.0f;
+    if (pimpl->publishTokens < -burst) {
+        pimpl->publishTokens = -burst;
+    }
+
+    char payload[24];
+    formatPayload(type, value, payload, sizeof(payload));
+    if (publish(topic, payload)) {
+        return true;
+    }
+    if (!pimpl->client.connected()) {
+        pimpl->connected = false;
+        return storeOffline(zone, type, value);
+    }
+    return false;
+}
+
+bool MQTTInterface::storeOffline(uint8_t zone, CommandType type, float value) {
+    if (!pimpl->enabled || !pimpl->backlog.getConfig().enabled) {
         return false;
     }
 
-    const char* modeStr = getThermostatModeName(mode);
-    return publish(pimpl->modeTopic, modeStr);
+    pimpl->backlog.store({static_cast<uint32_t>(millis()), value, zone, static_cast<uint8_t>(type), 0});
+
+    size_t datapoint = zone * COMMAND_TYPE_COUNT + static_cast<uint8_t>(type);
+    pimpl->offlineValues[datapoint] = value;
+    pimpl->offlineChanged[datapoint / 32] |= 1u << (datapoint & 31);
+    return true;
 }
 
-bool MQTTInterface::sendHeatingState(bool isHeating) {
-    return publish(pimpl->heatingTopic, isHeating ? "ON" : "OFF");
+void MQTTInterface::publishOfflineValues() {
+    for (size_t word = 0; word < sizeof(pimpl->offlineChanged) / sizeof(pimpl->offlineChanged[0]); word++) {
+        uint32_t due = pimpl->offlineChanged[word];
+        while (due != 0) {
+            uint32_t bit = 1u << __builtin_ctz(due);
+            due &= due - 1;
+            size_t datapoint = word * 32 + __builtin_ctz(bit);
+
+            uint8_t zone = datapoint / COMMAND_TYPE_COUNT;
+            CommandType type = static_cast<CommandType>(datapoint % COMMAND_TYPE_COUNT);
+            char topic[128];
+            char payload[24];
+            if (pimpl->datapointTopic(zone, type, topic, sizeof(topic))) {
+                formatPayload(type, pimpl->offlineValues[datapoint], payload, sizeof(payload));
+                if (!publish(topic, payload)) {
+                    // The link dropped again, the rest stays marked for the next reconnect
+                    if (!pimpl->client.connected()) {
+                        pimpl->connected = false;
+                        return;
+                    }
+                    continue;
+                }
+            }
+            pimpl->offlineChanged[word] &= ~bit;
+        }
+    }
+}
+
+void MQTTInterface::replayBacklog(unsigned long now) {
+    float rate = pimpl->backlog.getConfig().replayRate;
+    pimpl->publishTokens += (now - pimpl->lastRefill) * rate / 1000.0f;
+    pimpl->lastRefill = now;
+    if (pimpl->publishTokens > rate) {
+        pimpl->publishTokens = rate;
+    }
+
+    BacklogRecord record;
+    while (pimpl->publishTokens >= 1.0f && pimpl->backlog.peek(record)) {
+        CommandType type = static_cast<CommandType>(record.type);
+        char topic[128];
+        if (!pimpl->datapointTopic(record.zone, type, topic + 8, sizeof(topic) - 8)) {
+            pimpl->backlog.pop();  // Zone topic removed meanwhile
+            continue;
+        }
+        memcpy(topic, "history/", 8);
+
+        // Not retained, the live topic holds the current value
+        char value[24];
+        char payload[64];
+        formatPayload(type, record.value, value, sizeof(value));
+        bool quoted = type == CommandType::CMD_MODE || type == CommandType::CMD_HEATING;
+        snprintf(payload, sizeof(payload), quoted ? "{\"age\":%lu,\"value\":\"%s\"}" : "{\"age\":%lu,\"value\":%s}",
+                 static_cast<unsigned long>(now - record.time), value);
+        if (!publish(topic, payload, false)) {
+            break;
+        }
+        pimpl->backlog.pop();
+        pimpl->publishTokens -= 1.0f;
+    }
+}
+
+void MQTTInterface::setBacklogConfig(const MqttBacklogConfig& config) {
+    pimpl->backlog.configure(config);
+}
+
+const MqttBacklog::Stats& MQTTInterface::getBacklogStats() const {
+    return pimpl->backlog.getStats();
+}
+
+size_t MQTTInterface::getBacklogSize() const {
+    return pimpl->backlog.size();
 }
 
 // Error handling
@@ -376,6 +602,10 @@ void MQTTInterface::setTopicPrefix(const char* prefix) {
     strlcpy(pimpl->topicPrefix, prefix, sizeof(pimpl->topicPrefix));
 }
 
+void MQTTInterface::setOutdoorTemperatureTopic(const char* topic) {
+    strlcpy(pimpl->outdoorTopic, topic, sizeof(pimpl->outdoorTopic));
+}
+
 // Internal helpers
 bool MQTTInterface::validateConnection() const {
     if (strlen(pimpl->server) == 0) {
@@ -423,10 +653,27 @@ void MQTTInterface::handleMessage(char* topic, byte* payload, unsigned int lengt
         payloadStr += (char)payload[i];
     }
 
+    // Outdoor temperature from a sensor elsewhere
+    if (pimpl->outdoorTopic[0] != '\0' && topicStr == pimpl->outdoorTopic) {
+        pimpl->protocolManager->receiveCommand(CommandSource::SOURCE_MQTT, CommandType::CMD_OUTDOOR_TEMPERATURE,
+                                               payloadStr.toFloat());
+        return;
+    }
+
+    // Zone topics first, they end like the device's own
+    if (handleZoneMessage(topicStr, payloadStr.toFloat())) {
+        return;
+    }
+
     // Handle setpoint changes
     if (topicStr.endsWith("/setpoint/set")) {
         float setpoint = payloadStr.toFloat();
-        pimpl->thermostatState->setTargetTemperature(setpoint);
+        pimpl->protocolManager->receiveCommand(CommandSource::SOURCE_MQTT, CommandType::CMD_SETPOINT, setpoint);
+    }
+    // Minutes until the comfort setpoint is due
+    else if (topicStr.endsWith("/comfort/set")) {
+        pimpl->protocolManager->receiveCommand(CommandSource::SOURCE_MQTT, CommandType::CMD_COMFORT_TIME,
+                                               payloadStr.toFloat());
     }
     // Handle mode changes
     else if (topicStr.endsWith("/mode/set")) {
@@ -445,9 +692,37 @@ void MQTTInterface::handleMessage(char* topic, byte* payload, unsigned int lengt
         }
         
         if (pimpl->protocolManager) {
-            pimpl->protocolManager->handleIncomingCommand(CommandSource::SOURCE_MQTT, CommandType::CMD_MODE, static_cast<float>(mode));
+            pimpl->protocolManager->receiveCommand(CommandSource::SOURCE_MQTT, CommandType::CMD_MODE, static_cast<float>(mode));
+        }
+    }
+}
+
+bool MQTTInterface::handleZoneMessage(const String& topic, float value) {
+    for (uint8_t i = 0; i < ThermostatLimits::MAX_ZONES; i++) {
+        if (pimpl->zonePrefixes[i][0] == '\0') {
+            continue;
+        }
+        String zonePrefix = String(pimpl->topicPrefix) + pimpl->zonePrefixes[i];
+        if (!topic.startsWith(zonePrefix)) {
+            continue;
+        }
+
+        String suffix = topic.substring(zonePrefix.length());
+        CommandType type;
+        if (suffix == "temperature/set") {
+            type = CommandType::CMD_SET_TEMPERATURE;
+        } else if (suffix == "setpoint/set") {
+            type = CommandType::CMD_SETPOINT;
+        } else if (suffix == "comfort/set") {
+            type = CommandType::CMD_COMFORT_TIME;
+        } else {
+            ESP_LOGW(TAG, "Unsupported zone topic: %s", topic.c_str());
+            return true;
         }
+        pimpl->protocolManager->receiveCommand(CommandSource::SOURCE_MQTT, type, value, i + 1);
+        return true;
     }
+    return false;
 }
 
 String MQTTInterface::getFullTopic(const char* suffix) const {
@@ -457,9 +732,9 @@ String MQTTInterface::getFullTopic(const char* suffix) const {
 }
 
 void MQTTInterface::setEnabled(bool enabled) {
-    if (enabled && !isConnected()) {
-        reconnect();
-    } else if (!enabled && isConnected()) {
+    // Connecting is left to begin() and the reconnect in loop()
+    pimpl->enabled = enabled;
+    if (!enabled && isConnected()) {
         disconnect();
     }
 }
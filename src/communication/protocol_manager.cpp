@@ -4,25 +4,45 @@
 
 static const char* TAG = "ProtocolManager";
 
+// Outbound updates by CommandType, nullptr where protocols have no send method
+using Sender = bool (*)(ProtocolInterface*, float);
+static const Sender SENDERS[COMMAND_TYPE_COUNT] = {
+    nullptr,                                                                     // CMD_NONE
+    [](ProtocolInterface* p, float v) { return p->sendSetpoint(v); },            // CMD_SETPOINT
+    [](ProtocolInterface* p, float v) {                                          // CMD_MODE
+        return p->sendMode(static_cast<ThermostatMode>(static_cast<int>(v)));
+    },
+    [](ProtocolInterface* p, float v) { return p->sendValvePosition(v); },       // CMD_VALVE
+    [](ProtocolInterface* p, float v) { return p->sendHeatingState(v != 0.0f); },  // CMD_HEATING
+    [](ProtocolInterface* p, float v) { return p->sendTemperature(v); },         // CMD_SET_TEMPERATURE
+    nullptr,                                                                     // CMD_ENABLE
+    nullptr,                                                                     // CMD_OUTDOOR_TEMPERATURE
+    nullptr,                                                                     // CMD_FLOW_TEMPERATURE
+    nullptr                                                                      // CMD_COMFORT_TIME
+};
+
 ProtocolManager::ProtocolManager(ThermostatState* state)
     : thermostatState(state)
-    , knxInterface(nullptr)
-    , mqttInterface(nullptr)
     , lastCommandSource(CommandSource::SOURCE_INTERNAL)
     , lastCommandType(CommandType::CMD_NONE)
     , lastCommandValue(0.0f)
+    , queuedUpdates(0)
+    , rejectedUpdates(0)
+    , outboundConfig(DEFAULT_OUTBOUND_CONFIG)
+    , outboundValues()
+    , coalescedSends(0)
+    , sentUpdates(0)
+    , refusedSends(0)
 {
+    echoes.setWindow(outboundConfig.echoWindow);
 }
 
 void ProtocolManager::registerProtocols(KNXInterface* knx, MQTTInterface* mqtt) {
-    knxInterface = knx;
-    mqttInterface = mqtt;
-
-    if (knxInterface) {
-        addProtocol(knxInterface);
+    if (knx) {
+        addProtocol(knx);
     }
-    if (mqttInterface) {
-        addProtocol(mqttInterface);
+    if (mqtt) {
+        addProtocol(mqtt);
     }
 }
 
@@ -47,6 +67,7 @@ void ProtocolManager::addProtocol(ProtocolInterface* protocol) {
     if (protocol) {
         protocols.push_back(protocol);
         protocol->registerCallbacks(thermostatState, this);
+        rebuildRoutes();
     }
 }
 
@@ -57,49 +78,140 @@ void ProtocolManager::removeProtocol(ProtocolInterface* protocol) {
         if (it != protocols.end()) {
             protocols.erase(it);
         }
+        rebuildRoutes();
+    }
+}
+
+void ProtocolManager::rebuildRoutes() {
+    uint32_t sendable = PROTOCOL_CAP_ZONES;
+    for (uint8_t type = 0; type < COMMAND_TYPE_COUNT; type++) {
+        if (SENDERS[type]) {
+            sendable |= protocolCapability(static_cast<CommandType>(type));
+        }
+    }
+
+    routes.clear();
+    for (auto protocol : protocols) {
+        routes.push_back({protocol, protocol->getCommandSource(), protocol->getCapabilities() & sendable, {}, 0});
+    }
+}
+
+bool ProtocolManager::handleIncomingCommand(CommandSource source, CommandType cmd, float value, uint8_t zone) {
+    // Commands arrive on any task and are applied on the control task
+    if (!commands.push({source, cmd, value, zone})) {
+        ESP_LOGW(TAG, "Command queue full, dropping %s from %s",
+                 getCommandTypeName(cmd), getCommandSourceName(source));
+        return false;
+    }
+    return true;
+}
+
+bool ProtocolManager::receiveCommand(CommandSource source, CommandType cmd, float value, uint8_t zone) {
+    if (echoes.isEcho(source, zone, cmd, value, millis())) {
+        ESP_LOGD(TAG, "Dropping echo of %s %.2f from %s", getCommandTypeName(cmd), value, getCommandSourceName(source));
+        return false;
+    }
+    return handleIncomingCommand(source, cmd, value, zone);
+}
+
+bool ProtocolManager::queueLocalUpdate(CommandType cmd, float value) {
+    if (!commands.push({CommandSource::SOURCE_WEB, cmd, value, 0})) {
+        ESP_LOGW(TAG, "Web command queue full, dropping %s", getCommandTypeName(cmd));
+        return false;
+    }
+    return true;
+}
+
+void ProtocolManager::processCommands() {
+    // Producers keep queueing meanwhile, those commands wait for the next tick
+    ProtocolCommand batch[QUEUE_SIZE];
+    size_t count = 0;
+    while (count < QUEUE_SIZE && commands.pop(batch[count])) {
+        count++;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        // Skip a command when another one for the same datapoint has a higher
+        // priority, or the same priority and arrived later
+        int priority = getPriority(batch[i].source);
+        bool superseded = false;
+        for (size_t j = 0; j < count && !superseded; j++) {
+            if (j == i || batch[j].type != batch[i].type || batch[j].zone != batch[i].zone) {
+                continue;
+            }
+            int other = getPriority(batch[j].source);
+            superseded = other > priority || (other == priority && j > i);
+        }
+        if (!superseded) {
+            applyQueued(batch[i]);
+        }
     }
 }
 
-bool ProtocolManager::handleIncomingCommand(CommandSource source, CommandType cmd, float value) {
-    // Lock the mutex during command processing
-    std::lock_guard<std::mutex> lock(commandMutex);
-    
+void ProtocolManager::applyQueued(const ProtocolCommand& command) {
+    if (command.source == CommandSource::SOURCE_WEB) {
+        applyLocalUpdate(command);
+        return;
+    }
+    if (command.zone != 0) {
+        // Zones have their own state, forward and echo to the other protocols
+        if (zoneHandler) {
+            zoneHandler(command);
+            queueOutbound(command.source, command.type, command.value, command.zone);
+        }
+        return;
+    }
+    applyCommand(command);
+}
+
+bool ProtocolManager::applyCommand(const ProtocolCommand& command) {
+    // Measurements are not commands and bypass priority arbitration
+    if (command.type == CommandType::CMD_OUTDOOR_TEMPERATURE) {
+        if (thermostatState) {
+            thermostatState->setOutdoorTemperature(command.value);
+        }
+        return true;
+    }
+    if (command.type == CommandType::CMD_FLOW_TEMPERATURE) {
+        if (thermostatState) {
+            thermostatState->setFlowTemperature(command.value);
+        }
+        return true;
+    }
+
+    // Schedules are not state and bypass priority arbitration as well
+    if (command.type == CommandType::CMD_COMFORT_TIME) {
+        if (!comfortHandler) {
+            ESP_LOGW(TAG, "Optimum start disabled, ignoring comfort time from %s", getCommandSourceName(command.source));
+            return false;
+        }
+        comfortHandler(command.value);
+        return true;
+    }
+
     // Check if the new command has higher priority
-    if (!hasHigherPriority(source, lastCommandSource)) {
+    if (!hasHigherPriority(command.source, lastCommandSource)) {
         return false;
     }
 
     // Update state based on command type
     bool success = true;
-        switch (cmd) {
-            case CommandType::CMD_SETPOINT:
-                if (thermostatState) {
-                    thermostatState->setTargetTemperature(value);
-                    lastCommandSource = source;
-                    lastCommandType = cmd;
-                    lastCommandValue = value;
-                    // Only propagate after state changes are complete
-                    propagateCommand(source, cmd, value);
-                }
-                break;
+    switch (command.type) {
+        case CommandType::CMD_SETPOINT:
+            if (thermostatState) {
+                thermostatState->setTargetTemperature(command.value);
+            }
+            break;
 
         case CommandType::CMD_MODE:
             if (thermostatState) {
-                thermostatState->setMode(static_cast<ThermostatMode>(static_cast<int>(value)));
-                lastCommandSource = source;
-                lastCommandType = cmd;
-                lastCommandValue = value;
-                propagateCommand(source, cmd, value);
+                thermostatState->setMode(static_cast<ThermostatMode>(static_cast<int>(command.value)));
             }
             break;
 
         case CommandType::CMD_VALVE:
             if (thermostatState) {
-                thermostatState->setValvePosition(value);
-                lastCommandSource = source;
-                lastCommandType = cmd;
-                lastCommandValue = value;
-                propagateCommand(source, cmd, value);
+                thermostatState->setValvePosition(command.value);
             }
             break;
 
@@ -108,104 +220,187 @@ bool ProtocolManager::handleIncomingCommand(CommandSource source, CommandType cm
             break;
     }
 
+    if (success && thermostatState) {
+        lastCommandSource = command.source;
+        lastCommandType = command.type;
+        lastCommandValue = command.value;
+        // Only propagate after state changes are complete
+        propagateCommand(command.source, command.type, command.value);
+    }
+
     return success;
 }
 
-void ProtocolManager::propagateCommand(CommandSource source, CommandType cmd, float value) {
-    // Propagate to KNX if not the source
-    if (knxInterface && source != CommandSource::SOURCE_KNX) {
-        switch (cmd) {
-            case CommandType::CMD_SETPOINT:
-                knxInterface->sendSetpoint(value);
-                break;
-            case CommandType::CMD_MODE:
-                knxInterface->sendMode(static_cast<ThermostatMode>(static_cast<int>(value)));
-                break;
-            case CommandType::CMD_VALVE:
-                knxInterface->sendValvePosition(value);
-                break;
-            default:
-                break;
-        }
+void ProtocolManager::applyLocalUpdate(const ProtocolCommand& command) {
+    if (!thermostatState) {
+        return;
     }
 
-    // Propagate to MQTT if not the source
-    if (mqttInterface && source != CommandSource::SOURCE_MQTT) {
-        switch (cmd) {
-            case CommandType::CMD_SETPOINT:
-                mqttInterface->sendSetpoint(value);
-                break;
-            case CommandType::CMD_MODE:
-                mqttInterface->sendMode(static_cast<ThermostatMode>(static_cast<int>(value)));
-                break;
-            case CommandType::CMD_VALVE:
-                mqttInterface->sendValvePosition(value);
-                break;
-            default:
-                break;
-        }
+    switch (command.type) {
+        case CommandType::CMD_SETPOINT:
+            thermostatState->setTargetTemperature(command.value);
+            break;
+        case CommandType::CMD_MODE:
+            thermostatState->setMode(static_cast<ThermostatMode>(static_cast<int>(command.value)));
+            break;
+        case CommandType::CMD_ENABLE:
+            thermostatState->setEnabled(command.value != 0.0f);
+            break;
+        default:
+            ESP_LOGW(TAG, "Unsupported local update: %s", getCommandTypeName(command.type));
+            break;
     }
 }
 
+void ProtocolManager::propagateCommand(CommandSource source, CommandType cmd, float value) {
+    queueOutbound(source, cmd, value);
+}
+
 void ProtocolManager::sendTemperature(float temperature) {
-    if (knxInterface) knxInterface->sendTemperature(temperature);
-    if (mqttInterface) mqttInterface->sendTemperature(temperature);
+    queueOutbound(CommandSource::SOURCE_INTERNAL, CommandType::CMD_SET_TEMPERATURE, temperature);
 }
 
 void ProtocolManager::sendSetpoint(float setpoint) {
-    if (knxInterface) knxInterface->sendSetpoint(setpoint);
-    if (mqttInterface) mqttInterface->sendSetpoint(setpoint);
+    queueOutbound(CommandSource::SOURCE_INTERNAL, CommandType::CMD_SETPOINT, setpoint);
 }
 
 void ProtocolManager::sendValvePosition(float position) {
-    if (knxInterface) knxInterface->sendValvePosition(position);
-    if (mqttInterface) mqttInterface->sendValvePosition(position);
+    queueOutbound(CommandSource::SOURCE_INTERNAL, CommandType::CMD_VALVE, position);
 }
 
 void ProtocolManager::sendMode(ThermostatMode mode) {
-    if (knxInterface) knxInterface->sendMode(mode);
-    if (mqttInterface) mqttInterface->sendMode(mode);
+    queueOutbound(CommandSource::SOURCE_INTERNAL, CommandType::CMD_MODE, static_cast<float>(mode));
 }
 
 void ProtocolManager::sendHeatingState(bool isHeating) {
-    if (knxInterface) knxInterface->sendHeatingState(isHeating);
-    if (mqttInterface) mqttInterface->sendHeatingState(isHeating);
+    queueOutbound(CommandSource::SOURCE_INTERNAL, CommandType::CMD_HEATING, isHeating ? 1.0f : 0.0f);
 }
 
-bool ProtocolManager::hasHigherPriority(CommandSource newSource, CommandSource currentSource) {
-    // Priority order: KNX > MQTT > Web > Internal
-    int newPriority = 0;
-    int currentPriority = 0;
+void ProtocolManager::sendZoneValvePosition(uint8_t zone, float position) {
+    queueOutbound(CommandSource::SOURCE_INTERNAL, CommandType::CMD_VALVE, position, zone);
+}
 
-    switch (newSource) {
-        case CommandSource::SOURCE_KNX:
-            newPriority = 4;
-            break;
-        case CommandSource::SOURCE_MQTT:
-            newPriority = 3;
-            break;
-        case CommandSource::SOURCE_WEB:
-            newPriority = 2;
-            break;
-        case CommandSource::SOURCE_INTERNAL:
-            newPriority = 1;
-            break;
+void ProtocolManager::sendZoneSetpoint(uint8_t zone, float setpoint) {
+    queueOutbound(CommandSource::SOURCE_INTERNAL, CommandType::CMD_SETPOINT, setpoint, zone);
+}
+
+void ProtocolManager::queueOutbound(CommandSource source, CommandType cmd, float value, uint8_t zone) {
+    if (zone > ThermostatLimits::MAX_ZONES || static_cast<uint8_t>(cmd) >= COMMAND_TYPE_COUNT) {
+        rejectedUpdates.fetch_add(1, std::memory_order_relaxed);
+        ESP_LOGW(TAG, "No outbound datapoint for %s of zone %u", getCommandTypeName(cmd), zone);
+        return;
+    }
+
+    // A value not sent yet is replaced, protocols only ever get the newest one
+    outbound.write(zone * COMMAND_TYPE_COUNT + static_cast<uint8_t>(cmd), {source, cmd, value, zone});
+    queuedUpdates.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ProtocolManager::configureOutbound(const OutboundConfig& config) {
+    outboundConfig = config;
+    if (outboundConfig.interval == 0) outboundConfig.interval = DEFAULT_OUTBOUND_CONFIG.interval;
+    if (outboundConfig.burst == 0) outboundConfig.burst = DEFAULT_OUTBOUND_CONFIG.burst;
+    echoes.setWindow(outboundConfig.echoWindow);
+}
+
+void ProtocolManager::flushOutbound() {
+    outbound.collect([this](size_t datapoint, const ProtocolCommand& update) { routeUpdate(datapoint, update); });
+
+    for (size_t i = 0; i < routes.size(); i++) {
+        ProtocolRoute& route = routes[i];
+        uint8_t budget = outboundConfig.burst;
+
+        // Resume after the last datapoint sent, so no datapoint waits
+        // forever. The start word is visited twice: from the cursor's bit
+        // on first, and once more for the bits below it.
+        size_t position = route.cursor;
+        for (size_t n = 0; n <= OutboundTable::WORDS && budget > 0; n++) {
+            size_t word = (position / 32) % OutboundTable::WORDS;
+            uint32_t due = route.pending[word] & (~0u << (position % 32));
+            while (due != 0 && budget > 0) {
+                uint32_t bit = __builtin_ctz(due);
+                due &= due - 1;
+                route.pending[word] &= ~(1u << bit);
+                sendUpdate(route, outboundValues[word * 32 + bit]);
+                budget--;
+                position = word * 32 + bit + 1;
+            }
+            if (due != 0) {
+                break;
+            }
+            position = (word + 1) * 32;
+        }
+        route.cursor = position % (OutboundTable::WORDS * 32);
     }
+}
+
+void ProtocolManager::routeUpdate(size_t datapoint, const ProtocolCommand& update) {
+    outboundValues[datapoint] = update;
+    echoes.update(update.zone, update.type, update.value);
+
+    uint32_t required = protocolCapability(update.type) | (update.zone != 0 ? PROTOCOL_CAP_ZONES : 0);
+    uint32_t bit = 1u << (datapoint & 31);
 
-    switch (currentSource) {
+    for (size_t i = 0; i < routes.size(); i++) {
+        ProtocolRoute& route = routes[i];
+        uint32_t& pending = route.pending[datapoint / 32];
+        if (pending & bit) {
+            coalescedSends++;
+        }
+
+        // Skip protocols that cannot carry the update, and the one it came
+        // from, which already has the value that superseded any pending one
+        if ((route.capabilities & required) != required || route.source == update.source) {
+            pending &= ~bit;
+        } else {
+            pending |= bit;
+        }
+    }
+}
+
+bool ProtocolManager::sendUpdate(ProtocolRoute& route, const ProtocolCommand& update) {
+    bool sent;
+    if (update.zone != 0) {
+        sent = route.protocol->sendZoneValue(update.zone, update.type, update.value);
+    } else {
+        sent = SENDERS[static_cast<uint8_t>(update.type)](route.protocol, update.value);
+    }
+
+    if (sent) {
+        sentUpdates++;
+        echoes.record(update.zone, update.type, update.value, millis());
+    } else {
+        refusedSends++;
+    }
+    return sent;
+}
+
+ProtocolManager::OutboundStats ProtocolManager::getOutboundStats() const {
+    OutboundStats stats;
+    stats.updates = queuedUpdates.load(std::memory_order_relaxed);
+    stats.coalesced = outbound.getOverwrittenCount() + coalescedSends;
+    stats.sent = sentUpdates;
+    stats.dropped = rejectedUpdates.load(std::memory_order_relaxed) + refusedSends;
+    stats.echoes = echoes.getSuppressedCount();
+    return stats;
+}
+
+int ProtocolManager::getPriority(CommandSource source) {
+    // Priority order: KNX > MQTT > Web > Internal
+    switch (source) {
         case CommandSource::SOURCE_KNX:
-            currentPriority = 4;
-            break;
+            return 4;
         case CommandSource::SOURCE_MQTT:
-            currentPriority = 3;
-            break;
+            return 3;
         case CommandSource::SOURCE_WEB:
-            currentPriority = 2;
-            break;
+            return 2;
         case CommandSource::SOURCE_INTERNAL:
-            currentPriority = 1;
-            break;
+            return 1;
+        default:
+            return 0;
     }
+}
 
-    return newPriority >= currentPriority;
+bool ProtocolManager::hasHigherPriority(CommandSource newSource, CommandSource currentSource) {
+    return getPriority(newSource) >= getPriority(currentSource);
 }
\ No newline at end of file
@@ -13,11 +13,17 @@ WebInterface::WebInterface(ConfigManager* configManager, SensorInterface* sensor
                           PIDController* pidController, ThermostatState* thermostatState,
                           ProtocolManager* protocolManager)
     : server(80)
+    , telemetrySocket("/telemetry")
     , configManager(configManager)
     , sensorInterface(sensorInterface)
     , pidController(pidController)
     , thermostatState(thermostatState)
     , protocolManager(protocolManager)
+    , controllerFactory(nullptr)
+    , telemetry(nullptr)
+    , pwmOutput(nullptr)
+    , telemetryCursor(0)
+    , telemetryStep(1)
     , otaInitialized(false) {
     ESP_LOGI(TAG, "Web interface initialized");
 }
@@ -40,13 +46,23 @@ bool WebInterface::begin() {
         server.on("/", HTTP_GET, std::bind(&WebInterface::handleRoot, this, std::placeholders::_1));
         server.on("/save", HTTP_POST, std::bind(&WebInterface::handleSave, this, std::placeholders::_1));
         server.on("/status", HTTP_GET, std::bind(&WebInterface::handleGetStatus, this, std::placeholders::_1));
+        server.on("/profile", HTTP_GET, std::bind(&WebInterface::handleGetProfile, this, std::placeholders::_1));
         server.on("/setpoint", HTTP_POST, std::bind(&WebInterface::handleSetpoint, this, std::placeholders::_1));
         server.on("/mode", HTTP_POST, std::bind(&WebInterface::handleMode, this, std::placeholders::_1));
         server.on("/pid", HTTP_POST, std::bind(&WebInterface::handlePID, this, std::placeholders::_1));
+        server.on("/autotune", HTTP_GET, std::bind(&WebInterface::handleGetAutotune, this, std::placeholders::_1));
+        server.on("/autotune", HTTP_POST, std::bind(&WebInterface::handleAutotune, this, std::placeholders::_1));
         server.on("/reboot", HTTP_POST, std::bind(&WebInterface::handleReboot, this, std::placeholders::_1));
         server.on("/factory_reset", HTTP_POST, std::bind(&WebInterface::handleFactoryReset, this, std::placeholders::_1));
         server.on("/config", HTTP_GET, std::bind(&WebInterface::handleGetConfig, this, std::placeholders::_1));
         server.on("/create_config", HTTP_POST, std::bind(&WebInterface::handleCreateConfig, this, std::placeholders::_1));
+        if (telemetry) {
+            if (configManager->getWebUsername()[0]) {
+                telemetrySocket.setAuthentication(configManager->getWebUsername(), configManager->getWebPassword());
+            }
+            server.addHandler(&telemetrySocket);
+        }
+
         // Set up MDNS for easy access
         setupMDNS();
         
@@ -73,6 +89,45 @@ void WebInterface::end() {
 
 void WebInterface::loop() {
     // AsyncWebServer doesn't need explicit loop handling
+    streamTelemetry();
+}
+
+void WebInterface::streamTelemetry() {
+    if (!telemetry) {
+        return;
+    }
+
+    telemetrySocket.cleanupClients();
+    if (telemetrySocket.count() == 0) {
+        // A new client starts with the newest samples
+        telemetryCursor = telemetry->getHead();
+        telemetryStep = 1;
+        return;
+    }
+
+    // A client with a full queue gets every other sample from now on
+    if (!telemetrySocket.availableForWriteAll()) {
+        if (telemetryStep < MAX_TELEMETRY_STEP) {
+            telemetryStep *= 2;
+            ESP_LOGD(TAG, "Telemetry client behind, sending every %u. sample", telemetryStep);
+        }
+        return;
+    }
+
+    TelemetryHeader header = {1, telemetryStep, 0, 0};
+    PidSample* samples = reinterpret_cast<PidSample*>(telemetryFrame + sizeof(TelemetryHeader));
+    header.count = telemetry->read(telemetryCursor, samples, TELEMETRY_BATCH, telemetryStep, &header.skipped);
+    if (header.count == 0) {
+        return;
+    }
+    memcpy(telemetryFrame, &header, sizeof(header));
+    telemetrySocket.binaryAll(telemetryFrame, sizeof(header) + header.count * sizeof(PidSample));
+
+    // Back to full rate once the clients keep up with what is left
+    uint32_t backlog = telemetry->getHead() - telemetryCursor;
+    if (telemetryStep > 1 && backlog < TELEMETRY_BATCH) {
+        telemetryStep /= 2;
+    }
 }
 
 void WebInterface::listFiles() {
@@ -21,9 +21,23 @@
 
 static const char* TAG = "ConfigManager";
 
+// Room for the zones array on top of the device settings
+static const size_t CONFIG_DOC_SIZE = 8192;
+
+static KNXPhysicalAddress readGroupAddress(JsonObject ga) {
+    KNXPhysicalAddress address = {0, 0, 0};
+    if (ga) {
+        address.area = ga["main"] | 0;
+        address.line = ga["middle"] | 0;
+        address.member = ga["sub"] | 0;
+    }
+    return address;
+}
+
 ConfigManager::ConfigManager() {
     // Initialize default values
     strlcpy(deviceName, "ESP32 Thermostat", sizeof(deviceName));
+    sendInterval = 30000;
     
     // Web interface defaults
     strlcpy(webUsername, "admin", sizeof(webUsername));
@@ -32,6 +46,10 @@ ConfigManager::ConfigManager() {
     // KNX defaults
     knxEnabled = false;
     knxPhysicalAddress = {1, 1, 160};
+    knxOutdoorGA = {0, 0, 0};
+    knxHeatingGA = {0, 0, 0};
+    knxFlowGA = {0, 0, 0};
+    knxComfortGA = {0, 0, 0};
     
     // MQTT defaults
     mqttEnabled = true;
@@ -41,6 +59,8 @@ ConfigManager::ConfigManager() {
     strlcpy(mqttPassword, "", sizeof(mqttPassword));
     strlcpy(mqttClientId, "esp32_thermostat", sizeof(mqttClientId));
     strlcpy(mqttTopicPrefix, "esp32/thermostat/", sizeof(mqttTopicPrefix));
+    mqttOutdoorTopic[0] = '\0';
+    mqttBacklogConfig = DEFAULT_MQTT_BACKLOG_CONFIG;
     
     // Default PID configuration
     pidConfig = {
@@ -51,6 +71,16 @@ ConfigManager::ConfigManager() {
         .maxOutput = 100.0f,
         .sampleTime = 30000.0f
     };
+    valveConfig = DEFAULT_VALVE_CONFIG;
+    failsafeConfig = DEFAULT_FAILSAFE_CONFIG;
+    heatingCurve = DEFAULT_HEATING_CURVE;
+    pwmConfig = DEFAULT_PWM_CONFIG;
+    controlEngine = ControlEngine::PID;
+    hysteresisConfig = DEFAULT_HYSTERESIS_CONFIG;
+    cascadeConfig = DEFAULT_CASCADE_CONFIG;
+    optimumStartConfig = DEFAULT_OPTIMUM_START_CONFIG;
+    outboundConfig = DEFAULT_OUTBOUND_CONFIG;
+    zoneCount = 0;
 }
 
 bool ConfigManager::begin() {
@@ -75,7 +105,7 @@ bool ConfigManager::loadConfig() {
     }
 
     // Parse the JSON document
-    StaticJsonDocument<1024> doc;
+    DynamicJsonDocument doc(CONFIG_DOC_SIZE);
     DeserializationError error = deserializeJson(doc, configFile);
     configFile.close();
 
@@ -85,10 +115,17 @@ bool ConfigManager::loadConfig() {
         return false;
     }
 
-    // Load device settings
+    // Load device settings, saved under "device", older files have "deviceName"
     if (doc.containsKey("deviceName")) {
         strlcpy(deviceName, doc["deviceName"] | "ESP32 Thermostat", sizeof(deviceName));
     }
+    JsonObject device = doc["device"];
+    if (device) {
+        if (device.containsKey("name")) {
+            strlcpy(deviceName, device["name"] | "ESP32 Thermostat", sizeof(deviceName));
+        }
+        sendInterval = device["sendInterval"] | sendInterval;
+    }
 
     // Load web interface settings
     JsonObject web = doc["web"];
@@ -107,6 +144,10 @@ bool ConfigManager::loadConfig() {
             knxPhysicalAddress.line = physical["line"] | 1;
             knxPhysicalAddress.member = physical["member"] | 1;
         }
+        knxOutdoorGA = readGroupAddress(knx["ga"]["outdoor"]);
+        knxHeatingGA = readGroupAddress(knx["ga"]["heating"]);
+        knxFlowGA = readGroupAddress(knx["ga"]["flow"]);
+        knxComfortGA = readGroupAddress(knx["ga"]["comfort"]);
     }
 
     // Load MQTT settings
@@ -119,6 +160,14 @@ bool ConfigManager::loadConfig() {
         strlcpy(mqttPassword, mqtt["password"] | "", sizeof(mqttPassword));
         strlcpy(mqttClientId, mqtt["clientId"] | "esp32_thermostat", sizeof(mqttClientId));
         strlcpy(mqttTopicPrefix, mqtt["topicPrefix"] | "esp32/thermostat/", sizeof(mqttTopicPrefix));
+        strlcpy(mqttOutdoorTopic, mqtt["outdoorTopic"] | "", sizeof(mqttOutdoorTopic));
+
+        JsonObject backlog = mqtt["backlog"];
+        if (backlog) {
+            mqttBacklogConfig.enabled = backlog["enabled"] | DEFAULT_MQTT_BACKLOG_CONFIG.enabled;
+            mqttBacklogConfig.maxFileSize = backlog["maxFileSize"] | DEFAULT_MQTT_BACKLOG_CONFIG.maxFileSize;
+            mqttBacklogConfig.replayRate = backlog["replayRate"] | DEFAULT_MQTT_BACKLOG_CONFIG.replayRate;
+        }
     }
 
     // Load PID settings
@@ -132,14 +181,123 @@ bool ConfigManager::loadConfig() {
         pidConfig.sampleTime = pid["sampleTime"] | 30000.0f;
     }
 
+    // Load valve output stage settings
+    JsonObject valve = doc["valve"];
+    if (valve) {
+        valveConfig.step = valve["step"] | DEFAULT_VALVE_CONFIG.step;
+        valveConfig.maxSlewRate = valve["maxSlewRate"] | DEFAULT_VALVE_CONFIG.maxSlewRate;
+        valveConfig.minDelta = valve["minDelta"] | DEFAULT_VALVE_CONFIG.minDelta;
+        valveConfig.refreshInterval = valve["refreshInterval"] | DEFAULT_VALVE_CONFIG.refreshInterval;
+    }
+
+    // Load output held while the sensor delivers nothing
+    JsonObject failsafe = doc["failsafe"];
+    if (failsafe) {
+        failsafeConfig.timeout = failsafe["timeout"] | DEFAULT_FAILSAFE_CONFIG.timeout;
+        failsafeConfig.output = failsafe["output"] | DEFAULT_FAILSAFE_CONFIG.output;
+    }
+
+    // Load weather compensation
+    JsonObject curve = doc["heatingCurve"];
+    if (curve) {
+        heatingCurve.slope = curve["slope"] | DEFAULT_HEATING_CURVE.slope;
+        heatingCurve.offset = curve["offset"] | DEFAULT_HEATING_CURVE.offset;
+    }
+
+    // Load on/off output settings
+    JsonObject pwm = doc["pwm"];
+    if (pwm) {
+        pwmConfig.enabled = pwm["enabled"] | DEFAULT_PWM_CONFIG.enabled;
+        pwmConfig.cycleTime = pwm["cycleTime"] | DEFAULT_PWM_CONFIG.cycleTime;
+        pwmConfig.minOnTime = pwm["minOnTime"] | DEFAULT_PWM_CONFIG.minOnTime;
+        pwmConfig.minOffTime = pwm["minOffTime"] | DEFAULT_PWM_CONFIG.minOffTime;
+        pwmConfig.accuracy = pwm["accuracy"] | DEFAULT_PWM_CONFIG.accuracy;
+    }
+
+    // Load control engine selection
+    JsonObject control = doc["control"];
+    if (control) {
+        if (control.containsKey("engine") && !parseControlEngine(control["engine"].as<const char*>(), controlEngine)) {
+            ESP_LOGW(TAG, "Unknown control engine %s, using PID", control["engine"].as<const char*>());
+            controlEngine = ControlEngine::PID;
+        }
+        JsonObject bands = control["hysteresis"];
+        for (uint8_t i = 0; i < THERMOSTAT_MODE_COUNT; i++) {
+            hysteresisConfig.bands[i] = bands[getThermostatModeKey(static_cast<ThermostatMode>(i))] | DEFAULT_HYSTERESIS_CONFIG.bands[i];
+        }
+        hysteresisConfig.onOutput = bands["output"] | DEFAULT_HYSTERESIS_CONFIG.onOutput;
+    }
+
+    // Load flow temperature loop settings
+    JsonObject cascade = doc["cascade"];
+    if (cascade) {
+        cascadeConfig.enabled = cascade["enabled"] | DEFAULT_CASCADE_CONFIG.enabled;
+        cascadeConfig.minFlow = cascade["minFlow"] | DEFAULT_CASCADE_CONFIG.minFlow;
+        cascadeConfig.maxFlow = cascade["maxFlow"] | DEFAULT_CASCADE_CONFIG.maxFlow;
+        cascadeConfig.kp = cascade["kp"] | DEFAULT_CASCADE_CONFIG.kp;
+        cascadeConfig.ki = cascade["ki"] | DEFAULT_CASCADE_CONFIG.ki;
+        cascadeConfig.kd = cascade["kd"] | DEFAULT_CASCADE_CONFIG.kd;
+        cascadeConfig.sampleTime = cascade["sampleTime"] | DEFAULT_CASCADE_CONFIG.sampleTime;
+        cascadeConfig.flowTimeout = cascade["flowTimeout"] | DEFAULT_CASCADE_CONFIG.flowTimeout;
+    }
+
+    // Load comfort schedule settings
+    JsonObject optimumStart = doc["optimumStart"];
+    if (optimumStart) {
+        optimumStartConfig.enabled = optimumStart["enabled"] | DEFAULT_OPTIMUM_START_CONFIG.enabled;
+        optimumStartConfig.interval = optimumStart["interval"] | DEFAULT_OPTIMUM_START_CONFIG.interval;
+        optimumStartConfig.deadTime = optimumStart["deadTime"] | DEFAULT_OPTIMUM_START_CONFIG.deadTime;
+        optimumStartConfig.forgetting = optimumStart["forgetting"] | DEFAULT_OPTIMUM_START_CONFIG.forgetting;
+        optimumStartConfig.maxLead = optimumStart["maxLead"] | DEFAULT_OPTIMUM_START_CONFIG.maxLead;
+        optimumStartConfig.setpoint = optimumStart["setpoint"] | DEFAULT_OPTIMUM_START_CONFIG.setpoint;
+    }
+
+    // Load outbound pacing settings
+    JsonObject outbound = doc["outbound"];
+    if (outbound) {
+        outboundConfig.interval = outbound["interval"] | DEFAULT_OUTBOUND_CONFIG.interval;
+        outboundConfig.burst = outbound["burst"] | DEFAULT_OUTBOUND_CONFIG.burst;
+        outboundConfig.echoWindow = outbound["echoWindow"] | DEFAULT_OUTBOUND_CONFIG.echoWindow;
+    }
+
+    // Load hub zones
+    loadZones(doc["zones"]);
+
     return true;
 }
 
+void ConfigManager::loadZones(JsonArray array) {
+    zoneCount = 0;
+    for (JsonObject zone : array) {
+        if (zoneCount >= ThermostatLimits::MAX_ZONES) {
+            ESP_LOGW(TAG, "Only %u zones supported, ignoring the rest", ThermostatLimits::MAX_ZONES);
+            break;
+        }
+
+        ZoneConfig& config = zones[zoneCount++];
+        strlcpy(config.name, zone["name"] | "Zone", sizeof(config.name));
+        config.enabled = zone["enabled"] | true;
+        config.setpoint = zone["setpoint"] | ThermostatLimits::DEFAULT_TEMPERATURE;
+
+        JsonObject knx = zone["knx"];
+        config.temperatureGA = readGroupAddress(knx["temperature"]);
+        config.setpointGA = readGroupAddress(knx["setpoint"]);
+        config.valveGA = readGroupAddress(knx["valve"]);
+        config.comfortGA = readGroupAddress(knx["comfort"]);
+        strlcpy(config.mqttPrefix, zone["mqtt"] | "", sizeof(config.mqttPrefix));
+        config.engine = ControlEngine::PID;
+        if (zone.containsKey("engine") && !parseControlEngine(zone["engine"].as<const char*>(), config.engine)) {
+            ESP_LOGW(TAG, "Unknown control engine for zone %s, using PID", config.name);
+        }
+    }
+    ESP_LOGI(TAG, "Loaded %u zones", zoneCount);
+}
+
 bool ConfigManager::saveConfig() {
     ESP_LOGI(TAG, "Attempting to save configuration...");
     
-    // Create JSON document
-    StaticJsonDocument<2048> doc;
+    // Create JSON document, zones are kept as read from the file
+    DynamicJsonDocument doc(CONFIG_DOC_SIZE);
     ESP_LOGI(TAG, "Created JSON document");
 
     // Read existing config (if it exists)
@@ -181,6 +339,10 @@ bool ConfigManager::saveConfig() {
     mqtt["password"] = mqttPassword;
     mqtt["clientId"] = mqttClientId;
     mqtt["topicPrefix"] = mqttTopicPrefix;
+    JsonObject backlog = mqtt.containsKey("backlog") ? mqtt["backlog"].as<JsonObject>() : mqtt.createNestedObject("backlog");
+    backlog["enabled"] = mqttBacklogConfig.enabled;
+    backlog["maxFileSize"] = mqttBacklogConfig.maxFileSize;
+    backlog["replayRate"] = mqttBacklogConfig.replayRate;
     
     // Device settings
     JsonObject device = doc.containsKey("device") ? doc["device"].as<JsonObject>() : doc.createNestedObject("device");
@@ -196,6 +358,74 @@ bool ConfigManager::saveConfig() {
     pid["maxOutput"] = pidConfig.maxOutput;
     pid["sampleTime"] = pidConfig.sampleTime;
 
+    // Valve output stage settings
+    JsonObject valve = doc.containsKey("valve") ? doc["valve"].as<JsonObject>() : doc.createNestedObject("valve");
+    valve["step"] = valveConfig.step;
+    valve["maxSlewRate"] = valveConfig.maxSlewRate;
+    valve["minDelta"] = valveConfig.minDelta;
+    valve["refreshInterval"] = valveConfig.refreshInterval;
+
+    // Sensor failsafe settings
+    JsonObject failsafe = doc.containsKey("failsafe") ? doc["failsafe"].as<JsonObject>() : doc.createNestedObject("failsafe");
+    failsafe["timeout"] = failsafeConfig.timeout;
+    failsafe["output"] = failsafeConfig.output;
+
+    // Weather compensation
+    JsonObject curve = doc.containsKey("heatingCurve") ? doc["heatingCurve"].as<JsonObject>() : doc.createNestedObject("heatingCurve");
+    curve["slope"] = heatingCurve.slope;
+    curve["offset"] = heatingCurve.offset;
+
+    // On/off output settings
+    JsonObject pwm = doc.containsKey("pwm") ? doc["pwm"].as<JsonObject>() : doc.createNestedObject("pwm");
+    pwm["enabled"] = pwmConfig.enabled;
+    pwm["cycleTime"] = pwmConfig.cycleTime;
+    pwm["minOnTime"] = pwmConfig.minOnTime;
+    pwm["minOffTime"] = pwmConfig.minOffTime;
+    pwm["accuracy"] = pwmConfig.accuracy;
+
+    // Control engine selection
+    JsonObject control = doc.containsKey("control") ? doc["control"].as<JsonObject>() : doc.createNestedObject("control");
+    control["engine"] = getControlEngineName(controlEngine);
+    JsonObject bands = control.containsKey("hysteresis") ? control["hysteresis"].as<JsonObject>() : control.createNestedObject("hysteresis");
+    for (uint8_t i = 0; i < THERMOSTAT_MODE_COUNT; i++) {
+        bands[getThermostatModeKey(static_cast<ThermostatMode>(i))] = hysteresisConfig.bands[i];
+    }
+    bands["output"] = hysteresisConfig.onOutput;
+
+    // Flow temperature loop settings
+    JsonObject cascade = doc.containsKey("cascade") ? doc["cascade"].as<JsonObject>() : doc.createNestedObject("cascade");
+    cascade["enabled"] = cascadeConfig.enabled;
+    cascade["minFlow"] = cascadeConfig.minFlow;
+    cascade["maxFlow"] = cascadeConfig.maxFlow;
+    cascade["kp"] = cascadeConfig.kp;
+    cascade["ki"] = cascadeConfig.ki;
+    cascade["kd"] = cascadeConfig.kd;
+    cascade["sampleTime"] = cascadeConfig.sampleTime;
+    cascade["flowTimeout"] = cascadeConfig.flowTimeout;
+
+    // Comfort schedule settings
+    JsonObject optimumStart = doc.containsKey("optimumStart") ? doc["optimumStart"].as<JsonObject>() : doc.createNestedObject("optimumStart");
+    optimumStart["enabled"] = optimumStartConfig.enabled;
+    optimumStart["interval"] = optimumStartConfig.interval;
+    optimumStart["deadTime"] = optimumStartConfig.deadTime;
+    optimumStart["forgetting"] = optimumStartConfig.forgetting;
+    optimumStart["maxLead"] = optimumStartConfig.maxLead;
+    optimumStart["setpoint"] = optimumStartConfig.setpoint;
+
+    // Outbound pacing settings
+    JsonObject outbound = doc.containsKey("outbound") ? doc["outbound"].as<JsonObject>() : doc.createNestedObject("outbound");
+    outbound["interval"] = outboundConfig.interval;
+    outbound["burst"] = outboundConfig.burst;
+    outbound["echoWindow"] = outboundConfig.echoWindow;
+
+    // Zone entries stay as read, only their engine can change at runtime
+    JsonArray zoneArray = doc["zones"];
+    uint8_t zoneIndex = 0;
+    for (JsonObject zone : zoneArray) {
+        if (zoneIndex >= zoneCount) break;
+        zone["engine"] = getControlEngineName(zones[zoneIndex++].engine);
+    }
+
     // Log the JSON content for debugging
     String jsonStr;
     serializeJson(doc, jsonStr);
@@ -252,6 +482,7 @@ void ConfigManager::resetToDefaults() {
     strlcpy(mqttPassword, "", sizeof(mqttPassword));
     strlcpy(mqttClientId, "esp32_thermostat", sizeof(mqttClientId));
     strlcpy(mqttTopicPrefix, "esp32/thermostat/", sizeof(mqttTopicPrefix));
+    mqttBacklogConfig = DEFAULT_MQTT_BACKLOG_CONFIG;
     
     // Reset PID configuration
     pidConfig = {
@@ -262,6 +493,15 @@ void ConfigManager::resetToDefaults() {
         .maxOutput = 100.0f,
         .sampleTime = 30000.0f
     };
+    valveConfig = DEFAULT_VALVE_CONFIG;
+    failsafeConfig = DEFAULT_FAILSAFE_CONFIG;
+    heatingCurve = DEFAULT_HEATING_CURVE;
+    pwmConfig = DEFAULT_PWM_CONFIG;
+    controlEngine = ControlEngine::PID;
+    hysteresisConfig = DEFAULT_HYSTERESIS_CONFIG;
+    cascadeConfig = DEFAULT_CASCADE_CONFIG;
+    optimumStartConfig = DEFAULT_OPTIMUM_START_CONFIG;
+    outboundConfig = DEFAULT_OUTBOUND_CONFIG;
     
     saveConfig();
 }
@@ -358,6 +598,14 @@ void ConfigManager::setSetpoint(float value) {
     setpoint = value;
 }
 
+const PIDConfig& ConfigManager::getPidConfig() const {
+    return pidConfig;
+}
+
+void ConfigManager::setPidConfig(const PIDConfig& config) {
+    pidConfig = config;
+}
+
 // Add a basic WiFi setup implementation
 bool ConfigManager::setupWiFi() {
     // Load credentials from storage
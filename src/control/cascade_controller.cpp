@@ -0,0 +1,76 @@
+#include "control/cascade_controller.h"
+#include <esp_log.h>
+
+static const char* TAG = "CascadeController";
+
+// Bounds for the measured interval, in sample times
+static const float MIN_DT_RATIO = 0.01f;
+static const float MAX_DT_RATIO = 4.0f;
+
+CascadeController::CascadeController()
+    : config(DEFAULT_CASCADE_CONFIG)
+    , demand(0.0f)
+    , flowTemperature(0.0f)
+    , lastFlowTime(0)
+    , hasFlow(false)
+    , closed(false)
+    , lastTime(0)
+    , output(0.0f) {
+    kernel.setOutputLimits(0.0f, 100.0f);
+}
+
+void CascadeController::configure(const CascadeConfig& newConfig) {
+    config = newConfig;
+    if (config.maxFlow < config.minFlow) config.maxFlow = config.minFlow;
+    if (config.sampleTime == 0) config.sampleTime = DEFAULT_CASCADE_CONFIG.sampleTime;
+    kernel.setGains(config.kp, config.ki, config.kd);
+
+    ESP_LOGI(TAG, "flow=%.0f-%.0fC kp=%.2f ki=%.3f kd=%.2f every %lus", config.minFlow, config.maxFlow,
+             config.kp, config.ki, config.kd, config.sampleTime / 1000);
+}
+
+void CascadeController::setDemand(float percent) {
+    demand = percent < 0.0f ? 0.0f : (percent > 100.0f ? 100.0f : percent);
+}
+
+float CascadeController::getFlowSetpoint() const {
+    return config.minFlow + demand / 100.0f * (config.maxFlow - config.minFlow);
+}
+
+void CascadeController::setFlowTemperature(float value, unsigned long now) {
+    flowTemperature = value;
+    lastFlowTime = now;
+    hasFlow = true;
+}
+
+bool CascadeController::hasFreshFlow(unsigned long now) const {
+    return hasFlow && now - lastFlowTime <= config.flowTimeout;
+}
+
+float CascadeController::update(unsigned long now) {
+    if (!hasFreshFlow(now)) {
+        if (closed) {
+            ESP_LOGW(TAG, "Flow temperature stale, the room loop drives the valve");
+            closed = false;
+        }
+        output = demand;
+        return output;
+    }
+
+    float setpoint = getFlowSetpoint();
+    float dtRatio = 1.0f;
+    if (closed) {
+        dtRatio = static_cast<float>(now - lastTime) / config.sampleTime;
+        dtRatio = dtRatio < MIN_DT_RATIO ? MIN_DT_RATIO : (dtRatio > MAX_DT_RATIO ? MAX_DT_RATIO : dtRatio);
+    } else {
+        // Take over from the current valve position without a jump
+        kernel.reset(PidMath::fromFloat(flowTemperature));
+        kernel.offsetIntegral(PidMath::fromFloat(config.kp * (setpoint - flowTemperature) - output));
+        closed = true;
+    }
+    lastTime = now;
+
+    output = PidMath::toFloat(kernel.compute(PidMath::fromFloat(setpoint), PidMath::fromFloat(flowTemperature),
+                                             PidMath::fromFloat(dtRatio)));
+    return output;
+}
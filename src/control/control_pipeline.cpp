@@ -0,0 +1,172 @@
+#include "control/control_pipeline.h"
+#include "system/loop_profiler.h"
+#include <Arduino.h>
+#include <esp_log.h>
+
+static const char* TAG = "ControlPipeline";
+
+ControlPipeline::ControlPipeline(ThermostatState* state, PIDController* pid)
+    : thermostatState(state)
+    , pidController(pid)
+    , controllers(nullptr)
+    , activeController(pid)
+    , valveGovernor(nullptr)
+    , pwmOutput(nullptr)
+    , cascade(nullptr)
+    , optimumStart(nullptr)
+    , failsafe(DEFAULT_FAILSAFE_CONFIG)
+    , failsafeActive(false)
+    , lastSampleTime(0)
+    , filterCoefficient(0.5f)
+    , filteredTemperature(0.0f)
+    , filterPrimed(false)
+    , passCount(0) {
+}
+
+void ControlPipeline::setFilterCoefficient(float alpha) {
+    if (alpha <= 0.0f || alpha > 1.0f) {
+        ESP_LOGW(TAG, "Invalid filter coefficient %.2f, keeping %.2f", alpha, filterCoefficient);
+        return;
+    }
+    filterCoefficient = alpha;
+}
+
+void ControlPipeline::onSample(float temperature, float humidity, float pressure) {
+    lastSampleTime = millis();
+
+    // Filter
+    if (filterPrimed) {
+        filteredTemperature += filterCoefficient * (temperature - filteredTemperature);
+    } else {
+        filteredTemperature = temperature;
+        filterPrimed = true;
+    }
+
+    // Listeners see one coalesced notification for the whole pass
+    thermostatState->beginUpdate();
+
+    {
+        PROFILE_PHASE(LoopPhase::STATE);
+        thermostatState->setCurrentTemperature(filteredTemperature);
+        thermostatState->setCurrentHumidity(humidity);
+        thermostatState->setCurrentPressure(pressure);
+    }
+
+    // A newly selected engine starts from its idle state
+    ControlInterface* controller = controllers ? controllers->current() : pidController;
+    if (controller != activeController) {
+        controller->reset();
+        activeController = controller;
+    }
+
+    // Back from the failsafe, continue from its output without a jump
+    if (failsafeActive) {
+        ESP_LOGI(TAG, "Sensor samples are back, leaving the failsafe");
+        failsafeActive = false;
+        if (controller == pidController) {
+            pidController->restartFrom(failsafe.output);
+        } else {
+            controller->reset();
+        }
+    }
+
+    // Controller compute on the fresh sample
+    {
+        PROFILE_PHASE(LoopPhase::PID);
+        if (optimumStart) {
+            updateOptimumStart(controller);
+        }
+        controller->setSetpoint(thermostatState->getTargetTemperature());
+        if (controller == pidController && thermostatState->hasOutdoorTemperature()) {
+            pidController->setOutdoorTemperature(thermostatState->getOutdoorTemperature());
+        }
+        controller->update(filteredTemperature);
+    }
+
+    float output = controller->getOutput();
+    if (optimumStart && optimumStart->isPreheating() && thermostatState->isEnabled()) {
+        output = pidController->getMaxOutput();
+    }
+
+    // In cascade the inner loop moves the valve on its own clock
+    PROFILE_PHASE(LoopPhase::STATE);
+    if (cascade) {
+        cascade->setDemand(output);
+    } else {
+        applyOutput(output);
+    }
+    thermostatState->endUpdate();
+    passCount++;
+}
+
+void ControlPipeline::checkSamples(unsigned long now) {
+    if (failsafeActive || failsafe.timeout == 0 || now - lastSampleTime < failsafe.timeout) {
+        return;
+    }
+
+    // A disabled thermostat stays off
+    float output = thermostatState->isEnabled() ? failsafe.output : 0.0f;
+    ESP_LOGW(TAG, "No sensor sample for %lu s, holding the output at %.0f%%", (now - lastSampleTime) / 1000, output);
+    failsafeActive = true;
+
+    thermostatState->beginUpdate();
+    if (cascade) {
+        cascade->setDemand(output);
+    } else {
+        applyOutput(output);
+    }
+    thermostatState->endUpdate();
+}
+
+void ControlPipeline::onCascadeTick(unsigned long now) {
+    if (!cascade) {
+        return;
+    }
+
+    thermostatState->beginUpdate();
+    applyOutput(cascade->update(now));
+    thermostatState->endUpdate();
+}
+
+void ControlPipeline::updateOptimumStart(ControlInterface* controller) {
+    // Without an outdoor temperature the estimator's bias takes up the losses
+    float outdoor = thermostatState->hasOutdoorTemperature() ? thermostatState->getOutdoorTemperature() : 0.0f;
+
+    // The valve position is what the room received since the previous pass
+    switch (optimumStart->update(filteredTemperature, thermostatState->getValvePosition(), outdoor, millis())) {
+        case PreheatEvent::START:
+            thermostatState->setTargetTemperature(optimumStart->getSetpoint());
+            if (setpointCallback) {
+                setpointCallback(optimumStart->getSetpoint());
+            }
+            break;
+        case PreheatEvent::END:
+            // Continue from the learnt output that holds the setpoint
+            if (controller == pidController) {
+                pidController->restartFrom(optimumStart->getHoldingOutput(outdoor));
+            } else {
+                controller->reset();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void ControlPipeline::applyOutput(float output) {
+    if (pwmOutput) {
+        pwmOutput->setDuty(output);
+    }
+
+    // Valve update, the state change listeners publish it
+    if (valveGovernor) {
+        float position;
+        switch (valveGovernor->update(output, millis(), position)) {
+            case ValveAction::MOVE: thermostatState->setValvePosition(position); break;
+            case ValveAction::REFRESH: thermostatState->republish(StateField::VALVE_POSITION); break;
+            default: break;
+        }
+    } else {
+        thermostatState->setValvePosition(output);
+    }
+}
@@ -0,0 +1,57 @@
+#include "control/controller_factory.h"
+#include "control/pid_controller.h"
+#include "control/hysteresis_controller.h"
+#include <esp_log.h>
+#include <string.h>
+
+static const char* TAG = "ControllerFactory";
+
+const char* getControlEngineName(ControlEngine engine) {
+    switch (engine) {
+        case ControlEngine::PID: return "pid";
+        case ControlEngine::HYSTERESIS: return "hysteresis";
+        default: return "unknown";
+    }
+}
+
+bool parseControlEngine(const char* name, ControlEngine& engine) {
+    if (!name) return false;
+    if (strcmp(name, "pid") == 0) {
+        engine = ControlEngine::PID;
+    } else if (strcmp(name, "hysteresis") == 0) {
+        engine = ControlEngine::HYSTERESIS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+ControllerFactory::ControllerFactory(PIDController* pid, HysteresisController* hysteresis)
+    : pid(pid)
+    , hysteresis(hysteresis) {
+    for (uint8_t i = 0; i <= MAX_ZONES; i++) {
+        engines[i] = static_cast<uint8_t>(ControlEngine::PID);
+    }
+}
+
+void ControllerFactory::select(uint8_t zone, ControlEngine engine) {
+    if (zone > MAX_ZONES) {
+        ESP_LOGW(TAG, "No zone %u", zone);
+        return;
+    }
+    uint8_t previous = engines[zone].exchange(static_cast<uint8_t>(engine));
+    if (previous != static_cast<uint8_t>(engine)) {
+        ESP_LOGI(TAG, "Zone %u uses %s control", zone, getControlEngineName(engine));
+    }
+}
+
+ControlEngine ControllerFactory::getEngine(uint8_t zone) const {
+    return zone <= MAX_ZONES ? static_cast<ControlEngine>(engines[zone].load()) : ControlEngine::PID;
+}
+
+ControlInterface* ControllerFactory::create(ControlEngine engine) const {
+    switch (engine) {
+        case ControlEngine::HYSTERESIS: return hysteresis;
+        default: return pid;
+    }
+}
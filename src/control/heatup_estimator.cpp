@@ -0,0 +1,104 @@
+#include "control/heatup_estimator.h"
+#include <math.h>
+
+// Starting point before anything was learnt: a slow room, 4 K/h at full
+// output and a 4 h time constant
+static const float PRIOR[3] = {4.0f, 0.25f, 0.0f};
+static const float PRIOR_VARIANCE[3] = {100.0f, 0.1f, 10.0f};
+
+// Forgetting stops while the covariance is this large, so that long steady
+// periods without excitation cannot blow it up
+static const float MAX_TRACE = 1000.0f;
+
+// Below this the loss term is treated as zero
+static const float MIN_LOSS = 0.001f;
+static const float MIN_GAIN = 0.01f;
+
+// A target this close to the model's steady state counts as unreachable
+static const float REACH_MARGIN = 0.1f;
+
+HeatupEstimator::HeatupEstimator()
+    : lambda(0.995f)
+    , samples(0) {
+    reset();
+}
+
+void HeatupEstimator::reset() {
+    for (int i = 0; i < N; i++) {
+        theta[i] = PRIOR[i];
+        for (int j = 0; j < N; j++) {
+            P[i][j] = i == j ? PRIOR_VARIANCE[i] : 0.0f;
+        }
+    }
+    samples = 0;
+}
+
+void HeatupEstimator::setForgetting(float value) {
+    lambda = value < 0.9f ? 0.9f : (value > 1.0f ? 1.0f : value);
+}
+
+void HeatupEstimator::sample(float rate, float output, float temperature, float outdoor) {
+    const float phi[N] = {output, -(temperature - outdoor), 1.0f};
+
+    float Pphi[N];
+    float denominator = lambda;
+    for (int i = 0; i < N; i++) {
+        Pphi[i] = 0.0f;
+        for (int j = 0; j < N; j++) {
+            Pphi[i] += P[i][j] * phi[j];
+        }
+        denominator += phi[i] * Pphi[i];
+    }
+
+    float error = rate;
+    for (int i = 0; i < N; i++) {
+        error -= theta[i] * phi[i];
+    }
+
+    float trace = 0.0f;
+    for (int i = 0; i < N; i++) {
+        trace += P[i][i];
+    }
+    float scale = trace < MAX_TRACE ? 1.0f / lambda : 1.0f;
+
+    // P is symmetric, so phi' P is Pphi transposed
+    for (int i = 0; i < N; i++) {
+        float gain = Pphi[i] / denominator;
+        theta[i] += gain * error;
+        for (int j = 0; j < N; j++) {
+            P[i][j] = (P[i][j] - gain * Pphi[j]) * scale;
+        }
+    }
+    samples++;
+}
+
+float HeatupEstimator::predictRate(float output, float temperature, float outdoor) const {
+    return theta[0] * output - theta[1] * (temperature - outdoor) + theta[2];
+}
+
+float HeatupEstimator::hoursToReach(float from, float to, float outdoor) const {
+    if (to <= from) {
+        return 0.0f;
+    }
+
+    float loss = theta[1];
+    if (loss > MIN_LOSS) {
+        float steady = outdoor + (theta[0] + theta[2]) / loss;
+        if (to >= steady - REACH_MARGIN) {
+            return -1.0f;
+        }
+        return logf((steady - from) / (steady - to)) / loss;
+    }
+
+    // Without a usable loss term the slower end of the range decides
+    float rate = fminf(predictRate(1.0f, from, outdoor), predictRate(1.0f, to, outdoor));
+    return rate > 0.0f ? (to - from) / rate : -1.0f;
+}
+
+float HeatupEstimator::holdingOutput(float temperature, float outdoor) const {
+    if (theta[0] < MIN_GAIN) {
+        return 1.0f;
+    }
+    float output = (theta[1] * (temperature - outdoor) - theta[2]) / theta[0];
+    return output < 0.0f ? 0.0f : (output > 1.0f ? 1.0f : output);
+}
@@ -0,0 +1,166 @@
+#include <Arduino.h>
+#include "esp_log.h"
+
+#include "control/hysteresis_controller.h"
+#include "system/core_task.h"
+
+static const char* TAG = "HysteresisController";
+
+// Attempts before configure() yields to a concurrent writer
+static const uint8_t CONFIG_SPIN_LIMIT = 16;
+
+HysteresisController::HysteresisController(ThermostatState* state)
+    : config(DEFAULT_HYSTERESIS_CONFIG)
+    , pendingConfig(DEFAULT_HYSTERESIS_CONFIG)
+    , configSequence(0)
+    , configPending(false)
+    , setpoint(21.0f)
+    , input(0.0f)
+    , output(0.0f)
+    , heating(false)
+    , switches(0)
+    , updateInterval(30000)
+    , lastTime(0)
+    , resetPending(false)
+    , lastError(ThermostatStatus::OK)
+    , thermostatState(state) {
+}
+
+bool HysteresisController::begin() {
+    ESP_LOGI(TAG, "Initializing hysteresis controller");
+    reset();
+    return true;
+}
+
+void HysteresisController::loop() {
+    unsigned long now = millis();
+    if (now - lastTime >= updateInterval) {
+        compute();
+    }
+}
+
+void HysteresisController::setUpdateInterval(unsigned long interval) {
+    updateInterval = interval;
+}
+
+void HysteresisController::setSetpoint(float value) {
+    setpoint = value;
+}
+
+void HysteresisController::setInput(float value) {
+    input = value;
+}
+
+float HysteresisController::getOutput() const {
+    return output;
+}
+
+void HysteresisController::update(float newInput) {
+    setInput(newInput);
+    compute();
+}
+
+bool HysteresisController::isActive() const {
+    return thermostatState->isEnabled();
+}
+
+void HysteresisController::setActive(bool state) {
+    if (state) {
+        resetPending = true;
+    }
+}
+
+ThermostatStatus HysteresisController::getLastError() const {
+    return lastError;
+}
+
+const char* HysteresisController::getLastErrorMessage() const {
+    return lastError == ThermostatStatus::OK ? "" : getThermostatStatusString(lastError);
+}
+
+void HysteresisController::clearError() {
+    lastError = ThermostatStatus::OK;
+}
+
+void HysteresisController::reset() {
+    heating = false;
+    output = 0.0f;
+}
+
+void HysteresisController::configure(const void* configData) {
+    if (!configData) {
+        return;
+    }
+
+    // Sequence lock, writers take it by moving the sequence from even to odd
+    uint8_t attempts = 0;
+    uint32_t sequence = configSequence.load(std::memory_order_relaxed);
+    while ((sequence & 1u) ||
+           !configSequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_relaxed)) {
+        if (++attempts >= CONFIG_SPIN_LIMIT) {
+            CoreTask::sleep(1);
+            attempts = 0;
+        }
+        sequence = configSequence.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    pendingConfig = *static_cast<const HysteresisConfig*>(configData);
+    configSequence.store(sequence + 2, std::memory_order_release);
+
+    // Picked up by the control task on the next computation
+    configPending = true;
+}
+
+bool HysteresisController::readPendingConfig(HysteresisConfig& copy) const {
+    uint32_t before = configSequence.load(std::memory_order_acquire);
+    if (before & 1u) {
+        return false;
+    }
+    copy = pendingConfig;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return configSequence.load(std::memory_order_relaxed) == before;
+}
+
+bool HysteresisController::saveConfig() {
+    // Persisted by the ConfigManager
+    return true;
+}
+
+float HysteresisController::getBand(ThermostatMode mode) const {
+    uint8_t index = static_cast<uint8_t>(mode);
+    return index < THERMOSTAT_MODE_COUNT ? config.bands[index] : 0.0f;
+}
+
+bool HysteresisController::step(bool heating, float setpoint, float input, float band) {
+    float half = band > 0.0f ? band / 2.0f : 0.0f;
+    if (input >= setpoint + half) {
+        return false;
+    }
+    if (input <= setpoint - half) {
+        return true;
+    }
+    return heating;
+}
+
+void HysteresisController::compute() {
+    HysteresisConfig copy;
+    // A read overlapping a write is dropped, the write flags the change again
+    if (configPending.exchange(false) && readPendingConfig(copy)) {
+        config = copy;
+        ESP_LOGI(TAG, "Bands comfort=%.1fK eco=%.1fK away=%.1fK", config.bands[1], config.bands[2], config.bands[3]);
+    }
+    if (resetPending.exchange(false)) {
+        reset();
+    }
+    lastTime = millis();
+
+    bool next = false;
+    if (thermostatState->isEnabled()) {
+        next = step(heating, setpoint, input, getBand(thermostatState->getMode()));
+    }
+    if (next != heating) {
+        heating = next;
+        switches++;
+    }
+    output = heating ? config.onOutput : 0.0f;
+}
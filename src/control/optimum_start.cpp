@@ -0,0 +1,119 @@
+#include "control/optimum_start.h"
+#include <esp_log.h>
+
+static const char* TAG = "OptimumStart";
+
+static const float MS_PER_HOUR = 3600000.0f;
+
+OptimumStart::OptimumStart()
+    : config(DEFAULT_OPTIMUM_START_CONFIG)
+    , setpoint(DEFAULT_OPTIMUM_START_CONFIG.setpoint)
+    , primed(false)
+    , intervalStart(0)
+    , startTemperature(0.0f)
+    , outputTime(0.0f)
+    , lastUpdate(0)
+    , history()
+    , historyIndex(0)
+    , historyCount(0)
+    , scheduled(false)
+    , preheating(false)
+    , deadline(0)
+    , startTime(0)
+    , lastLateness(0) {
+}
+
+void OptimumStart::configure(const OptimumStartConfig& newConfig) {
+    config = newConfig;
+    if (config.interval == 0) config.interval = DEFAULT_OPTIMUM_START_CONFIG.interval;
+    if (config.deadTime > MAX_DEAD_TIME) config.deadTime = MAX_DEAD_TIME;
+    estimator.setForgetting(config.forgetting);
+}
+
+void OptimumStart::schedule(float minutes, unsigned long now) {
+    if (minutes <= 0.0f) {
+        scheduled = false;
+        return;
+    }
+    deadline = now + static_cast<unsigned long>(minutes * 60000.0f);
+    scheduled = !preheating;
+}
+
+unsigned long OptimumStart::predictLead(float temperature, float outdoor) const {
+    float hours = estimator.hoursToReach(temperature, setpoint, outdoor);
+    if (hours < 0.0f) {
+        return config.maxLead;
+    }
+
+    float lead = (hours + static_cast<float>(config.deadTime) * config.interval / MS_PER_HOUR) * MS_PER_HOUR;
+    return lead < config.maxLead ? static_cast<unsigned long>(lead) : config.maxLead;
+}
+
+float OptimumStart::getHoldingOutput(float outdoor) const {
+    return estimator.holdingOutput(setpoint, outdoor) * 100.0f;
+}
+
+void OptimumStart::learn(float temperature, float outdoor, unsigned long now) {
+    unsigned long elapsed = now - intervalStart;
+
+    // A gap in the passes says nothing about the room in between
+    if (!primed || elapsed > 2 * config.interval) {
+        primed = true;
+        intervalStart = now;
+        startTemperature = temperature;
+        outputTime = 0.0f;
+        return;
+    }
+    if (elapsed < config.interval) {
+        return;
+    }
+
+    history[historyIndex] = outputTime / elapsed;
+    historyIndex = (historyIndex + 1) % (MAX_DEAD_TIME + 1);
+    if (historyCount <= config.deadTime) {
+        historyCount++;
+    }
+
+    // The room responds now to the output of deadTime intervals ago
+    if (historyCount > config.deadTime) {
+        uint8_t delayed = (historyIndex + MAX_DEAD_TIME - config.deadTime) % (MAX_DEAD_TIME + 1);
+        float rate = (temperature - startTemperature) * MS_PER_HOUR / elapsed;
+        estimator.sample(rate, history[delayed] / 100.0f, (temperature + startTemperature) / 2.0f, outdoor);
+    }
+
+    intervalStart = now;
+    startTemperature = temperature;
+    outputTime = 0.0f;
+}
+
+PreheatEvent OptimumStart::update(float temperature, float output, float outdoor, unsigned long now) {
+    if (primed) {
+        outputTime += output * static_cast<float>(now - lastUpdate);
+    }
+    lastUpdate = now;
+    learn(temperature, outdoor, now);
+
+    if (preheating) {
+        if (temperature >= setpoint - END_BAND || now - startTime >= config.maxLead) {
+            preheating = false;
+            lastLateness = static_cast<long>(now - deadline);
+            ESP_LOGI(TAG, "Preheat done after %lu min, %ld min %s the comfort time", (now - startTime) / 60000,
+                     (lastLateness < 0 ? -lastLateness : lastLateness) / 60000, lastLateness < 0 ? "before" : "after");
+            return PreheatEvent::END;
+        }
+        return PreheatEvent::NONE;
+    }
+
+    if (scheduled) {
+        unsigned long lead = predictLead(temperature, outdoor);
+        if (static_cast<long>(deadline - now) <= static_cast<long>(lead)) {
+            scheduled = false;
+            preheating = true;
+            startTime = now;
+            ESP_LOGI(TAG, "Preheating from %.1fC to %.1fC, %lu min ahead (gain=%.2fK/h loss=%.3f/h)", temperature,
+                     setpoint, lead / 60000, estimator.getGain(), estimator.getLoss());
+            return PreheatEvent::START;
+        }
+    }
+    return PreheatEvent::NONE;
+}
@@ -0,0 +1,228 @@
+#include "control/pid_autotuner.h"
+#include "system/core_task.h"
+#include <esp_log.h>
+#include <math.h>
+#include <string.h>
+
+static const char* TAG = "PidAutotuner";
+
+// Attempts before a status reader yields to the control task
+static const uint8_t STATUS_SPIN_LIMIT = 16;
+
+static const char* const RULE_NAMES[] = {"ziegler-nichols", "tyreus-luyben", "no-overshoot"};
+
+const char* getAutotuneRuleName(AutotuneRule rule) {
+    return rule < AutotuneRule::COUNT ? RULE_NAMES[static_cast<uint8_t>(rule)] : "unknown";
+}
+
+const char* getAutotuneStateName(AutotuneState state) {
+    switch (state) {
+        case AutotuneState::IDLE: return "idle";
+        case AutotuneState::RUNNING: return "running";
+        case AutotuneState::DONE: return "done";
+        case AutotuneState::FAILED: return "failed";
+        default: return "unknown";
+    }
+}
+
+bool parseAutotuneRule(const char* name, AutotuneRule& rule) {
+    for (uint8_t i = 0; i < static_cast<uint8_t>(AutotuneRule::COUNT); i++) {
+        if (strcmp(name, RULE_NAMES[i]) == 0) {
+            rule = static_cast<AutotuneRule>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+PidAutotuner::PidAutotuner()
+    : state(AutotuneState::IDLE)
+    , rule(AutotuneRule::TYREUS_LUYBEN)
+    , setpoint(0.0f)
+    , bias(0.0f)
+    , amplitude(0.0f)
+    , hysteresis(0.0f)
+    , relayHigh(false)
+    , startTime(0)
+    , cycleStart(0)
+    , cycleMax(0.0f)
+    , cycleMin(0.0f)
+    , cycles(0)
+    , lastPeriod(0.0f)
+    , lastAmplitude(0.0f)
+    , result()
+    , failureReason("")
+    , status()
+    , statusSequence(0) {
+    publish();
+}
+
+void PidAutotuner::start(float newSetpoint, float newBias, float newAmplitude, float newHysteresis,
+                         AutotuneRule newRule, unsigned long now) {
+    state = AutotuneState::RUNNING;
+    rule = newRule;
+    setpoint = newSetpoint;
+    bias = newBias;
+    amplitude = newAmplitude;
+    hysteresis = newHysteresis;
+    relayHigh = true;
+    startTime = now;
+    cycleStart = 0;
+    cycleMax = -INFINITY;
+    cycleMin = INFINITY;
+    cycles = 0;
+    lastPeriod = 0.0f;
+    lastAmplitude = 0.0f;
+    result = AutotuneResult();
+    failureReason = "";
+    publish();
+
+    ESP_LOGI(TAG, "Relay test started: setpoint=%.2f output=%.1f+-%.1f hysteresis=%.2f rule=%s",
+             setpoint, bias, amplitude, hysteresis, getAutotuneRuleName(rule));
+}
+
+void PidAutotuner::cancel() {
+    if (state == AutotuneState::RUNNING) {
+        fail("cancelled");
+    }
+}
+
+float PidAutotuner::update(float input, unsigned long now) {
+    if (state != AutotuneState::RUNNING) {
+        return bias;
+    }
+
+    if (now - startTime > MAX_DURATION) {
+        fail("timeout");
+        return bias;
+    }
+    if (fabsf(input - setpoint) > MAX_DEVIATION) {
+        fail("input out of range");
+        return bias;
+    }
+
+    if (input > cycleMax) cycleMax = input;
+    if (input < cycleMin) cycleMin = input;
+
+    if (relayHigh && input > setpoint + hysteresis) {
+        relayHigh = false;
+    } else if (!relayHigh && input < setpoint - hysteresis) {
+        // A cycle runs from one switch to high to the next
+        relayHigh = true;
+        finishCycle(now);
+    }
+
+    return relayHigh ? bias + amplitude : bias - amplitude;
+}
+
+void PidAutotuner::finishCycle(unsigned long now) {
+    if (cycleStart == 0) {
+        // The first cycle starts from an arbitrary state, discard it
+        cycleStart = now ? now : 1;
+        cycleMax = -INFINITY;
+        cycleMin = INFINITY;
+        return;
+    }
+
+    float period = static_cast<float>(now - cycleStart);
+    float halfSwing = (cycleMax - cycleMin) / 2.0f;
+    cycleStart = now;
+    cycleMax = -INFINITY;
+    cycleMin = INFINITY;
+    cycles++;
+
+    ESP_LOGI(TAG, "Cycle %u: period=%.0fs amplitude=%.3f", cycles, period / 1000.0f, halfSwing);
+
+    bool converged = cycles >= MIN_CYCLES &&
+                     fabsf(period - lastPeriod) <= CONVERGENCE * period &&
+                     fabsf(halfSwing - lastAmplitude) <= CONVERGENCE * halfSwing;
+
+    if (converged || cycles >= MAX_CYCLES) {
+        if (!converged) {
+            ESP_LOGW(TAG, "Oscillation did not settle, using the last two cycles");
+        }
+        float a = (halfSwing + lastAmplitude) / 2.0f;
+        if (a <= hysteresis) {
+            fail("oscillation smaller than hysteresis");
+            return;
+        }
+        result.ultimateGain = 4.0f * amplitude / (static_cast<float>(M_PI) * sqrtf(a * a - hysteresis * hysteresis));
+        result.ultimatePeriod = (period + lastPeriod) / 2.0f;
+        // Published with the gains by computeGains()
+        state = AutotuneState::DONE;
+        ESP_LOGI(TAG, "Relay test done: Ku=%.2f Tu=%.0fs", result.ultimateGain, result.ultimatePeriod / 1000.0f);
+        return;
+    }
+
+    lastPeriod = period;
+    lastAmplitude = halfSwing;
+    publish();
+}
+
+bool PidAutotuner::computeGains(float sampleTime) {
+    if (state != AutotuneState::DONE) {
+        return false;
+    }
+    if (sampleTime <= 0.0f) {
+        fail("invalid sample time");
+        return false;
+    }
+
+    // Proportional gain and integral/derivative times as fractions of Tu
+    float kpFactor, tiFactor, tdFactor;
+    switch (rule) {
+        case AutotuneRule::ZIEGLER_NICHOLS: kpFactor = 0.6f; tiFactor = 0.5f; tdFactor = 0.125f; break;
+        case AutotuneRule::NO_OVERSHOOT: kpFactor = 0.2f; tiFactor = 0.5f; tdFactor = 1.0f / 3.0f; break;
+        case AutotuneRule::TYREUS_LUYBEN:
+        default: kpFactor = 1.0f / 2.2f; tiFactor = 2.2f; tdFactor = 1.0f / 6.3f; break;
+    }
+
+    float kp = kpFactor * result.ultimateGain;
+    float ti = tiFactor * result.ultimatePeriod;
+    float td = tdFactor * result.ultimatePeriod;
+
+    // PIDController gains are per sample
+    result.kp = kp;
+    result.ki = kp * sampleTime / ti;
+    result.kd = kp * td / sampleTime;
+    publish();
+    return true;
+}
+
+void PidAutotuner::fail(const char* reason) {
+    state = AutotuneState::FAILED;
+    failureReason = reason;
+    publish();
+    ESP_LOGW(TAG, "Relay test failed: %s", reason);
+}
+
+void PidAutotuner::publish() {
+    uint32_t sequence = statusSequence.load(std::memory_order_relaxed) + 1;
+    statusSequence.store(sequence, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    status = {state, rule, cycles, result, failureReason};
+    statusSequence.store(sequence + 1, std::memory_order_release);
+}
+
+bool PidAutotuner::readStatus(AutotuneStatus& copy) const {
+    uint32_t before = statusSequence.load(std::memory_order_acquire);
+    if (before & 1u) {
+        return false;
+    }
+    copy = status;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return statusSequence.load(std::memory_order_relaxed) == before;
+}
+
+AutotuneStatus PidAutotuner::getStatus() const {
+    AutotuneStatus copy;
+    uint8_t attempts = 0;
+    while (!readStatus(copy)) {
+        // The control task may be preempted by this task on the same core
+        if (++attempts >= STATUS_SPIN_LIMIT) {
+            CoreTask::sleep(1);
+            attempts = 0;
+        }
+    }
+    return copy;
+}
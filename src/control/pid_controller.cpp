@@ -1,21 +1,47 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <LittleFS.h>
 #include "esp_log.h"
 
 #include "thermostat_state.h"
 #include "control/pid_controller.h"
+#include "system/core_task.h"
 
 static const char* TAG = "PIDController";
 
+// Bounds for the measured interval, in sample times
+static const float MIN_DT_RATIO = 0.01f;
+static const float MAX_DT_RATIO = 4.0f;
+
+// Pending autotune request, START_BASE + rule starts a run
+static const uint8_t AUTOTUNE_NONE = 0;
+static const uint8_t AUTOTUNE_CANCEL = 1;
+static const uint8_t AUTOTUNE_START_BASE = 2;
+
+// Pending setActive() request
+static const uint8_t ACTIVE_NONE = 0;
+static const uint8_t ACTIVE_OFF = 1;
+static const uint8_t ACTIVE_ON = 2;
+
+// Attempts before a configuration reader or writer yields to the other side
+static const uint8_t CONFIG_SPIN_LIMIT = 16;
+
 PIDController::PIDController(ThermostatState* state)
-    : setpoint(21.0f)  // Default room temperature
+    : configSequence(0)
+    , setpoint(21.0f)  // Default room temperature
     , input(0.0f)
     , output(0.0f)
-    , integral(0.0f)
-    , lastInput(0.0f)
+    , heatingCurve(DEFAULT_HEATING_CURVE)
+    , outdoorTemperature(0.0f)
+    , hasOutdoorTemperature(false)
+    , feedForward(0.0f)
+    , feedForwardActive(false)
+    , configPending(false)
+    , hasLastSample(false)
+    , autotuneRequest(AUTOTUNE_NONE)
+    , telemetry(nullptr)
     , lastTime(0)
     , active(false)
+    , activeRequest(ACTIVE_NONE)
     , lastError(ThermostatStatus::OK)
     , thermostatState(state) {
     
@@ -26,6 +52,9 @@ PIDController::PIDController(ThermostatState* state)
     config.minOutput = 0.0f;
     config.maxOutput = 100.0f;
     config.sampleTime = 30000.0f;  // 30 seconds default
+    requestedConfig = config;
+    kernel.setDerivativeFilter(PID_DERIVATIVE_FILTER_SAMPLES);
+    applyConfig();
     
     memset(lastErrorMessage, 0, sizeof(lastErrorMessage));
 }
@@ -37,6 +66,8 @@ bool PIDController::begin() {
 }
 
 void PIDController::loop() {
+    processConfigRequest();
+    processActiveRequest();
     if (!active || !thermostatState->isEnabled()) {
         output = 0;
         return;
@@ -45,17 +76,79 @@ void PIDController::loop() {
     unsigned long now = millis();
     if (now - lastTime >= static_cast<unsigned long>(config.sampleTime)) {
         output = computePID();
-        lastTime = now;
     }
 }
 
 void PIDController::configure(const void* configData) {
     if (configData) {
         const PIDConfig* newConfig = static_cast<const PIDConfig*>(configData);
-        config = *newConfig;
+        uint32_t sequence = beginConfigWrite();
+        requestedConfig = *newConfig;
+        endConfigWrite(sequence);
     }
 }
 
+PIDConfig PIDController::getConfig() const {
+    PIDConfig copy;
+    uint8_t attempts = 0;
+    while (!readRequestedConfig(copy)) {
+        // The writer may be preempted by this task on the same core
+        if (++attempts >= CONFIG_SPIN_LIMIT) {
+            CoreTask::sleep(1);
+            attempts = 0;
+        }
+    }
+    return copy;
+}
+
+// Sequence lock around requestedConfig. Writers take the lock by moving
+// the sequence from even to odd, so configure() calls from two tasks do
+// not interleave.
+uint32_t PIDController::beginConfigWrite() {
+    uint8_t attempts = 0;
+    while (true) {
+        uint32_t sequence = configSequence.load(std::memory_order_relaxed);
+        if ((sequence & 1u) == 0 &&
+            configSequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_relaxed)) {
+            std::atomic_thread_fence(std::memory_order_release);
+            return sequence + 1;
+        }
+        if (++attempts >= CONFIG_SPIN_LIMIT) {
+            CoreTask::sleep(1);
+            attempts = 0;
+        }
+    }
+}
+
+void PIDController::endConfigWrite(uint32_t sequence) {
+    configSequence.store(sequence + 1, std::memory_order_release);
+    // Picked up by the control task on its next pass
+    configPending = true;
+}
+
+bool PIDController::readRequestedConfig(PIDConfig& copy) const {
+    uint32_t before = configSequence.load(std::memory_order_acquire);
+    if (before & 1u) {
+        return false;
+    }
+    copy = requestedConfig;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return configSequence.load(std::memory_order_relaxed) == before;
+}
+
+void PIDController::processConfigRequest() {
+    if (!configPending.exchange(false)) {
+        return;
+    }
+    PIDConfig copy;
+    if (!readRequestedConfig(copy)) {
+        // A write is in progress and flags the change again when it ends
+        return;
+    }
+    config = copy;
+    applyConfig();
+}
+
 void PIDController::setSetpoint(float sp) {
     setpoint = sp;
 }
@@ -64,14 +157,28 @@ void PIDController::setInput(float in) {
     input = in;
 }
 
+void PIDController::setOutdoorTemperature(float temperature) {
+    outdoorTemperature = temperature;
+    hasOutdoorTemperature = true;
+}
+
 float PIDController::getOutput() const {
     return output;
 }
 
 void PIDController::setActive(bool state) {
+    activeRequest = state ? ACTIVE_ON : ACTIVE_OFF;
+}
+
+void PIDController::processActiveRequest() {
+    uint8_t request = activeRequest.exchange(ACTIVE_NONE);
+    if (request == ACTIVE_NONE) {
+        return;
+    }
+    bool state = request == ACTIVE_ON;
     if (active != state) {
         active = state;
-        if (active) {
+        if (state) {
             // Reset integral when activating
             resetIntegral();
         }
@@ -96,7 +203,9 @@ void PIDController::clearError() {
 }
 
 void PIDController::setUpdateInterval(unsigned long interval) {
-    config.sampleTime = static_cast<float>(interval);
+    uint32_t sequence = beginConfigWrite();
+    requestedConfig.sampleTime = static_cast<float>(interval);
+    endConfigWrite(sequence);
 }
 
 void PIDController::reset() {
@@ -109,26 +218,60 @@ bool PIDController::saveConfig() {
 }
 
 float PIDController::computePID() {
-    float error = setpoint - input;
-    float dInput = input - lastInput;
-    
-    integral += (config.ki * error);
-    integral = clamp(integral, config.minOutput, config.maxOutput);
-    
-    float P = config.kp * error;
-    float I = integral;
-    float D = -config.kd * dInput;  // Negative because dInput is backwards
-    
-    float result = P + I + D;
-    result = clamp(result, config.minOutput, config.maxOutput);
-    
-    lastInput = input;
-    return result;
+    // Scale by the actual interval so jitter does not change the loop gains
+    unsigned long now = millis();
+    float dtRatio = 1.0f;
+    if (hasLastSample && config.sampleTime > 0.0f) {
+        dtRatio = clamp((now - lastTime) / config.sampleTime, MIN_DT_RATIO, MAX_DT_RATIO);
+    }
+    lastTime = now;
+    hasLastSample = true;
+
+    // The integral hands over to the feed-forward when it first becomes active
+    bool useFeedForward = hasOutdoorTemperature && heatingCurve.isEnabled();
+    float base = useFeedForward ? heatingCurve.baseOutput(setpoint, outdoorTemperature) : 0.0f;
+    if (useFeedForward && !feedForwardActive) {
+        kernel.offsetIntegral(PidMath::fromFloat(base));
+    }
+    feedForwardActive = useFeedForward;
+    feedForward = base;
+
+    PidMath::Value result = kernel.compute(PidMath::fromFloat(setpoint), PidMath::fromFloat(input),
+                                           PidMath::fromFloat(dtRatio), PidMath::fromFloat(feedForward));
+
+    if (telemetry) {
+        telemetry->push({static_cast<uint32_t>(now), setpoint, input,
+                         PidMath::toFloat(kernel.getProportional()), PidMath::toFloat(kernel.getIntegral()),
+                         PidMath::toFloat(kernel.getDerivative()), feedForward, PidMath::toFloat(result)});
+    }
+    return PidMath::toFloat(result);
 }
 
 void PIDController::resetIntegral() {
-    integral = 0.0f;
-    lastInput = input;
+    kernel.reset(PidMath::fromFloat(input));
+    hasLastSample = false;
+}
+
+void PIDController::restartFrom(float value) {
+    resetIntegral();
+    kernel.offsetIntegral(PidMath::fromFloat(feedForward - value));
+    output = clamp(value, config.minOutput, config.maxOutput);
+}
+
+void PIDController::setOutputLimits(float min, float max) {
+    if (min >= max) {
+        return;
+    }
+    uint32_t sequence = beginConfigWrite();
+    requestedConfig.minOutput = min;
+    requestedConfig.maxOutput = max;
+    endConfigWrite(sequence);
+}
+
+void PIDController::applyConfig() {
+    kernel.setGains(config.kp, config.ki, config.kd);
+    kernel.setOutputLimits(config.minOutput, config.maxOutput);
+    output = clamp(output, config.minOutput, config.maxOutput);
 }
 
 float PIDController::clamp(float value, float min, float max) const {
@@ -138,12 +281,81 @@ float PIDController::clamp(float value, float min, float max) const {
 }
 
 void PIDController::update(float currentTemperature) {
-    if (!thermostatState->isEnabled()) {
+    setInput(currentTemperature);
+    processConfigRequest();
+    processActiveRequest();
+    processAutotuneRequest();
+
+    if (!active || !thermostatState->isEnabled()) {
+        autotuner.cancel();
         output = 0;  // Turn off control when disabled
         return;
     }
-    
-    setInput(currentTemperature);
-    loop();
+
+    if (autotuner.getState() == AutotuneState::RUNNING) {
+        output = autotuner.update(input, millis());
+        if (autotuner.getState() == AutotuneState::DONE) {
+            finishAutotune();
+        } else if (autotuner.getState() == AutotuneState::FAILED) {
+            resetIntegral();
+        }
+        return;
+    }
+
+    // Called once per fresh sample, so compute immediately rather than
+    // waiting for the sampleTime clock used by loop()
+    output = computePID();
 }
 
+void PIDController::startAutotune(AutotuneRule rule) {
+    autotuneRequest = AUTOTUNE_START_BASE + static_cast<uint8_t>(rule);
+}
+
+void PIDController::cancelAutotune() {
+    autotuneRequest = AUTOTUNE_CANCEL;
+}
+
+void PIDController::processAutotuneRequest() {
+    uint8_t request = autotuneRequest.exchange(AUTOTUNE_NONE);
+    if (request == AUTOTUNE_NONE) {
+        return;
+    }
+    if (request == AUTOTUNE_CANCEL) {
+        autotuner.cancel();
+        resetIntegral();
+        return;
+    }
+
+    // Swing the full output range around its middle
+    float bias = (config.minOutput + config.maxOutput) / 2.0f;
+    float amplitude = (config.maxOutput - config.minOutput) / 2.0f;
+    AutotuneRule rule = static_cast<AutotuneRule>(request - AUTOTUNE_START_BASE);
+    autotuner.start(setpoint, bias, amplitude, PID_AUTOTUNE_HYSTERESIS, rule, millis());
+}
+
+void PIDController::finishAutotune() {
+    if (!autotuner.computeGains(config.sampleTime)) {
+        resetIntegral();
+        return;
+    }
+
+    const AutotuneResult& result = autotuner.getResult();
+    config.kp = result.kp;
+    config.ki = result.ki;
+    config.kd = result.kd;
+    applyConfig();
+    resetIntegral();
+
+    // Keep the requested configuration in step for the getters
+    uint32_t sequence = beginConfigWrite();
+    requestedConfig.kp = config.kp;
+    requestedConfig.ki = config.ki;
+    requestedConfig.kd = config.kd;
+    endConfigWrite(sequence);
+
+    ESP_LOGI(TAG, "Autotune applied: Kp=%.3f Ki=%.4f Kd=%.3f", config.kp, config.ki, config.kd);
+
+    if (autotuneCallback) {
+        autotuneCallback(config);
+    }
+}
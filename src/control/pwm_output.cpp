@@ -0,0 +1,82 @@
+#include "control/pwm_output.h"
+#include <esp_log.h>
+
+static const char* TAG = "PwmOutput";
+
+PwmOutput::PwmOutput()
+    : config(DEFAULT_PWM_CONFIG)
+    , duty(0.0f)
+    , on(false)
+    , running(false)
+    , cycleStart(0)
+    , onTime(0.0f)
+    , carry(0.0f)
+    , switches(0)
+    , cycles(0)
+    , merged(0) {
+}
+
+void PwmOutput::configure(const PwmOutputConfig& newConfig) {
+    config = newConfig;
+    if (config.cycleTime == 0) config.cycleTime = DEFAULT_PWM_CONFIG.cycleTime;
+    if (config.accuracy < 0.0f) config.accuracy = 0.0f;
+    if (config.minOnTime + config.minOffTime > config.cycleTime) {
+        ESP_LOGW(TAG, "Minimum on and off times exceed the cycle, only full cycles will be used");
+    }
+
+    ESP_LOGI(TAG, "cycle=%lus minOn=%lus minOff=%lus accuracy=%.1f%%", config.cycleTime / 1000,
+             config.minOnTime / 1000, config.minOffTime / 1000, config.accuracy);
+}
+
+void PwmOutput::setDuty(float percent) {
+    duty = percent < 0.0f ? 0.0f : (percent > 100.0f ? 100.0f : percent);
+}
+
+void PwmOutput::reset() {
+    running = false;
+    on = false;
+    carry = 0.0f;
+    switches = 0;
+    cycles = 0;
+    merged = 0;
+}
+
+void PwmOutput::startCycle(unsigned long now) {
+    float cycle = static_cast<float>(config.cycleTime);
+    float threshold = config.accuracy / 100.0f * cycle;
+    float minOn = config.minOnTime > threshold ? config.minOnTime : threshold;
+    float minOff = config.minOffTime > threshold ? config.minOffTime : threshold;
+
+    float target = duty / 100.0f * cycle + carry;
+    if (target < minOn) {
+        onTime = 0.0f;
+    } else if (cycle - target < minOff) {
+        onTime = cycle;
+    } else {
+        onTime = target;
+    }
+    if (onTime != target && target > 0.0f && target < cycle) {
+        merged.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Only what was deferred by the limits is carried, never more
+    carry = target - onTime;
+    carry = carry > minOn ? minOn : (carry < -minOff ? -minOff : carry);
+
+    cycleStart = now;
+    cycles.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool PwmOutput::update(unsigned long now) {
+    if (!running || now - cycleStart >= config.cycleTime) {
+        startCycle(now);
+        running = true;
+    }
+
+    bool next = static_cast<float>(now - cycleStart) < onTime;
+    if (next != on) {
+        on = next;
+        switches.fetch_add(1, std::memory_order_relaxed);
+    }
+    return on;
+}
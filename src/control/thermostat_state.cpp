@@ -1,49 +1,56 @@
 #include "thermostat_state.h"
+#include "system/core_task.h"
+
+// Reader retries before yielding so a preempted writer can finish
+static const uint8_t SNAPSHOT_SPIN_LIMIT = 16;
 
 ThermostatState::ThermostatState() :
-  currentTemperature(0.0f),
-  currentHumidity(0.0f),
-  currentPressure(0.0f),
-  targetTemperature(ThermostatLimits::DEFAULT_TEMPERATURE),
-  valvePosition(0.0f),
+  currentTemperature(storeTemperature(0.0f)),
+  currentHumidity(storePercent(0.0f)),
+  currentPressure(storePressure(0.0f)),
+  targetTemperature(storeTemperature(ThermostatLimits::DEFAULT_TEMPERATURE)),
+  valvePosition(storePercent(0.0f)),
   operatingMode(ThermostatMode::OFF),
   heatingActive(false),
   status(ThermostatStatus::OK),
-  temperatureCallback(nullptr),
-  humidityCallback(nullptr),
-  pressureCallback(nullptr),
-  targetTemperatureCallback(nullptr),
-  valvePositionCallback(nullptr),
-  modeCallback(nullptr),
-  heatingCallback(nullptr),
-  statusCallback(nullptr),
-  enabled(false) {
+  enabled(false),
+  outdoorTemperature(storeTemperature(0.0f)),
+  flowTemperature(storeTemperature(0.0f)),
+  version(0),
+  writeVersion(0),
+  fieldVersions(),
+  sequence(0),
+  updateDepth(0),
+  pendingChanges(0) {
 }
 
 void ThermostatState::setTemperature(float value) {
-  if (value != currentTemperature) {
-    currentTemperature = value;
-    if (temperatureCallback) {
-      temperatureCallback(value);
-    }
+  TemperatureValue stored = storeTemperature(value);
+  if (stored != currentTemperature) {
+    beginWrite();
+    currentTemperature = stored;
+    endWrite(StateField::TEMPERATURE);
+    fieldChanged(StateField::TEMPERATURE);
   }
 }
 
 void ThermostatState::setHumidity(float value) {
-  if (value != currentHumidity) {
-    currentHumidity = value;
-    if (humidityCallback) {
-      humidityCallback(value);
-    }
+  PercentValue stored = storePercent(value);
+  if (stored != currentHumidity) {
+    beginWrite();
+    currentHumidity = stored;
+    endWrite(StateField::HUMIDITY);
+    fieldChanged(StateField::HUMIDITY);
   }
 }
 
 void ThermostatState::setPressure(float value) {
-  if (value != currentPressure) {
-    currentPressure = value;
-    if (pressureCallback) {
-      pressureCallback(value);
-    }
+  PressureValue stored = storePressure(value);
+  if (stored != currentPressure) {
+    beginWrite();
+    currentPressure = stored;
+    endWrite(StateField::PRESSURE);
+    fieldChanged(StateField::PRESSURE);
   }
 }
 
@@ -52,11 +59,12 @@ void ThermostatState::setTargetTemperature(float value) {
     return;
   }
   
-  if (value != targetTemperature) {
-    targetTemperature = value;
-    if (targetTemperatureCallback) {
-      targetTemperatureCallback(value);
-    }
+  TemperatureValue stored = storeTemperature(value);
+  if (stored != targetTemperature) {
+    beginWrite();
+    targetTemperature = stored;
+    endWrite(StateField::TARGET_TEMPERATURE);
+    fieldChanged(StateField::TARGET_TEMPERATURE);
   }
 }
 
@@ -65,23 +73,68 @@ void ThermostatState::setValvePosition(float value) {
     return;
   }
   
-  if (value != valvePosition) {
-    valvePosition = value;
-    if (valvePositionCallback) {
-      valvePositionCallback(value);
-    }
+  PercentValue stored = storePercent(value);
+  if (stored != valvePosition) {
+    beginWrite();
+    valvePosition = stored;
+    endWrite(StateField::VALVE_POSITION);
+    fieldChanged(StateField::VALVE_POSITION);
   }
 }
 
 void ThermostatState::setMode(ThermostatMode mode) {
   if (mode != operatingMode) {
+    beginWrite();
     operatingMode = mode;
-    if (modeCallback) {
-      modeCallback(mode);
-    }
+    endWrite(StateField::MODE);
+    fieldChanged(StateField::MODE);
+  }
+}
+
+void ThermostatState::setHeating(bool active) {
+  if (active != heatingActive) {
+    beginWrite();
+    heatingActive = active;
+    endWrite(StateField::HEATING);
+    fieldChanged(StateField::HEATING);
+  }
+}
+
+void ThermostatState::setStatus(ThermostatStatus newStatus) {
+  if (newStatus != status) {
+    beginWrite();
+    status = newStatus;
+    endWrite(StateField::STATUS);
+    fieldChanged(StateField::STATUS);
+  }
+}
+
+void ThermostatState::setOutdoorTemperature(float value) {
+  if (!isValidOutdoorTemperature(value)) {
+    return;
+  }
+
+  // The first reading always counts, 0 C is a valid outdoor temperature
+  TemperatureValue stored = storeTemperature(value);
+  if (stored != outdoorTemperature || !hasOutdoorTemperature()) {
+    beginWrite();
+    outdoorTemperature = stored;
+    endWrite(StateField::OUTDOOR_TEMPERATURE);
+    fieldChanged(StateField::OUTDOOR_TEMPERATURE);
   }
 }
 
+void ThermostatState::setFlowTemperature(float value) {
+  if (!isValidFlowTemperature(value)) {
+    return;
+  }
+
+  beginWrite();
+  flowTemperature = storeTemperature(value);
+  endWrite(StateField::FLOW_TEMPERATURE);
+  fieldChanged(StateField::FLOW_TEMPERATURE);
+}
+
 bool ThermostatState::isValidTemperature(float value) const {
   return value >= ThermostatLimits::MIN_TEMPERATURE && value <= ThermostatLimits::MAX_TEMPERATURE;
 }
@@ -98,10 +151,152 @@ bool ThermostatState::isValidValvePosition(float value) const {
   return value >= 0.0f && value <= 100.0f;
 }
 
+bool ThermostatState::isValidOutdoorTemperature(float value) const {
+  return value >= ThermostatLimits::MIN_OUTDOOR_TEMPERATURE && value <= ThermostatLimits::MAX_OUTDOOR_TEMPERATURE;
+}
+
+bool ThermostatState::isValidFlowTemperature(float value) const {
+  return value >= ThermostatLimits::MIN_FLOW_TEMPERATURE && value <= ThermostatLimits::MAX_FLOW_TEMPERATURE;
+}
+
 void ThermostatState::setEnabled(bool state) {
     if (enabled != state) {
+        beginWrite();
         enabled = state;
+        endWrite(StateField::ENABLED);
         ESP_LOGI("ThermostatState", "Thermostat %s", state ? "enabled" : "disabled");
-        // If you have state change callbacks, trigger them here
+        fieldChanged(StateField::ENABLED);
     }
-} 
\ No newline at end of file
+}
+
+void ThermostatState::beginUpdate() {
+  if (updateDepth++ == 0) {
+    beginWrite();
+  }
+}
+
+void ThermostatState::endUpdate() {
+  if (updateDepth == 0 || --updateDepth > 0) {
+    return;
+  }
+  sequence.fetch_add(1, std::memory_order_release);
+
+  uint16_t changes = pendingChanges;
+  pendingChanges = 0;
+  if (changes == 0) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < static_cast<uint8_t>(StateField::COUNT); i++) {
+    StateField field = static_cast<StateField>(i);
+    if (changes & stateFieldBit(field)) {
+      notifyField(field);
+    }
+  }
+  batchListeners.notify(changes);
+}
+
+void ThermostatState::fieldChanged(StateField field) {
+  if (updateDepth > 0) {
+    pendingChanges |= stateFieldBit(field);
+    return;
+  }
+
+  notifyField(field);
+  batchListeners.notify(stateFieldBit(field));
+}
+
+void ThermostatState::notifyField(StateField field) {
+  switch (field) {
+    case StateField::TEMPERATURE: temperatureListeners.notify(loadTemperature(currentTemperature)); break;
+    case StateField::HUMIDITY: humidityListeners.notify(loadPercent(currentHumidity)); break;
+    case StateField::PRESSURE: pressureListeners.notify(loadPressure(currentPressure)); break;
+    case StateField::TARGET_TEMPERATURE: targetTemperatureListeners.notify(loadTemperature(targetTemperature)); break;
+    case StateField::VALVE_POSITION: valvePositionListeners.notify(loadPercent(valvePosition)); break;
+    case StateField::MODE: modeListeners.notify(operatingMode); break;
+    case StateField::HEATING: heatingListeners.notify(heatingActive); break;
+    case StateField::STATUS: statusListeners.notify(status); break;
+    case StateField::ENABLED: enabledListeners.notify(enabled); break;
+    case StateField::OUTDOOR_TEMPERATURE: outdoorTemperatureListeners.notify(loadTemperature(outdoorTemperature)); break;
+    case StateField::FLOW_TEMPERATURE: flowTemperatureListeners.notify(loadTemperature(flowTemperature)); break;
+    default: break;
+  }
+}
+
+void ThermostatState::beginWrite() {
+  // Batched updates keep the sequence odd for the whole batch
+  if (updateDepth > 0 && (sequence.load(std::memory_order_relaxed) & 1u)) {
+    return;
+  }
+  writeVersion = version + 1;
+  sequence.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ThermostatState::endWrite(StateField field) {
+  version = writeVersion;
+  fieldVersions[static_cast<uint8_t>(field)] = writeVersion;
+  if (updateDepth > 0) {
+    return;
+  }
+  sequence.fetch_add(1, std::memory_order_release);
+}
+
+void ThermostatState::readConsistent(ThermostatSnapshot& copy, uint32_t* versions) const {
+  uint8_t attempts = 0;
+
+  while (true) {
+    uint32_t before = sequence.load(std::memory_order_acquire);
+    if ((before & 1u) == 0) {
+      copy.currentTemperature = loadTemperature(currentTemperature);
+      copy.currentHumidity = loadPercent(currentHumidity);
+      copy.currentPressure = loadPressure(currentPressure);
+      copy.targetTemperature = loadTemperature(targetTemperature);
+      copy.valvePosition = loadPercent(valvePosition);
+      copy.mode = operatingMode;
+      copy.heating = heatingActive;
+      copy.status = status;
+      copy.enabled = enabled;
+      copy.outdoorTemperature = loadTemperature(outdoorTemperature);
+      copy.flowTemperature = loadTemperature(flowTemperature);
+      copy.version = version;
+      if (versions) {
+        for (uint8_t i = 0; i < static_cast<uint8_t>(StateField::COUNT); i++) {
+          versions[i] = fieldVersions[i];
+        }
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence.load(std::memory_order_relaxed) == before) {
+        return;
+      }
+    }
+
+    // The writer may be preempted by this task on the same core
+    if (++attempts >= SNAPSHOT_SPIN_LIMIT) {
+      CoreTask::sleep(1);
+      attempts = 0;
+    }
+  }
+}
+
+ThermostatSnapshot ThermostatState::snapshot() const {
+  ThermostatSnapshot copy;
+  readConsistent(copy, nullptr);
+  return copy;
+}
+
+ThermostatDelta ThermostatState::changesSince(uint32_t since) const {
+  ThermostatDelta delta;
+  uint32_t versions[static_cast<uint8_t>(StateField::COUNT)];
+  readConsistent(delta.values, versions);
+
+  bool full = since == 0 || since > delta.values.version;
+  delta.changedFields = 0;
+  for (uint8_t i = 0; i < static_cast<uint8_t>(StateField::COUNT); i++) {
+    if (full || versions[i] > since) {
+      delta.changedFields |= stateFieldBit(static_cast<StateField>(i));
+    }
+  }
+  return delta;
+}
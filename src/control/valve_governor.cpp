@@ -0,0 +1,97 @@
+#include "control/valve_governor.h"
+#include <esp_log.h>
+#include <math.h>
+
+static const char* TAG = "ValveGovernor";
+
+ValveGovernor::ValveGovernor()
+    : config(DEFAULT_VALVE_CONFIG)
+    , hasPosition(false)
+    , commanded(0.0f)
+    , lastSent(0.0f)
+    , lastUpdate(0)
+    , lastSendTime(0)
+    , stats() {
+}
+
+void ValveGovernor::configure(const ValveGovernorConfig& newConfig) {
+    config = newConfig;
+    if (config.step < 0.0f) config.step = 0.0f;
+    if (config.maxSlewRate < 0.0f) config.maxSlewRate = 0.0f;
+    if (config.minDelta < 0.0f) config.minDelta = 0.0f;
+
+    ESP_LOGI(TAG, "step=%.1f%% slew=%.2f%%/s minDelta=%.1f%% refresh=%lus",
+             config.step, config.maxSlewRate, config.minDelta, config.refreshInterval / 1000);
+}
+
+void ValveGovernor::reset() {
+    hasPosition = false;
+    stats = Stats();
+}
+
+float ValveGovernor::quantize(float value) const {
+    if (config.step > 0.0f) {
+        value = roundf(value / config.step) * config.step;
+    }
+    if (value < MIN_POSITION) return MIN_POSITION;
+    if (value > MAX_POSITION) return MAX_POSITION;
+    return value;
+}
+
+ValveAction ValveGovernor::update(float requested, unsigned long now, float& position) {
+    float target = quantize(requested);
+
+    if (!hasPosition) {
+        // First request is sent as is
+        hasPosition = true;
+        commanded = target;
+        lastSent = target;
+        lastUpdate = now;
+        lastSendTime = now;
+        position = target;
+        stats.moves++;
+        return ValveAction::MOVE;
+    }
+
+    // Rate limit, but always make at least one step of progress
+    if (config.maxSlewRate > 0.0f) {
+        float maxMove = config.maxSlewRate * (now - lastUpdate) / 1000.0f;
+        float delta = target - commanded;
+        if (fabsf(delta) > maxMove) {
+            float limited = quantize(commanded + (delta > 0.0f ? maxMove : -maxMove));
+            if (limited == commanded && config.step > 0.0f) {
+                limited = quantize(commanded + (delta > 0.0f ? config.step : -config.step));
+            }
+            target = limited;
+        }
+    }
+    commanded = target;
+    lastUpdate = now;
+
+    bool endStop = target == MIN_POSITION || target == MAX_POSITION;
+    float change = fabsf(target - lastSent);
+    if (change > 0.0f && (change >= config.minDelta || endStop)) {
+        lastSent = target;
+        lastSendTime = now;
+        position = target;
+        stats.moves++;
+        return ValveAction::MOVE;
+    }
+
+    if (config.refreshInterval > 0 && now - lastSendTime >= config.refreshInterval) {
+        // Held long enough: a change below minDelta goes out now, an
+        // unchanged position is resent
+        lastSendTime = now;
+        position = target;
+        if (change > 0.0f) {
+            lastSent = target;
+            stats.moves++;
+            return ValveAction::MOVE;
+        }
+        stats.refreshes++;
+        return ValveAction::REFRESH;
+    }
+
+    stats.suppressed++;
+    return ValveAction::NONE;
+}
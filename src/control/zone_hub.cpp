@@ -0,0 +1,216 @@
+#include "control/zone_hub.h"
+#include "control/hysteresis_controller.h"
+#include "protocol_types.h"
+#include <esp_log.h>
+#include <stdio.h>
+
+static const char* TAG = "ZoneHub";
+
+// Bounds for the measured interval, in sample times
+static const float MIN_DT_RATIO = 0.01f;
+static const float MAX_DT_RATIO = 4.0f;
+
+ZoneHub::ZoneHub()
+    : zoneCount(0)
+    , lastPass(0)
+    , controllers(nullptr)
+    , optimumStartEnabled(false)
+    , outdoorTemperature(0.0f)
+    , hasOutdoorTemperature(false)
+    , setpoints()
+    , inputs()
+    , outputs()
+    , lastReading()
+    , hasReading(0)
+    , primed(0)
+    , heating(0)
+    , names() {
+    config.kp = 2.0f;
+    config.ki = 0.5f;
+    config.kd = 1.0f;
+    config.minOutput = 0.0f;
+    config.maxOutput = 100.0f;
+    config.sampleTime = 30000.0f;
+    bank.setDerivativeFilter(PID_DERIVATIVE_FILTER_SAMPLES);
+}
+
+bool ZoneHub::addZone(const char* name, float setpoint, bool enabled) {
+    if (zoneCount >= MAX_ZONES) {
+        ESP_LOGE(TAG, "Zone limit of %u reached, ignoring %s", MAX_ZONES, name);
+        return false;
+    }
+
+    uint8_t index = zoneCount++;
+    snprintf(names[index], sizeof(names[index]), "%s", name);
+    states[index].setTargetTemperature(setpoint);
+    states[index].setEnabled(enabled);
+    starts[index].setSetpoint(setpoint);
+    bank.setGains(index, config.kp, config.ki, config.kd);
+
+    ESP_LOGI(TAG, "Zone %u: %s setpoint=%.1f%s", zoneNumber(index), names[index], setpoint,
+             enabled ? "" : " (disabled)");
+    return true;
+}
+
+void ZoneHub::configure(const PIDConfig& newConfig) {
+    config = newConfig;
+    bank.setOutputLimits(config.minOutput, config.maxOutput);
+    for (uint8_t i = 0; i < MAX_ZONES; i++) {
+        bank.setGains(i, config.kp, config.ki, config.kd);
+    }
+}
+
+void ZoneHub::setValveConfig(const ValveGovernorConfig& valveConfig) {
+    for (uint8_t i = 0; i < MAX_ZONES; i++) {
+        governors[i].configure(valveConfig);
+    }
+}
+
+void ZoneHub::setOptimumStartConfig(const OptimumStartConfig& startConfig) {
+    optimumStartEnabled = startConfig.enabled;
+    for (uint8_t i = 0; i < MAX_ZONES; i++) {
+        starts[i].configure(startConfig);
+    }
+}
+
+void ZoneHub::setOutdoorTemperature(float temperature) {
+    outdoorTemperature = temperature;
+    hasOutdoorTemperature = true;
+}
+
+bool ZoneHub::handleCommand(uint8_t zone, CommandType type, float value, unsigned long now) {
+    if (zone == 0 || zone > zoneCount) {
+        ESP_LOGW(TAG, "%s for unknown zone %u", getCommandTypeName(type), zone);
+        return false;
+    }
+
+    uint8_t index = zoneIndex(zone);
+    switch (type) {
+        case CommandType::CMD_SET_TEMPERATURE:
+            states[index].setCurrentTemperature(value);
+            lastReading[index] = now;
+            hasReading |= 1u << index;
+            return true;
+        case CommandType::CMD_SETPOINT:
+            states[index].setTargetTemperature(value);
+            return true;
+        case CommandType::CMD_MODE:
+            states[index].setMode(static_cast<ThermostatMode>(static_cast<int>(value)));
+            return true;
+        case CommandType::CMD_ENABLE:
+            states[index].setEnabled(value != 0.0f);
+            return true;
+        case CommandType::CMD_COMFORT_TIME:
+            if (!optimumStartEnabled) {
+                ESP_LOGW(TAG, "Optimum start disabled, ignoring comfort time for zone %u", zone);
+                return false;
+            }
+            starts[index].schedule(value, now);
+            return true;
+        default:
+            ESP_LOGW(TAG, "Unsupported command for zone %u: %s", zone, getCommandTypeName(type));
+            return false;
+    }
+}
+
+bool ZoneHub::isReady(uint8_t index, unsigned long now) const {
+    return (hasReading & (1u << index)) && states[index].isEnabled() &&
+           now - lastReading[index] <= READING_TIMEOUT;
+}
+
+float ZoneHub::updateHysteresis(uint8_t index) {
+    const HysteresisController* hysteresis = controllers->getHysteresis();
+    uint16_t bit = 1u << index;
+
+    bool on = HysteresisController::step(heating & bit, states[index].getTargetTemperature(),
+                                         states[index].getCurrentTemperature(),
+                                         hysteresis->getBand(states[index].getMode()));
+    heating = on ? (heating | bit) : (heating & ~bit);
+    return on ? hysteresis->getConfig().onOutput : 0.0f;
+}
+
+void ZoneHub::updateOptimumStart(uint8_t index, unsigned long now) {
+    float outdoor = hasOutdoorTemperature ? outdoorTemperature : 0.0f;
+    switch (starts[index].update(states[index].getCurrentTemperature(), states[index].getValvePosition(), outdoor, now)) {
+        case PreheatEvent::START:
+            states[index].setTargetTemperature(starts[index].getSetpoint());
+            setpoints[index] = PidMath::fromFloat(starts[index].getSetpoint());
+            if (setpointCallback) {
+                setpointCallback(zoneNumber(index), starts[index].getSetpoint());
+            }
+            break;
+        case PreheatEvent::END:
+            // Continue from the learnt output that holds the setpoint
+            bank.reset(index, inputs[index]);
+            bank.offsetIntegral(index, PidMath::fromFloat(-starts[index].getHoldingOutput(outdoor)));
+            break;
+        default:
+            break;
+    }
+}
+
+void ZoneHub::update(unsigned long now) {
+    if (zoneCount == 0) {
+        return;
+    }
+
+    float dtRatio = 1.0f;
+    if (lastPass != 0) {
+        dtRatio = static_cast<float>(now - lastPass) / config.sampleTime;
+        dtRatio = dtRatio < MIN_DT_RATIO ? MIN_DT_RATIO : (dtRatio > MAX_DT_RATIO ? MAX_DT_RATIO : dtRatio);
+    }
+    lastPass = now ? now : 1;
+
+    // Gather, starting the derivative of newly ready zones from their input
+    uint16_t ready = 0;
+    for (uint8_t i = 0; i < zoneCount; i++) {
+        inputs[i] = PidMath::fromFloat(states[i].getCurrentTemperature());
+        setpoints[i] = PidMath::fromFloat(states[i].getTargetTemperature());
+        if (isReady(i, now)) {
+            ready |= 1u << i;
+            if (!(primed & (1u << i))) {
+                bank.reset(i, inputs[i]);
+            }
+            if (optimumStartEnabled) {
+                updateOptimumStart(i, now);
+            }
+        }
+    }
+    primed = ready;
+
+    bank.compute(setpoints, inputs, PidMath::fromFloat(dtRatio), outputs, zoneCount);
+
+    // Scatter through the valve governors
+    for (uint8_t i = 0; i < zoneCount; i++) {
+        uint16_t bit = 1u << i;
+        float requested = 0.0f;
+        if (!(ready & bit)) {
+            // Closed valve, and no windup while the zone is not controlled
+            bank.reset(i, inputs[i]);
+            heating &= ~bit;
+        } else if (starts[i].isPreheating()) {
+            requested = config.maxOutput;
+        } else if (controllers && controllers->getEngine(zoneNumber(i)) == ControlEngine::HYSTERESIS) {
+            // The PID stays idle while the zone switches on and off
+            bank.reset(i, inputs[i]);
+            requested = updateHysteresis(i);
+        } else {
+            requested = PidMath::toFloat(outputs[i]);
+        }
+
+        float position;
+        switch (governors[i].update(requested, now, position)) {
+            case ValveAction::MOVE:
+                states[i].setValvePosition(position);
+                break;
+            case ValveAction::REFRESH:
+                break;
+            default:
+                continue;
+        }
+        states[i].setHeating(position > 0.0f);
+        if (valveCallback) {
+            valveCallback(zoneNumber(i), position);
+        }
+    }
+}
@@ -16,21 +16,154 @@
 #include "communication/knx/knx_interface.h"
 #include "sensors/bme280_sensor_interface.h"
 #include "control/pid_controller.h"
+#include "control/control_pipeline.h"
+#include "control/zone_hub.h"
+#include "control/hysteresis_controller.h"
+#include "control/controller_factory.h"
+#include "control/optimum_start.h"
 #include "web_interface.h"
+#include "system/task_scheduler.h"
+#include "system/core_task.h"
+#include "system/loop_profiler.h"
 #include "main.h"
 
 static const char* TAG = "Main";
 
+// Task periods in milliseconds
+static const unsigned long KNX_TASK_PERIOD = 2;          // Keep telegram latency low
+static const unsigned long PROTOCOL_TASK_PERIOD = 20;
+static const unsigned long COMMAND_TASK_PERIOD = 10;
+static const unsigned long PWM_TASK_PERIOD = 1000;        // Switching resolution of the on/off output
+static const unsigned long FAILSAFE_TASK_PERIOD = 10000;  // Checks that sensor samples still arrive
+static const unsigned long WEB_TASK_PERIOD = 100;
+static const unsigned long STATS_TASK_PERIOD = 300000;    // Log scheduler statistics every 5 minutes
+static const unsigned long MAX_IDLE_DELAY = 100;
+
+// Pinned task settings
+static const uint32_t CONTROL_TASK_STACK = 4096;
+static const uint32_t NETWORK_TASK_STACK = 8192;
+static const unsigned CORE_TASK_PRIORITY = 1;
+
 // Global objects
 ConfigManager configManager;
 ThermostatState thermostatState;
 ProtocolManager protocolManager(&thermostatState);
 BME280SensorInterface sensorInterface;
 PIDController pidController(&thermostatState);
+HysteresisController hysteresisController(&thermostatState);
+ControllerFactory controllerFactory(&pidController, &hysteresisController);
+ControlPipeline controlPipeline(&thermostatState, &pidController);
+ValveGovernor valveGovernor;
+ZoneHub zoneHub;
+PwmOutput pwmOutput;
+CascadeController cascadeController;
+OptimumStart optimumStart;
+PidTelemetry pidTelemetry;
 WebInterface webInterface(&configManager, &sensorInterface, &pidController, &thermostatState, &protocolManager);
 KNXInterface knxInterface(&thermostatState);
 MQTTInterface mqttInterface(&thermostatState);
 
+// Control path (sensor, PID, state) runs on one core, protocol I/O on the other.
+// They only exchange data through the ProtocolManager queues.
+TaskScheduler controlScheduler(millis);
+TaskScheduler networkScheduler(millis);
+
+static void sensorTask() {
+    // A fresh sample drives one pass of the control pipeline
+    sensorInterface.updateReadings();
+}
+
+static void setupSchedulers() {
+    // Control core, sampling at the PID rate keeps sensor and controller in phase
+    controlScheduler.addTask("sensor", static_cast<unsigned long>(pidController.getSampleTime()), sensorTask);
+    if (zoneHub.getZoneCount() > 0) {
+        controlScheduler.addTask("zones", static_cast<unsigned long>(zoneHub.getSampleTime()), []() {
+            PROFILE_PHASE(LoopPhase::PID);
+            if (thermostatState.hasOutdoorTemperature()) {
+                zoneHub.setOutdoorTemperature(thermostatState.getOutdoorTemperature());
+            }
+            zoneHub.update(millis());
+        });
+    }
+    controlScheduler.addTask("failsafe", FAILSAFE_TASK_PERIOD, []() { controlPipeline.checkSamples(millis()); });
+    controlScheduler.addTask("commands", COMMAND_TASK_PERIOD, []() {
+        PROFILE_PHASE(LoopPhase::COMMANDS);
+        protocolManager.processCommands();
+    });
+    if (cascadeController.getConfig().enabled) {
+        controlScheduler.addTask("cascade", cascadeController.getConfig().sampleTime, []() {
+            PROFILE_PHASE(LoopPhase::PID);
+            controlPipeline.onCascadeTick(millis());
+        });
+    }
+    if (pwmOutput.getConfig().enabled) {
+        controlScheduler.addTask("pwm", PWM_TASK_PERIOD, []() {
+            thermostatState.setHeating(pwmOutput.update(millis()));
+        });
+    }
+    controlScheduler.addTask("stats", STATS_TASK_PERIOD, []() {
+        controlScheduler.logStats();
+        const ValveGovernor::Stats& valve = valveGovernor.getStats();
+        ESP_LOGI(TAG, "Valve moves=%u suppressed=%u refreshes=%u", valve.moves, valve.suppressed, valve.refreshes);
+        ESP_LOGI(TAG, "Commands dropped=%u", static_cast<unsigned>(protocolManager.getDroppedCommandCount()));
+        if (pwmOutput.getConfig().enabled) {
+            PwmOutput::Stats pwm = pwmOutput.getStats();
+            ESP_LOGI(TAG, "PWM switches=%u cycles=%u merged=%u", pwm.switches, pwm.cycles, pwm.merged);
+        }
+        if (optimumStart.getConfig().enabled) {
+            const HeatupEstimator& model = optimumStart.getEstimator();
+            ESP_LOGI(TAG, "Heat-up gain=%.2fK/h loss=%.3f/h bias=%.2fK/h samples=%u", model.getGain(), model.getLoss(),
+                     model.getBias(), model.getSampleCount());
+        }
+    });
+
+    // Network core
+    networkScheduler.addTask("web", WEB_TASK_PERIOD, []() {
+        PROFILE_PHASE(LoopPhase::WEB);
+        webInterface.loop();
+    });
+    if (configManager.getKnxEnabled()) {
+        networkScheduler.addTask("knx", KNX_TASK_PERIOD, []() {
+            PROFILE_PHASE(LoopPhase::KNX);
+            knxInterface.loop();
+        });
+    }
+    networkScheduler.addTask("protocols", PROTOCOL_TASK_PERIOD, []() {
+        PROFILE_PHASE(LoopPhase::PROTOCOLS);
+        protocolManager.update();
+    });
+    networkScheduler.addTask("outbound", protocolManager.getOutboundConfig().interval, []() {
+        PROFILE_PHASE(LoopPhase::OUTBOUND);
+        protocolManager.flushOutbound();
+    });
+    networkScheduler.addTask("stats", STATS_TASK_PERIOD, []() {
+        networkScheduler.logStats();
+        ProtocolManager::OutboundStats outbound = protocolManager.getOutboundStats();
+        ESP_LOGI(TAG, "Outbound updates=%u coalesced=%u sent=%u dropped=%u echoes=%u", outbound.updates,
+                 outbound.coalesced, outbound.sent, outbound.dropped, outbound.echoes);
+        if (mqttInterface.isEnabled()) {
+            const MqttBacklog::Stats& backlog = mqttInterface.getBacklogStats();
+            ESP_LOGI(TAG, "MQTT backlog waiting=%u stored=%u spilled=%u replayed=%u dropped=%u",
+                     static_cast<unsigned>(mqttInterface.getBacklogSize()), backlog.stored, backlog.spilled,
+                     backlog.replayed, backlog.dropped);
+        }
+    });
+}
+
+static void runScheduler(void* arg) {
+    TaskScheduler* scheduler = static_cast<TaskScheduler*>(arg);
+    for (;;) {
+        scheduler->runDue();
+
+        // Sleep until the next task is due instead of polling on a fixed quantum
+        unsigned long idle = scheduler->timeUntilNextDeadline();
+        if (idle > MAX_IDLE_DELAY) {
+            idle = MAX_IDLE_DELAY;
+        }
+        CoreTask::sleep(idle > 0 ? idle : 1);
+    }
+}
+
 void setup() {
     // Initialize serial communication
     Serial.begin(115200);
@@ -72,16 +205,104 @@ void setup() {
     if (!sensorInterface.begin()) {
         Serial.println("BME280 sensor not available - continuing with other functionality");
         ESP_LOGW(TAG, "System will operate without temperature/humidity/pressure readings");
+
+        // Sensor not available - use default values
+        // This allows the system to continue functioning with default values
+        thermostatState.setCurrentTemperature(21.0); // Default room temperature
+        thermostatState.setCurrentHumidity(50.0);    // Default humidity
+        thermostatState.setCurrentPressure(1013.25); // Default pressure (sea level)
     } else {
         ESP_LOGI(TAG, "BME280 sensor initialized successfully");
     }
 
-    // Initialize PID controller
+    // Initialize PID controller with the stored gains and heating curve
+    pidController.configure(&configManager.getPidConfig());
+    pidController.setHeatingCurve(configManager.getHeatingCurve());
     if (!pidController.begin()) {
         Serial.println("Failed to initialize PID controller");
         return;
     }
 
+    // The engine of the device and of each zone may change at runtime
+    hysteresisController.configure(&configManager.getHysteresisConfig());
+    hysteresisController.begin();
+    controllerFactory.select(0, configManager.getControlEngine());
+    controlPipeline.setControllerFactory(&controllerFactory);
+    webInterface.setControllerFactory(&controllerFactory);
+
+    // PID terms for the /telemetry stream
+    pidController.setTelemetry(&pidTelemetry);
+    webInterface.setTelemetry(&pidTelemetry);
+    webInterface.setPwmOutput(&pwmOutput);
+
+    // Persist autotuned gains
+    pidController.onAutotuneComplete([](const PIDConfig& config) {
+        configManager.setPidConfig(config);
+        if (!configManager.saveConfig()) {
+            ESP_LOGE(TAG, "Failed to save autotuned PID configuration");
+        }
+    });
+
+    // Only valve changes worth a telegram reach the state
+    valveGovernor.configure(configManager.getValveConfig());
+    controlPipeline.setValveGovernor(&valveGovernor);
+
+    // Without samples the valve goes to a safe position instead of staying where it was
+    controlPipeline.setFailsafe(configManager.getFailsafeConfig());
+
+    // Two-point actuators switch the heating state in a time-proportional pattern
+    pwmOutput.configure(configManager.getPwmConfig());
+    if (pwmOutput.getConfig().enabled) {
+        controlPipeline.setPwmOutput(&pwmOutput);
+    }
+
+    // Flow temperature loop between the room controller and the valve
+    cascadeController.configure(configManager.getCascadeConfig());
+    if (cascadeController.getConfig().enabled) {
+        controlPipeline.setCascade(&cascadeController);
+        thermostatState.onFlowTemperatureChange([](float temperature) {
+            cascadeController.setFlowTemperature(temperature, millis());
+        });
+    }
+
+    // Comfort times preheat from the learnt heat-up rate of each room
+    const OptimumStartConfig& startConfig = configManager.getOptimumStartConfig();
+    optimumStart.configure(startConfig);
+    optimumStart.setSetpoint(startConfig.setpoint);
+    if (startConfig.enabled) {
+        controlPipeline.setOptimumStart(&optimumStart);
+        controlPipeline.onSetpointChange([](float setpoint) { protocolManager.sendSetpoint(setpoint); });
+        protocolManager.onComfortTime([](float minutes) { optimumStart.schedule(minutes, millis()); });
+    }
+
+    // Rooms driven by this device besides its own share the PID and valve settings
+    zoneHub.configure(configManager.getPidConfig());
+    zoneHub.setValveConfig(configManager.getValveConfig());
+    for (uint8_t i = 0; i < configManager.getZoneCount(); i++) {
+        const ZoneConfig& zone = configManager.getZone(i);
+        zoneHub.addZone(zone.name, zone.setpoint, zone.enabled);
+        controllerFactory.select(ZoneHub::zoneNumber(i), zone.engine);
+    }
+    zoneHub.setControllerFactory(&controllerFactory);
+    zoneHub.setOptimumStartConfig(startConfig);
+    zoneHub.onSetpointChange([](uint8_t zone, float setpoint) {
+        protocolManager.sendZoneSetpoint(zone, setpoint);
+    });
+    zoneHub.onValveChange([](uint8_t zone, float position) {
+        protocolManager.sendZoneValvePosition(zone, position);
+    });
+    protocolManager.onZoneCommand([](const ProtocolCommand& command) {
+        zoneHub.handleCommand(command.zone, command.type, command.value, millis());
+    });
+
+    // Every fresh sensor sample runs one control pipeline pass
+    sensorInterface.onNewSample([](float temperature, float humidity, float pressure) {
+        controlPipeline.onSample(temperature, humidity, pressure);
+    });
+
+    // Bursts of changes reach the protocols as their newest values, paced
+    protocolManager.configureOutbound(configManager.getOutboundConfig());
+
     // Initialize protocol manager
     if (!protocolManager.begin()) {
         Serial.println("Failed to initialize protocol manager");
@@ -96,6 +317,17 @@ void setup() {
             mqttInterface.setCredentials(configManager.getMQTTUser(), configManager.getMQTTPassword());
         }
         
+        for (uint8_t i = 0; i < zoneHub.getZoneCount(); i++) {
+            const char* prefix = configManager.getZone(i).mqttPrefix;
+            if (prefix[0] != '\0') {
+                mqttInterface.setZoneTopicPrefix(ZoneHub::zoneNumber(i), prefix);
+            }
+        }
+        
+        mqttInterface.setOutdoorTemperatureTopic(configManager.getMQTTOutdoorTopic());
+        mqttInterface.setBacklogConfig(configManager.getMqttBacklogConfig());
+        mqttInterface.setEnabled(true);
+        
         // Add to protocol manager
         mqttInterface.begin();
         protocolManager.addProtocol(&mqttInterface);
@@ -115,6 +347,32 @@ void setup() {
         
         // Add more KNX configuration...
         knxInterface.configure(knxConfig);
+        const KNXPhysicalAddress& heating = configManager.getKnxHeatingGA();
+        if (heating.area || heating.line || heating.member) {
+            knxInterface.setHeatingStateGA({heating.area, heating.line, heating.member});
+        }
+        const KNXPhysicalAddress& flow = configManager.getKnxFlowGA();
+        if (flow.area || flow.line || flow.member) {
+            knxInterface.setFlowTemperatureGA({flow.area, flow.line, flow.member});
+        }
+        const KNXPhysicalAddress& comfort = configManager.getKnxComfortGA();
+        if (comfort.area || comfort.line || comfort.member) {
+            knxInterface.setComfortTimeGA({comfort.area, comfort.line, comfort.member});
+        }
+        const KNXPhysicalAddress& outdoor = configManager.getKnxOutdoorGA();
+        if (outdoor.area || outdoor.line || outdoor.member) {
+            knxInterface.setOutdoorTemperatureGA({outdoor.area, outdoor.line, outdoor.member});
+        }
+        for (uint8_t i = 0; i < zoneHub.getZoneCount(); i++) {
+            const ZoneConfig& zone = configManager.getZone(i);
+            KnxZoneAddresses addresses = {
+                {zone.temperatureGA.area, zone.temperatureGA.line, zone.temperatureGA.member},
+                {zone.setpointGA.area, zone.setpointGA.line, zone.setpointGA.member},
+                {zone.valveGA.area, zone.valveGA.line, zone.valveGA.member},
+                {zone.comfortGA.area, zone.comfortGA.line, zone.comfortGA.member}
+            };
+            knxInterface.setZoneGroupAddresses(ZoneHub::zoneNumber(i), addresses);
+        }
         protocolManager.addProtocol(&knxInterface);
         Serial.println("KNX interface configured and added");
     }
@@ -122,49 +380,28 @@ void setup() {
     // Initialize web server
     webInterface.begin();
 
+    // Publish locally produced state changes; these fire on the control task
+    thermostatState.onTemperatureChange([](float value) { protocolManager.sendTemperature(value); });
+    thermostatState.onValvePositionChange([](float value) { protocolManager.sendValvePosition(value); });
+    thermostatState.onHeatingChange([](bool heating) { protocolManager.sendHeatingState(heating); });
+
+#ifdef LOOP_PROFILER
+    LoopProfiler::reset();
+#endif
+
+    // Register periodic work and start the pinned tasks
+    setupSchedulers();
+    CoreTask::start("control", runScheduler, &controlScheduler, CoreTask::CONTROL_CORE,
+                    CONTROL_TASK_STACK, CORE_TASK_PRIORITY);
+    CoreTask::start("network", runScheduler, &networkScheduler, CoreTask::NETWORK_CORE,
+                    NETWORK_TASK_STACK, CORE_TASK_PRIORITY);
 
     ESP_LOGI(TAG, "ESP32 KNX Thermostat initialized successfully");
 }
 
 void loop() {
-    // Update sensor readings if available
-    if (sensorInterface.isAvailable()) {
-        sensorInterface.loop();
-        
-        // Update thermostat state with sensor readings
-        thermostatState.setCurrentTemperature(sensorInterface.getTemperature());
-        thermostatState.setCurrentHumidity(sensorInterface.getHumidity());
-        thermostatState.setCurrentPressure(sensorInterface.getPressure());
-    } else {
-        // Sensor not available - use default values
-        // This allows the system to continue functioning with default values
-        thermostatState.setCurrentTemperature(21.0); // Default room temperature
-        thermostatState.setCurrentHumidity(50.0);    // Default humidity
-        thermostatState.setCurrentPressure(1013.25); // Default pressure (sea level)
-    }
-
-    // Update web interface
-    webInterface.loop();
-
-    // Update KNX interface if enabled
-    if (configManager.getKnxEnabled()) {
-        knxInterface.loop();
-    }
-
-    // Update PID controller
-    pidController.update(sensorInterface.getTemperature());
-
-    // Update thermostat state
-    thermostatState.setCurrentTemperature(sensorInterface.getTemperature());
-    thermostatState.setCurrentHumidity(sensorInterface.getHumidity());
-    thermostatState.setCurrentPressure(sensorInterface.getPressure());
-    thermostatState.setValvePosition(pidController.getOutput());
-
-    // Handle protocol updates
-    protocolManager.update();
-
-    // Small delay to prevent tight looping
-    delay(10);
+    // All periodic work runs in the pinned control and network tasks
+    CoreTask::sleep(1000);
 }
 
 void testSaveConfig() {
@@ -0,0 +1,443 @@
+// Entry point for the native (host) build.
+//
+// Runs the control core of the firmware - sensor, control pipeline, PID and
+// thermostat state - against the NativeHal room model on a simulated clock.
+// Protocol, web and config components build against the stand-ins as well
+// and are covered by the tests, but the simulator does not start them.
+// Set NATIVE_AUTOTUNE to a tuning rule to exercise the relay autotuner end
+// to end. NATIVE_OUTDOOR_STEP=<seconds>:<temperature>
+// drops the outdoor temperature during the run and reports how the room
+// recovers; NATIVE_HEATING_CURVE=<slope>[:<offset>] enables feed-forward.
+// NATIVE_PWM=<cycle s>[:<min on/off s>[:<accuracy %>]] heats the room with
+// on/off pulses instead of the valve position. NATIVE_ENGINE=hysteresis
+// selects two-point control, NATIVE_ROOM_TAU=<seconds> slows the room down
+// like an underfloor heating; every run reports comfort and heater starts.
+// NATIVE_FLOW=<supply C> puts a heating circuit between valve and room,
+// NATIVE_SUPPLY_STEP=<seconds>:<temperature> changes its supply temperature
+// and NATIVE_CASCADE=<kp>:<ki> closes a flow temperature loop under the PID.
+// NATIVE_COMFORT=<setback C>[:<night h>[:<outdoor swing K>]] sets the room
+// back every evening and schedules comfort for the morning, then reports how
+// close to that time optimum start reached the setpoint each day.
+// NATIVE_SENSOR_FAULT=<seconds>:<duration s> makes the BME280 fail for a
+// while and reports the valve position the failsafe held meanwhile.
+// Left out of `pio test`, whose tests under test/ bring their own main().
+
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <cstdlib>
+#include "thermostat_state.h"
+#include "sensors/bme280_sensor_interface.h"
+#include "control/pid_controller.h"
+#include "control/control_pipeline.h"
+#include "control/hysteresis_controller.h"
+#include "control/controller_factory.h"
+#include "control/optimum_start.h"
+#include "system/task_scheduler.h"
+#include "system/core_task.h"
+
+static const char* TAG = "Native";
+
+static const float DEFAULT_TIME_SCALE = 1000.0f;
+static const unsigned long DEFAULT_SIM_SECONDS = 6 * 3600;
+static const unsigned long STATUS_TASK_PERIOD = 600000;
+static const unsigned long OUTDOOR_TASK_PERIOD = 600000;  // Like a weather station on the bus
+static const float RECOVERY_BAND = 0.2f;
+static const unsigned long COMFORT_WARMUP = 2 * 3600000UL;  // Ignore the initial heat-up
+static const unsigned long MAX_IDLE_DELAY = 100;
+static const unsigned long PWM_TASK_PERIOD = 1000;
+static const unsigned long FLOW_TASK_PERIOD = 10000;  // Like a KNX flow sensor sending cyclically
+static const unsigned long FAILSAFE_TASK_PERIOD = 10000;
+static const unsigned long DAY = 24 * 3600000UL;
+static const unsigned long FIRST_SETBACK = 4 * 3600000UL;
+static const int MAX_NIGHTS = 32;
+
+ThermostatState thermostatState;
+BME280SensorInterface sensorInterface;
+PIDController pidController(&thermostatState);
+HysteresisController hysteresisController(&thermostatState);
+ControllerFactory controllerFactory(&pidController, &hysteresisController);
+ControlPipeline controlPipeline(&thermostatState, &pidController);
+ValveGovernor valveGovernor;
+PwmOutput pwmOutput;
+CascadeController cascadeController;
+OptimumStart optimumStart;
+TaskScheduler controlScheduler(millis);
+
+static float getEnvFloat(const char* name, float fallback) {
+    const char* value = getenv(name);
+    return value ? static_cast<float>(atof(value)) : fallback;
+}
+
+// Room response to an outdoor or supply temperature step
+struct Disturbance {
+    unsigned long time;
+    float value;
+    bool supply;                  // Steps the supply instead of the outdoor temperature
+    bool applied;
+    float maxBelow;               // Largest drop below the setpoint
+    float maxAbove;               // Largest overshoot above the setpoint
+    unsigned long lastOutside;    // Last time outside the recovery band
+};
+static Disturbance disturbance = {0, 0.0f, false, false, 0.0f, 0.0f, 0};
+
+static void trackDisturbance() {
+    unsigned long now = millis();
+    if (!disturbance.applied) {
+        if (now >= disturbance.time) {
+            if (disturbance.supply) {
+                NativeHal::setSupplyTemperature(disturbance.value);
+            } else {
+                NativeHal::setOutdoorTemperature(disturbance.value);
+            }
+            disturbance.applied = true;
+            disturbance.lastOutside = now;
+            ESP_LOGI(TAG, "%s temperature stepped to %.1fC", disturbance.supply ? "Supply" : "Outdoor", disturbance.value);
+        }
+        return;
+    }
+
+    float error = thermostatState.getCurrentTemperature() - thermostatState.getTargetTemperature();
+    if (-error > disturbance.maxBelow) disturbance.maxBelow = -error;
+    if (error > disturbance.maxAbove) disturbance.maxAbove = error;
+    if (fabsf(error) > RECOVERY_BAND) disturbance.lastOutside = now;
+}
+
+// Deviation from the setpoint after warm-up, and how often the heater starts
+struct Comfort {
+    double absError;
+    float maxError;
+    unsigned long samples;
+    uint32_t starts;      // Heating power going from zero to non-zero
+    float lastPower;
+};
+static Comfort comfort = {0.0, 0.0f, 0, 0, 0.0f};
+
+static void setHeatingPower(float percent) {
+    if (comfort.lastPower <= 0.0f && percent > 0.0f) {
+        comfort.starts++;
+    }
+    comfort.lastPower = percent;
+    NativeHal::setHeatingPower(percent);
+}
+
+static void trackComfort() {
+    if (millis() < COMFORT_WARMUP) {
+        return;
+    }
+    float error = fabsf(thermostatState.getCurrentTemperature() - thermostatState.getTargetTemperature());
+    comfort.absError += error;
+    if (error > comfort.maxError) comfort.maxError = error;
+    comfort.samples++;
+}
+
+// Nightly setback with a comfort time in the morning
+struct Nights {
+    float setback;
+    float comfortSetpoint;
+    unsigned long length;
+    float outdoorBase;
+    float outdoorSwing;           // Amplitude of a daily outdoor cycle, coldest in the morning
+    unsigned long nextSetback;
+    bool preheating;
+    int count;
+    long lateness[MAX_NIGHTS];    // Arrival after the comfort time in ms, negative when early
+};
+static Nights nights = {0.0f, 0.0f, 0, 0.0f, 0.0f, FIRST_SETBACK, false, 0, {}};
+
+static void trackNights() {
+    unsigned long now = millis();
+    if (now >= nights.nextSetback) {
+        thermostatState.setTargetTemperature(nights.setback);
+        optimumStart.schedule(nights.length / 60000.0f, now);
+        nights.nextSetback += DAY;
+    }
+    if (nights.preheating && !optimumStart.isPreheating() && nights.count < MAX_NIGHTS) {
+        nights.lateness[nights.count++] = optimumStart.getLastLateness();
+    }
+    nights.preheating = optimumStart.isPreheating();
+}
+
+// Sensor outage and the output held while it lasts
+struct SensorFault {
+    unsigned long start;
+    unsigned long end;
+    bool failsafe;        // The failsafe was entered during the outage
+    float valve;          // Valve position at the end of the outage
+};
+static SensorFault sensorFault = {0, 0, false, 0.0f};
+
+static void trackSensorFault() {
+    unsigned long now = millis();
+    bool fault = now >= sensorFault.start && now < sensorFault.end;
+    if (fault != NativeHal::hasSensorFault()) {
+        if (!fault) {
+            sensorFault.valve = thermostatState.getValvePosition();
+        }
+        NativeHal::setSensorFault(fault);
+        ESP_LOGI(TAG, "Sensor %s", fault ? "failed" : "repaired");
+    }
+    sensorFault.failsafe = sensorFault.failsafe || controlPipeline.isFailsafe();
+}
+
+static float outdoorTemperature() {
+    if (nights.outdoorSwing <= 0.0f) {
+        return NativeHal::getRoomModel().outdoor;
+    }
+    // Coldest at the comfort time, warmest twelve hours later
+    unsigned long comfortTime = FIRST_SETBACK + nights.length;
+    float phase = 2.0f * static_cast<float>(M_PI) * ((millis() + DAY - comfortTime % DAY) % DAY) / DAY;
+    float outdoor = nights.outdoorBase - nights.outdoorSwing * cosf(phase);
+    NativeHal::setOutdoorTemperature(outdoor);
+    return outdoor;
+}
+
+static void statusTask() {
+    const ValveGovernor::Stats& valve = valveGovernor.getStats();
+    ESP_LOGI(TAG, "room=%.2fC setpoint=%.1fC valve=%.1f%% passes=%lu moves=%u suppressed=%u",
+             thermostatState.getCurrentTemperature(), thermostatState.getTargetTemperature(),
+             thermostatState.getValvePosition(), controlPipeline.getPassCount(),
+             valve.moves, valve.suppressed);
+}
+
+int main() {
+    NativeHal::setTimeScale(getEnvFloat("NATIVE_TIME_SCALE", DEFAULT_TIME_SCALE));
+    unsigned long duration = static_cast<unsigned long>(
+        getEnvFloat("NATIVE_SIM_SECONDS", DEFAULT_SIM_SECONDS)) * 1000UL;
+
+    ESP_LOGI(TAG, "Running %lu simulated seconds at %.0fx real time",
+             duration / 1000, NativeHal::getTimeScale());
+
+    if (!sensorInterface.begin()) {
+        ESP_LOGE(TAG, "Simulated sensor not available");
+        return 1;
+    }
+    pidController.begin();
+    pidController.setActive(true);
+    hysteresisController.begin();
+    thermostatState.setEnabled(true);
+
+    // NATIVE_AUTOTUNE=<rule> runs a relay autotune first, then controls with the result
+    const char* autotuneRule = getenv("NATIVE_AUTOTUNE");
+    if (autotuneRule) {
+        AutotuneRule rule;
+        if (!parseAutotuneRule(autotuneRule, rule)) {
+            ESP_LOGE(TAG, "Unknown autotune rule %s", autotuneRule);
+            return 1;
+        }
+        pidController.onAutotuneComplete([](const PIDConfig& config) {
+            ESP_LOGI(TAG, "Autotuned gains: kp=%.3f ki=%.4f kd=%.3f", config.kp, config.ki, config.kd);
+        });
+        pidController.startAutotune(rule);
+    }
+
+    controlPipeline.setValveGovernor(&valveGovernor);
+
+    const char* engineName = getenv("NATIVE_ENGINE");
+    if (engineName) {
+        ControlEngine engine;
+        if (!parseControlEngine(engineName, engine)) {
+            ESP_LOGE(TAG, "NATIVE_ENGINE must be pid or hysteresis");
+            return 1;
+        }
+        controllerFactory.select(0, engine);
+        controlPipeline.setControllerFactory(&controllerFactory);
+    }
+
+    NativeHal::RoomModel room = NativeHal::getRoomModel();
+    room.timeConstant = getEnvFloat("NATIVE_ROOM_TAU", room.timeConstant);
+    NativeHal::setRoomModel(room);
+
+    const char* heatingCurve = getenv("NATIVE_HEATING_CURVE");
+    if (heatingCurve) {
+        HeatingCurve curve = DEFAULT_HEATING_CURVE;
+        if (sscanf(heatingCurve, "%f:%f", &curve.slope, &curve.offset) < 1) {
+            ESP_LOGE(TAG, "NATIVE_HEATING_CURVE must be <slope>[:<offset>]");
+            return 1;
+        }
+        pidController.setHeatingCurve(curve);
+    }
+
+    const char* flowSupply = getenv("NATIVE_FLOW");
+    if (flowSupply) {
+        NativeHal::FlowModel circuit = NativeHal::getFlowModel();
+        circuit.enabled = true;
+        circuit.supply = static_cast<float>(atof(flowSupply));
+        circuit.flow = NativeHal::getRoomModel().temperature;
+        NativeHal::setFlowModel(circuit);
+    }
+
+    const char* cascade = getenv("NATIVE_CASCADE");
+    if (cascade) {
+        CascadeConfig config = DEFAULT_CASCADE_CONFIG;
+        config.enabled = true;
+        if (!flowSupply || sscanf(cascade, "%f:%f", &config.kp, &config.ki) != 2) {
+            ESP_LOGE(TAG, "NATIVE_CASCADE must be <kp>:<ki> and needs NATIVE_FLOW");
+            return 1;
+        }
+        config.maxFlow = NativeHal::getFlowModel().supply;  // The whole capacity of the circuit
+        cascadeController.configure(config);
+        controlPipeline.setCascade(&cascadeController);
+        thermostatState.onFlowTemperatureChange([](float temperature) {
+            cascadeController.setFlowTemperature(temperature, millis());
+        });
+    }
+
+    const char* outdoorStep = getenv("NATIVE_OUTDOOR_STEP");
+    const char* supplyStep = getenv("NATIVE_SUPPLY_STEP");
+    const char* step = outdoorStep ? outdoorStep : supplyStep;
+    if (step) {
+        float seconds;
+        if (sscanf(step, "%f:%f", &seconds, &disturbance.value) != 2) {
+            ESP_LOGE(TAG, "NATIVE_OUTDOOR_STEP and NATIVE_SUPPLY_STEP must be <seconds>:<temperature>");
+            return 1;
+        }
+        disturbance.time = static_cast<unsigned long>(seconds * 1000.0f);
+        disturbance.supply = !outdoorStep;
+    }
+
+    const char* comfortSchedule = getenv("NATIVE_COMFORT");
+    if (comfortSchedule) {
+        float hours = 8.0f;
+        if (sscanf(comfortSchedule, "%f:%f:%f", &nights.setback, &hours, &nights.outdoorSwing) < 1) {
+            ESP_LOGE(TAG, "NATIVE_COMFORT must be <setback C>[:<night h>[:<outdoor swing K>]]");
+            return 1;
+        }
+        nights.length = static_cast<unsigned long>(hours * 3600000.0f);
+        nights.comfortSetpoint = thermostatState.getTargetTemperature();
+        nights.outdoorBase = NativeHal::getRoomModel().outdoor;
+
+        OptimumStartConfig config = DEFAULT_OPTIMUM_START_CONFIG;
+        config.enabled = true;
+        config.deadTime = flowSupply ? 1 : 0;
+        optimumStart.configure(config);
+        optimumStart.setSetpoint(nights.comfortSetpoint);
+        controlPipeline.setOptimumStart(&optimumStart);
+    }
+
+    const char* fault = getenv("NATIVE_SENSOR_FAULT");
+    if (fault) {
+        float start;
+        float length;
+        if (sscanf(fault, "%f:%f", &start, &length) != 2) {
+            ESP_LOGE(TAG, "NATIVE_SENSOR_FAULT must be <seconds>:<duration s>");
+            return 1;
+        }
+        sensorFault.start = static_cast<unsigned long>(start * 1000.0f);
+        sensorFault.end = sensorFault.start + static_cast<unsigned long>(length * 1000.0f);
+    }
+
+    const char* pwm = getenv("NATIVE_PWM");
+    if (pwm) {
+        PwmOutputConfig config = DEFAULT_PWM_CONFIG;
+        float cycle;
+        float minTime = -1.0f;
+        if (sscanf(pwm, "%f:%f:%f", &cycle, &minTime, &config.accuracy) < 1) {
+            ESP_LOGE(TAG, "NATIVE_PWM must be <cycle s>[:<min on/off s>[:<accuracy %%>]]");
+            return 1;
+        }
+        config.enabled = true;
+        config.cycleTime = static_cast<unsigned long>(cycle * 1000.0f);
+        if (minTime >= 0.0f) {
+            config.minOnTime = config.minOffTime = static_cast<unsigned long>(minTime * 1000.0f);
+        }
+        pwmOutput.configure(config);
+        controlPipeline.setPwmOutput(&pwmOutput);
+    }
+
+    // The valve, or the on/off output, drives the simulated room
+    if (pwm) {
+        thermostatState.onHeatingChange([](bool heating) { setHeatingPower(heating ? 100.0f : 0.0f); });
+    } else {
+        thermostatState.onValvePositionChange([](float value) { setHeatingPower(value); });
+    }
+    sensorInterface.onNewSample([](float temperature, float humidity, float pressure) {
+        controlPipeline.onSample(temperature, humidity, pressure);
+    });
+
+    controlScheduler.addTask("sensor", static_cast<unsigned long>(pidController.getSampleTime()),
+                             []() { sensorInterface.updateReadings(); });
+    controlScheduler.addTask("failsafe", FAILSAFE_TASK_PERIOD, []() { controlPipeline.checkSamples(millis()); });
+    controlScheduler.addTask("status", STATUS_TASK_PERIOD, statusTask);
+    controlScheduler.addTask("outdoor", OUTDOOR_TASK_PERIOD, []() {
+        thermostatState.setOutdoorTemperature(outdoorTemperature());
+    });
+    controlScheduler.addTask("comfort", static_cast<unsigned long>(pidController.getSampleTime()), trackComfort);
+    if (pwm) {
+        controlScheduler.addTask("pwm", PWM_TASK_PERIOD, []() {
+            thermostatState.setHeating(pwmOutput.update(millis()));
+        });
+    }
+    if (flowSupply) {
+        controlScheduler.addTask("flow", FLOW_TASK_PERIOD, []() {
+            thermostatState.setFlowTemperature(NativeHal::getFlowModel().flow);
+        });
+    }
+    if (cascade) {
+        controlScheduler.addTask("cascade", cascadeController.getConfig().sampleTime, []() {
+            controlPipeline.onCascadeTick(millis());
+        });
+    }
+    if (comfortSchedule) {
+        controlScheduler.addTask("nights", static_cast<unsigned long>(pidController.getSampleTime()), trackNights);
+    }
+    if (fault) {
+        controlScheduler.addTask("fault", FAILSAFE_TASK_PERIOD, trackSensorFault);
+    }
+    if (step) {
+        controlScheduler.addTask("disturbance", static_cast<unsigned long>(pidController.getSampleTime()),
+                                 trackDisturbance);
+    }
+
+    while (millis() < duration) {
+        controlScheduler.runDue();
+
+        unsigned long idle = controlScheduler.timeUntilNextDeadline();
+        if (idle > MAX_IDLE_DELAY) {
+            idle = MAX_IDLE_DELAY;
+        }
+        CoreTask::sleep(idle > 0 ? idle : 1);
+    }
+
+    controlScheduler.logStats();
+    statusTask();
+
+    if (comfort.samples > 0) {
+        ESP_LOGI(TAG, "Comfort: mean deviation=%.2fC max=%.2fC heater starts=%u",
+                 comfort.absError / comfort.samples, comfort.maxError, comfort.starts);
+    }
+
+    if (pwm) {
+        PwmOutput::Stats stats = pwmOutput.getStats();
+        ESP_LOGI(TAG, "PWM: switches=%u cycles=%u merged=%u", stats.switches, stats.cycles, stats.merged);
+    }
+
+    if (comfortSchedule) {
+        const HeatupEstimator& model = optimumStart.getEstimator();
+        ESP_LOGI(TAG, "Heat-up model: gain=%.2fK/h loss=%.3f/h bias=%.2fK/h after %u samples", model.getGain(),
+                 model.getLoss(), model.getBias(), model.getSampleCount());
+        for (int i = 0; i < nights.count; i++) {
+            ESP_LOGI(TAG, "Morning %d: setpoint reached %ld min %s the comfort time", i + 1,
+                     labs(nights.lateness[i]) / 60000, nights.lateness[i] < 0 ? "before" : "after");
+        }
+    }
+
+    if (fault) {
+        ESP_LOGI(TAG, "Sensor fault: failsafe %s, valve at %.1f%% when the sensor returned",
+                 sensorFault.failsafe ? "entered" : "not entered", sensorFault.valve);
+    }
+
+    if (disturbance.applied) {
+        ESP_LOGI(TAG, "Disturbance: drop=%.2fC overshoot=%.2fC recovered after %lu min",
+                 disturbance.maxBelow, disturbance.maxAbove,
+                 (disturbance.lastOutside - disturbance.time) / 60000);
+    }
+
+    if (autotuneRule && pidController.getAutotuner().getState() != AutotuneState::DONE) {
+        ESP_LOGE(TAG, "Autotune did not complete: %s", getAutotuneStateName(pidController.getAutotuner().getState()));
+        return 1;
+    }
+    return 0;
+}
+
+#endif  // PIO_UNIT_TESTING
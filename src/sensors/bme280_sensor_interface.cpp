@@ -1,4 +1,5 @@
 #include "sensors/bme280_sensor_interface.h"
+#include "system/loop_profiler.h"
 #include <Wire.h>
 #include <esp_log.h>
 
@@ -27,8 +28,7 @@ bool BME280SensorInterface::begin() {
     Wire.begin(BME280_SDA_PIN, BME280_SCL_PIN);
     delay(100); // Brief delay to ensure I2C bus is ready
     
-    // Simple initialization approach like in the test script
-    if (bme.begin(0x76)) {
+    if (probe()) {
         ESP_LOGI(TAG, "BME280 sensor found and initialized!");
         sensorAvailable = true;
         stopErrorMessages = false;
@@ -36,26 +36,23 @@ bool BME280SensorInterface::begin() {
         return true;
     }
     
-    // Try alternate address as fallback
-    if (bme.begin(0x77)) {
-        ESP_LOGI(TAG, "BME280 sensor found at alternate address and initialized!");
-        sensorAvailable = true;
-        stopErrorMessages = false;
-        clearError();
-        return true;
-    }
-    
     // Sensor not found - log once and continue
     ESP_LOGE(TAG, "Could not find BME280 sensor! Check your wiring.");
-    ESP_LOGW(TAG, "Continuing without BME280 sensor - other functionality will work");
+    ESP_LOGW(TAG, "Continuing without BME280 sensor - it is looked for again on every update");
     sensorAvailable = false;
     stopErrorMessages = true; // Don't log any more errors
+    firstErrorTime = millis();
     lastError = ThermostatStatus::ERROR_SENSOR;
     snprintf(lastErrorMessage, sizeof(lastErrorMessage)-1, "Could not find BME280 sensor");
     
     return false; // Return false but system will continue
 }
 
+bool BME280SensorInterface::probe() {
+    // Simple initialization approach like in the test script, alternate address as fallback
+    return bme.begin(0x76) || bme.begin(0x77);
+}
+
 void BME280SensorInterface::setSensorMode() {
     // Use default settings - the sensor works fine with these in the test script
     bme.setSampling(Adafruit_BME280::MODE_NORMAL,
@@ -67,13 +64,7 @@ void BME280SensorInterface::setSensorMode() {
 }
 
 void BME280SensorInterface::loop() {
-    // If sensor is not available, just return without doing anything
-    // This allows other system functionality to continue
-    if (!sensorAvailable) {
-        return;
-    }
-    
-    // Only update readings at the specified interval if sensor is available
+    // Only update readings at the specified interval, this also retries a missing sensor
     unsigned long currentTime = millis();
     if (currentTime - lastUpdateTime >= updateInterval) {
         updateReadings();
@@ -82,24 +73,43 @@ void BME280SensorInterface::loop() {
 }
 
 void BME280SensorInterface::updateReadings() {
-    // Skip if sensor is not available
+    // A sensor that failed may be back after a brown-out or a loose contact
     if (!sensorAvailable) {
-        return; // Just return silently
+        if (!probe()) {
+            return; // Just return silently, the control pipeline runs its failsafe
+        }
+        ESP_LOGI(TAG, "BME280 sensor found again");
+        sensorAvailable = true;
     }
     
     // Simple reading approach like in the test script
-    float tempValue = bme.readTemperature();
-    float humValue = bme.readHumidity();
-    float pressValue = bme.readPressure() / 100.0F; // Convert Pa to hPa
+    float tempValue;
+    float humValue;
+    float pressValue;
+    {
+        PROFILE_PHASE(LoopPhase::SENSOR);
+        tempValue = bme.readTemperature();
+        humValue = bme.readHumidity();
+        pressValue = bme.readPressure() / 100.0F; // Convert Pa to hPa
+    }
     
-    // Check for invalid readings
+    // Check for invalid readings, the sensor is initialized again on the next update
     if (isnan(tempValue) || isnan(humValue) || isnan(pressValue)) {
-        ESP_LOGW(TAG, "Invalid sensor readings detected");
+        if (!stopErrorMessages) {
+            ESP_LOGW(TAG, "Invalid sensor readings detected");
+            stopErrorMessages = true;
+            firstErrorTime = millis();
+        }
         sensorAvailable = false;
         lastError = ThermostatStatus::ERROR_SENSOR;
         snprintf(lastErrorMessage, sizeof(lastErrorMessage)-1, "Invalid sensor readings");
         return;
     }
+
+    if (stopErrorMessages) {
+        ESP_LOGI(TAG, "Valid readings again after %lu s", (millis() - firstErrorTime) / 1000);
+        stopErrorMessages = false;
+    }
     
     // Apply calibration offsets
     temperature = tempValue + temperatureOffset;
@@ -114,6 +124,11 @@ void BME280SensorInterface::updateReadings() {
     
     // Clear any previous errors
     clearError();
+
+    // Notify the control pipeline about the fresh sample
+    if (sampleCallback) {
+        sampleCallback(temperature, humidity, pressure);
+    }
 }
 
 void BME280SensorInterface::setUpdateInterval(unsigned long interval) {
@@ -136,6 +151,10 @@ float BME280SensorInterface::getPressure() const {
     return pressure;
 }
 
+void BME280SensorInterface::onNewSample(SampleCallback callback) {
+    sampleCallback = callback;
+}
+
 void BME280SensorInterface::setTemperatureOffset(float offset) {
     temperatureOffset = offset;
 }
@@ -0,0 +1,53 @@
+#include "system/core_task.h"
+#include <esp_log.h>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <Arduino.h>
+#include <thread>
+#endif
+
+static const char* TAG = "CoreTask";
+
+namespace CoreTask {
+
+#ifdef ESP_PLATFORM
+
+bool start(const char* name, TaskFunction function, void* arg, int core,
+           uint32_t stackSize, unsigned priority) {
+    BaseType_t result = xTaskCreatePinnedToCore(function, name, stackSize, arg,
+                                                priority, nullptr, core);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start task %s on core %d", name, core);
+        return false;
+    }
+    ESP_LOGI(TAG, "Started task %s on core %d", name, core);
+    return true;
+}
+
+void sleep(unsigned long ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+#else
+
+bool start(const char* name, TaskFunction function, void* arg, int core,
+           uint32_t stackSize, unsigned priority) {
+    // Host threads are scheduled by the OS, core and priority are advisory
+    (void)stackSize;
+    (void)priority;
+    std::thread(function, arg).detach();
+    ESP_LOGI(TAG, "Started task %s (core %d requested)", name, core);
+    return true;
+}
+
+void sleep(unsigned long ms) {
+    // delay() follows the simulated clock of the host build
+    delay(ms);
+}
+
+#endif
+
+}  // namespace CoreTask
@@ -0,0 +1,99 @@
+#include "system/loop_profiler.h"
+
+#ifdef LOOP_PROFILER
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+LoopProfiler::PhaseStats LoopProfiler::stats[LoopProfiler::PHASE_COUNT];
+std::atomic<uint32_t> LoopProfiler::resetRequests(0);
+
+#ifdef ESP_PLATFORM
+
+uint32_t LoopProfiler::cycles() {
+    return ESP.getCycleCount();
+}
+
+uint32_t LoopProfiler::cyclesPerMicrosecond() {
+    return getCpuFrequencyMhz();
+}
+
+#else
+
+// Host builds count nanoseconds as cycles of a 1 GHz clock
+uint32_t LoopProfiler::cycles() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+uint32_t LoopProfiler::cyclesPerMicrosecond() {
+    return 1000;
+}
+
+#endif
+
+void LoopProfiler::record(LoopPhase phase, uint32_t elapsedCycles) {
+    size_t index = static_cast<size_t>(phase);
+    uint32_t bit = 1u << index;
+    if (resetRequests.load(std::memory_order_relaxed) & bit) {
+        resetRequests.fetch_and(~bit, std::memory_order_relaxed);
+        clear(index);
+    }
+    PhaseStats& phaseStats = stats[index];
+
+    size_t bucket = elapsedCycles ? 31 - __builtin_clz(elapsedCycles) : 0;
+    phaseStats.histogram[bucket]++;
+    phaseStats.count++;
+
+    if (elapsedCycles < phaseStats.minCycles) phaseStats.minCycles = elapsedCycles;
+    if (elapsedCycles > phaseStats.maxCycles) phaseStats.maxCycles = elapsedCycles;
+    if (phaseStats.budgetCycles && elapsedCycles > phaseStats.budgetCycles) {
+        phaseStats.overBudget++;
+    }
+}
+
+void LoopProfiler::setBudget(LoopPhase phase, uint32_t budgetUs) {
+    stats[static_cast<size_t>(phase)].budgetCycles = budgetUs * cyclesPerMicrosecond();
+}
+
+void LoopProfiler::reset() {
+    resetRequests = 0;
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        clear(i);
+    }
+}
+
+void LoopProfiler::requestReset() {
+    resetRequests.fetch_or((1u << PHASE_COUNT) - 1, std::memory_order_relaxed);
+}
+
+void LoopProfiler::clear(size_t index) {
+    uint32_t budget = stats[index].budgetCycles;
+    stats[index] = {};
+    stats[index].minCycles = UINT32_MAX;
+    stats[index].budgetCycles = budget ? budget : LOOP_PROFILER_BUDGET_US * cyclesPerMicrosecond();
+}
+
+uint32_t LoopProfiler::getPercentileCycles(LoopPhase phase, uint8_t percentile) {
+    const PhaseStats& phaseStats = stats[static_cast<size_t>(phase)];
+    if (phaseStats.count == 0) {
+        return 0;
+    }
+
+    // Report the upper edge of the bucket holding the requested rank
+    uint64_t rank = (static_cast<uint64_t>(phaseStats.count) * percentile + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        seen += phaseStats.histogram[bucket];
+        if (seen >= rank) {
+            uint64_t upper = (static_cast<uint64_t>(1) << (bucket + 1)) - 1;
+            return upper < phaseStats.maxCycles ? static_cast<uint32_t>(upper) : phaseStats.maxCycles;
+        }
+    }
+    return phaseStats.maxCycles;
+}
+
+#endif // LOOP_PROFILER
@@ -0,0 +1,159 @@
+#include "system/task_scheduler.h"
+#include <esp_log.h>
+
+static const char* TAG = "TaskScheduler";
+
+TaskScheduler::TaskScheduler(ClockFunction clock)
+    : clock(clock)
+    , taskCount(0) {
+}
+
+int TaskScheduler::addTask(const char* name, unsigned long period, TaskCallback callback) {
+    if (taskCount >= MAX_TASKS || !callback) {
+        ESP_LOGE(TAG, "Cannot register task %s", name ? name : "(null)");
+        return INVALID_TASK;
+    }
+
+    uint8_t id = static_cast<uint8_t>(taskCount);
+    Task& task = tasks[id];
+    task.callback = callback;
+    task.deadline = clock();  // First run as soon as possible
+    task.stats = {};
+    task.stats.name = name;
+    task.stats.period = period;
+
+    heap[taskCount] = id;
+    heapPosition[id] = static_cast<uint8_t>(taskCount);
+    taskCount++;
+    siftUp(taskCount - 1);
+
+    ESP_LOGI(TAG, "Registered task %s with period %lu ms", name, period);
+    return id;
+}
+
+void TaskScheduler::setPeriod(int taskId, unsigned long period) {
+    if (taskId < 0 || static_cast<size_t>(taskId) >= taskCount) {
+        return;
+    }
+
+    Task& task = tasks[taskId];
+    // Move the pending deadline so the new period takes effect immediately
+    task.deadline = task.deadline - task.stats.period + period;
+    task.stats.period = period;
+    siftUp(heapPosition[taskId]);
+    siftDown(heapPosition[taskId]);
+}
+
+void TaskScheduler::triggerNow(int taskId) {
+    if (taskId < 0 || static_cast<size_t>(taskId) >= taskCount) {
+        return;
+    }
+
+    tasks[taskId].deadline = clock();
+    siftUp(heapPosition[taskId]);
+}
+
+void TaskScheduler::runDue() {
+    // Every task runs at most once per call, even with a zero period
+    for (size_t i = 0; i < taskCount; i++) {
+        unsigned long now = clock();
+        uint8_t id = heap[0];
+        Task& task = tasks[id];
+
+        if (static_cast<long>(now - task.deadline) < 0) {
+            break;
+        }
+
+        unsigned long lateness = now - task.deadline;
+        task.callback();
+        unsigned long finished = clock();
+
+        TaskStats& stats = task.stats;
+        stats.runs++;
+        stats.lastJitter = lateness;
+        stats.lastDuration = finished - now;
+        if (lateness > stats.maxJitter) stats.maxJitter = lateness;
+        if (stats.lastDuration > stats.maxDuration) stats.maxDuration = stats.lastDuration;
+
+        // Keep the task phase-locked to its period unless it fell behind,
+        // in which case the missed slots are skipped rather than replayed
+        task.deadline += stats.period;
+        if (static_cast<long>(finished - task.deadline) > 0) {
+            stats.overruns++;
+            task.deadline = finished + stats.period;
+        }
+
+        siftDown(heapPosition[id]);
+    }
+}
+
+unsigned long TaskScheduler::timeUntilNextDeadline() const {
+    if (taskCount == 0) {
+        return 0;
+    }
+
+    long remaining = static_cast<long>(tasks[heap[0]].deadline - clock());
+    return remaining > 0 ? static_cast<unsigned long>(remaining) : 0;
+}
+
+void TaskScheduler::resetStats() {
+    for (size_t i = 0; i < taskCount; i++) {
+        TaskStats& stats = tasks[i].stats;
+        stats.runs = 0;
+        stats.overruns = 0;
+        stats.lastJitter = 0;
+        stats.maxJitter = 0;
+        stats.lastDuration = 0;
+        stats.maxDuration = 0;
+    }
+}
+
+void TaskScheduler::logStats() const {
+    for (size_t i = 0; i < taskCount; i++) {
+        const TaskStats& stats = tasks[i].stats;
+        ESP_LOGI(TAG, "%-10s period=%lums runs=%u overruns=%u jitter=%lu/%lums duration=%lu/%lums",
+                 stats.name, stats.period,
+                 static_cast<unsigned>(stats.runs), static_cast<unsigned>(stats.overruns),
+                 stats.lastJitter, stats.maxJitter, stats.lastDuration, stats.maxDuration);
+    }
+}
+
+bool TaskScheduler::isEarlier(uint8_t a, uint8_t b) const {
+    // Signed difference keeps the ordering correct across millis() rollover
+    return static_cast<long>(tasks[a].deadline - tasks[b].deadline) < 0;
+}
+
+void TaskScheduler::siftUp(size_t index) {
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!isEarlier(heap[index], heap[parent])) {
+            break;
+        }
+        swapHeap(index, parent);
+        index = parent;
+    }
+}
+
+void TaskScheduler::siftDown(size_t index) {
+    while (true) {
+        size_t left = 2 * index + 1;
+        size_t right = left + 1;
+        size_t earliest = index;
+
+        if (left < taskCount && isEarlier(heap[left], heap[earliest])) earliest = left;
+        if (right < taskCount && isEarlier(heap[right], heap[earliest])) earliest = right;
+        if (earliest == index) {
+            break;
+        }
+        swapHeap(index, earliest);
+        index = earliest;
+    }
+}
+
+void TaskScheduler::swapHeap(size_t a, size_t b) {
+    uint8_t tmp = heap[a];
+    heap[a] = heap[b];
+    heap[b] = tmp;
+    heapPosition[heap[a]] = static_cast<uint8_t>(a);
+    heapPosition[heap[b]] = static_cast<uint8_t>(b);
+}
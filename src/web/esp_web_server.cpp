@@ -192,14 +192,16 @@ String ESPWebServer::generateHtml() {
 
 String ESPWebServer::generateStatusJson() {
     StaticJsonDocument<512> doc;
+    ThermostatSnapshot state = thermostatState->snapshot();
     
-    doc["temperature"] = thermostatState->getCurrentTemperature();
-    doc["humidity"] = thermostatState->getCurrentHumidity();
-    doc["pressure"] = thermostatState->getCurrentPressure();
-    doc["setpoint"] = thermostatState->getTargetTemperature();
-    doc["valve"] = thermostatState->getValvePosition();
-    doc["heating"] = thermostatState->isHeating();
-    doc["mode"] = static_cast<int>(thermostatState->getMode());
+    doc["temperature"] = state.currentTemperature;
+    doc["humidity"] = state.currentHumidity;
+    doc["pressure"] = state.currentPressure;
+    doc["setpoint"] = state.targetTemperature;
+    doc["valve"] = state.valvePosition;
+    doc["heating"] = state.heating;
+    doc["mode"] = static_cast<int>(state.mode);
+    doc["version"] = state.version;
     
     String json;
     serializeJson(doc, json);
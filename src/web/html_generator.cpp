@@ -66,6 +66,7 @@ String HtmlGenerator::generateNavigation() {
 
 String HtmlGenerator::generateStatusSection(ThermostatState* state) {
     if (!state) return "";
+    ThermostatSnapshot snapshot = state->snapshot();
     
     // Increase buffer to ensure complete HTML is generated
     char buf[1024];
@@ -100,9 +101,9 @@ String HtmlGenerator::generateStatusSection(ThermostatState* state) {
     </div>
 </div>
 )",
-        state->getCurrentTemperature(),
-        state->getCurrentHumidity(),
-        state->getCurrentPressure()
+        snapshot.currentTemperature,
+        snapshot.currentHumidity,
+        snapshot.currentPressure
     );
     return String(buf);
 }
@@ -130,7 +131,7 @@ String HtmlGenerator::generateControlSection(ThermostatState* state, const Strin
     // Temperature setpoint control
     html += "      <div class='mb-3'>\n";
     html += "        <label class='form-label' for='setpoint'>Temperature Setpoint</label>\n";
-    html += "        <input type='number' class='form-control' id='setpoint' name='setpoint' value='" + String(state->getTargetTemperature()) + "' min='10' max='30' step='0.5'>\n";
+    html += "        <input type='number' class='form-control' id='setpoint' name='setpoint' value='" + String(state->snapshot().targetTemperature) + "' min='10' max='30' step='0.5'>\n";
     html += "      </div>\n";
     // Action buttons for setting mode and setpoint
     html += "      <button type='button' class='btn btn-primary' onclick='setMode()'>Set Mode</button>\n";
@@ -4,9 +4,13 @@
 #include "sensor_interface.h"
 #include "thermostat_state.h"
 #include "pid_controller.h"
+#include "control/hysteresis_controller.h"
+#include "control/controller_factory.h"
+#include "control/pwm_output.h"
 #include "protocol_manager.h"
 #include "communication/knx/knx_interface.h"
 #include "communication/mqtt/mqtt_interface.h"
+#include "system/loop_profiler.h"
 #include <ArduinoJson.h>
 #include "esp_log.h"
 #include <LittleFS.h>
@@ -162,6 +166,41 @@ void WebInterface::handleSave(AsyncWebServerRequest *request) {
             }
         }
         
+        // Process control engine selection, applied on the next control pass
+        if (doc.containsKey("control")) {
+            JsonObject control = doc["control"];
+            ControlEngine engine;
+            if (parseControlEngine(control["engine"].as<const char*>(), engine)) {
+                configManager->setControlEngine(engine);
+                if (controllerFactory) controllerFactory->select(0, engine);
+            }
+
+            if (control.containsKey("hysteresis")) {
+                JsonObject bands = control["hysteresis"];
+                HysteresisConfig config = configManager->getHysteresisConfig();
+                for (uint8_t i = 0; i < THERMOSTAT_MODE_COUNT; i++) {
+                    config.bands[i] = bands[getThermostatModeKey(static_cast<ThermostatMode>(i))] | config.bands[i];
+                }
+                config.onOutput = bands["output"] | config.onOutput;
+                configManager->setHysteresisConfig(config);
+                if (controllerFactory) controllerFactory->getHysteresis()->configure(&config);
+            }
+        }
+
+        // Process per-zone engines, by position in the zones array
+        if (doc.containsKey("zones")) {
+            uint8_t index = 0;
+            for (JsonObject zone : doc["zones"].as<JsonArray>()) {
+                ControlEngine engine;
+                if (index < configManager->getZoneCount() &&
+                    parseControlEngine(zone["engine"].as<const char*>(), engine)) {
+                    configManager->setZoneEngine(index, engine);
+                    if (controllerFactory) controllerFactory->select(index + 1, engine);
+                }
+                index++;
+            }
+        }
+        
         // Save configuration to flash
         if (!configManager->saveConfig()) {
             ESP_LOGE(TAG, "Failed to save configuration");
@@ -188,13 +227,34 @@ void WebInterface::handleGetStatus(AsyncWebServerRequest *request) {
         return;
     }
 
+    // Pollers pass the version of their last response to get only changes
+    uint32_t since = 0;
+    if (request->hasParam("since")) {
+        since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+    }
+
+    // The control task owns the state, read a consistent copy
+    ThermostatDelta delta = thermostatState->changesSince(since);
+    const ThermostatSnapshot& state = delta.values;
+
     StaticJsonDocument<512> doc;
-    doc["temperature"] = thermostatState->getCurrentTemperature();
-    doc["humidity"] = thermostatState->getCurrentHumidity();
-    doc["pressure"] = thermostatState->getCurrentPressure();
-    doc["setpoint"] = thermostatState->getTargetTemperature();
-    doc["enabled"] = thermostatState->isEnabled();
-    doc["error"] = thermostatState->getStatus();
+    doc["version"] = state.version;
+    if (delta.has(StateField::TEMPERATURE)) doc["temperature"] = state.currentTemperature;
+    if (delta.has(StateField::HUMIDITY)) doc["humidity"] = state.currentHumidity;
+    if (delta.has(StateField::PRESSURE)) doc["pressure"] = state.currentPressure;
+    if (delta.has(StateField::TARGET_TEMPERATURE)) doc["setpoint"] = state.targetTemperature;
+    if (delta.has(StateField::ENABLED)) doc["enabled"] = state.enabled;
+    if (delta.has(StateField::OUTDOOR_TEMPERATURE) && thermostatState->hasOutdoorTemperature()) {
+        doc["outdoorTemperature"] = state.outdoorTemperature;
+    }
+    if (delta.has(StateField::FLOW_TEMPERATURE) && thermostatState->hasFlowTemperature()) {
+        doc["flowTemperature"] = state.flowTemperature;
+    }
+    if (delta.has(StateField::STATUS)) doc["error"] = state.status;
+    if (pwmOutput && pwmOutput->getConfig().enabled) {
+        // Wear of the actuator, counted since startup
+        doc["pwmSwitches"] = pwmOutput->getStats().switches;
+    }
 
     String response;
     serializeJson(doc, response);
@@ -205,6 +265,59 @@ void WebInterface::handleGetStatus(AsyncWebServerRequest *request) {
     ESP_LOGD(TAG, "Status sent to IP: %s", request->client()->remoteIP().toString().c_str());
 }
 
+void WebInterface::handleGetProfile(AsyncWebServerRequest *request) {
+    if (!isAuthenticated(request)) {
+        requestAuthentication(request);
+        return;
+    }
+
+#ifdef LOOP_PROFILER
+    DynamicJsonDocument doc(8192);
+    doc["enabled"] = true;
+    uint32_t cyclesPerUs = LoopProfiler::cyclesPerMicrosecond();
+    doc["cyclesPerUs"] = cyclesPerUs;
+
+    JsonObject phases = doc.createNestedObject("phases");
+    for (size_t i = 0; i < LoopProfiler::PHASE_COUNT; i++) {
+        LoopPhase phase = static_cast<LoopPhase>(i);
+        const LoopProfiler::PhaseStats& stats = LoopProfiler::getStats(phase);
+
+        JsonObject entry = phases.createNestedObject(getLoopPhaseName(phase));
+        entry["count"] = stats.count;
+        entry["overBudget"] = stats.overBudget;
+        entry["budgetUs"] = stats.budgetCycles / cyclesPerUs;
+        entry["minUs"] = stats.count ? stats.minCycles / cyclesPerUs : 0;
+        entry["maxUs"] = stats.maxCycles / cyclesPerUs;
+        entry["p99Us"] = LoopProfiler::getPercentileCycles(phase, 99) / cyclesPerUs;
+
+        // log2 buckets in cycles, trailing empty buckets are omitted
+        size_t used = LoopProfiler::BUCKET_COUNT;
+        while (used > 0 && stats.histogram[used - 1] == 0) {
+            used--;
+        }
+        JsonArray histogram = entry.createNestedArray("histogram");
+        for (size_t bucket = 0; bucket < used; bucket++) {
+            histogram.add(stats.histogram[bucket]);
+        }
+    }
+
+    if (request->hasParam("reset")) {
+        // Cleared by the tasks recording the phases
+        LoopProfiler::requestReset();
+    }
+#else
+    StaticJsonDocument<64> doc;
+    doc["enabled"] = false;
+#endif
+
+    String response;
+    serializeJson(doc, response);
+
+    AsyncWebServerResponse *jsonResponse = request->beginResponse(200, "application/json", response);
+    addSecurityHeaders(jsonResponse);
+    request->send(jsonResponse);
+}
+
 void WebInterface::handleSetpoint(AsyncWebServerRequest* request) {
     if (!isAuthenticated(request)) {
         requestAuthentication(request);
@@ -226,7 +339,8 @@ void WebInterface::handleSetpoint(AsyncWebServerRequest* request) {
     float setpoint = request->getParam("setpoint", true)->value().toFloat();
     
     // Update both thermostat state and config manager
-    thermostatState->setTargetTemperature(setpoint);
+    // State changes are applied on the control task
+    protocolManager->queueLocalUpdate(CommandType::CMD_SETPOINT, setpoint);
     configManager->setSetpoint(setpoint);
     
     // Save configuration to flash
@@ -306,7 +420,7 @@ void WebInterface::handlePID(AsyncWebServerRequest* request) {
         pidController->configure(&config);
     }
     
-    // Set active state separately
+    // Set active state separately, taken over by the control task on its next pass
     if (doc.containsKey("active")) {
         bool active = doc["active"].as<bool>();
         pidController->setActive(active);
@@ -328,6 +442,82 @@ void WebInterface::handlePID(AsyncWebServerRequest* request) {
     request->send(200, "application/json", "{\"status\":\"ok\",\"message\":\"PID parameters updated successfully\"}");
 }
 
+void WebInterface::handleAutotune(AsyncWebServerRequest* request) {
+    if (!isAuthenticated(request)) {
+        requestAuthentication(request);
+        return;
+    }
+
+    if (!validateCSRFToken(request)) {
+        ESP_LOGW(TAG, "Invalid CSRF token from IP: %s", request->client()->remoteIP().toString().c_str());
+        request->send(403, "application/json", "{\"error\":\"Invalid CSRF token\"}");
+        return;
+    }
+
+    if (!request->hasParam("plain", true)) {
+        request->send(400, "application/json", "{\"error\":\"Missing JSON data\"}");
+        return;
+    }
+
+    StaticJsonDocument<128> doc;
+    DeserializationError error = deserializeJson(doc, request->getParam("plain", true)->value());
+    if (error) {
+        request->send(400, "application/json", "{\"error\":\"Invalid JSON: " + String(error.c_str()) + "\"}");
+        return;
+    }
+
+    if (doc["cancel"] | false) {
+        pidController->cancelAutotune();
+        ESP_LOGI(TAG, "PID autotune cancel requested");
+        request->send(200, "application/json", "{\"status\":\"ok\",\"message\":\"Autotune cancelled\"}");
+        return;
+    }
+
+    AutotuneRule rule = AutotuneRule::TYREUS_LUYBEN;
+    const char* ruleName = doc["rule"] | getAutotuneRuleName(rule);
+    if (!parseAutotuneRule(ruleName, rule)) {
+        request->send(400, "application/json", "{\"error\":\"Unknown tuning rule\"}");
+        return;
+    }
+
+    // Started by the control task on its next sample
+    pidController->startAutotune(rule);
+    ESP_LOGI(TAG, "PID autotune requested with rule %s", ruleName);
+    request->send(200, "application/json", "{\"status\":\"ok\",\"message\":\"Autotune started\"}");
+}
+
+void WebInterface::handleGetAutotune(AsyncWebServerRequest* request) {
+    if (!isAuthenticated(request)) {
+        requestAuthentication(request);
+        return;
+    }
+
+    // A consistent copy, the control task keeps running the test meanwhile
+    AutotuneStatus status = pidController->getAutotuner().getStatus();
+
+    StaticJsonDocument<384> doc;
+    doc["state"] = getAutotuneStateName(status.state);
+    doc["rule"] = getAutotuneRuleName(status.rule);
+    doc["cycles"] = status.cycles;
+    if (status.state == AutotuneState::DONE) {
+        const AutotuneResult& result = status.result;
+        doc["ku"] = result.ultimateGain;
+        doc["tu"] = result.ultimatePeriod / 1000.0f;  // Seconds
+        doc["kp"] = result.kp;
+        doc["ki"] = result.ki;
+        doc["kd"] = result.kd;
+    } else if (status.state == AutotuneState::FAILED) {
+        doc["reason"] = status.failureReason;
+    }
+
+    String response;
+    serializeJson(doc, response);
+
+    AsyncWebServerResponse *jsonResponse = request->beginResponse(200, "application/json", response);
+    addSecurityHeaders(jsonResponse);
+    request->send(jsonResponse);
+}
+
 void WebInterface::handleReboot(AsyncWebServerRequest *request) {
     if (!isAuthenticated(request)) {
         requestAuthentication(request);
@@ -387,9 +577,9 @@ void WebInterface::handleMode(AsyncWebServerRequest* request) {
 
     String mode = request->getParam("mode", true)->value();
     if (mode == "on") {
-        thermostatState->setEnabled(true);
+        protocolManager->queueLocalUpdate(CommandType::CMD_ENABLE, 1.0f);
     } else if (mode == "off") {
-        thermostatState->setEnabled(false);
+        protocolManager->queueLocalUpdate(CommandType::CMD_ENABLE, 0.0f);
     } else {
         ESP_LOGW(TAG, "Invalid mode value: %s from IP: %s", mode.c_str(), request->client()->remoteIP().toString().c_str());
         request->send(400, "text/plain", "Invalid mode value");
@@ -0,0 +1,147 @@
+// Cascade control against a single room loop after a supply temperature step.
+//
+// The room and heating circuit are the native simulator's models on a
+// simulated clock: the flow approaches room + valve * (supply - room) with a
+// two minute time constant and heats a one hour room in proportion to its
+// rise above it. The room PID runs with the firmware's default gains and
+// sample time, either on the valve directly or on the flow setpoint of a
+// CascadeController with its default gains, fed a flow reading every 10 s
+// like a KNX sensor. After the room has settled the supply drops from 60 C
+// to 50 C; the cascade must keep the drop and the integrated deviation far
+// smaller, and stay inside the recovery band the single loop leaves for
+// more than an hour.
+
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "thermostat_state.h"
+#include "control/pid_controller.h"
+#include "control/cascade_controller.h"
+
+static const float SETPOINT = 21.0f;
+static const float OUTDOOR = 5.0f;
+static const float HEATER_GAIN = 25.0f;          // Rise above outdoor at full power, K
+static const float ROOM_TAU = 3600.0f;           // Seconds
+static const float DESIGN_RISE = 40.0f;          // Flow above room at full power, K
+static const float FLOW_TAU = 120.0f;            // Seconds
+static const float SUPPLY = 60.0f;
+static const float STEPPED_SUPPLY = 50.0f;
+static const unsigned long STEP = 1000;          // Model integration step, ms
+static const unsigned long FLOW_PERIOD = 10000;  // Flow sensor send interval, ms
+static const unsigned long STEP_TIME = 8 * 3600000UL;
+static const unsigned long RUN_TIME = 16 * 3600000UL;
+static const float SETTLED_BAND = 0.05f;         // K
+static const float RECOVERY_BAND = 0.3f;         // K
+static const unsigned long MIN_SINGLE_RECOVERY = 60 * 60000UL;  // ms
+static const float MAX_DROP_RATIO = 0.3f;        // Cascade per single loop, about 0.23 measured
+static const float MAX_DEVIATION_RATIO = 0.5f;   // Cascade per single loop, about 0.4 measured
+
+static ThermostatState state;
+
+struct Response {
+    float settledError;           // Deviation when the supply steps, K
+    float maxDrop;                // Largest drop below the setpoint after the step, K
+    float deviation;              // Integrated absolute deviation after the step, K h
+    unsigned long outsideBand;    // Time from the step until the room is back in band for good, ms
+};
+
+static Response simulate(bool useCascade) {
+    PIDConfig pidConfig = PIDController(&state).getConfig();
+    unsigned long sampleTime = static_cast<unsigned long>(pidConfig.sampleTime);
+
+    PidKernel<FloatMath> pid;
+    pid.setGains(pidConfig.kp, pidConfig.ki, pidConfig.kd);
+    pid.setDerivativeFilter(PID_DERIVATIVE_FILTER_SAMPLES);
+    pid.setOutputLimits(pidConfig.minOutput, pidConfig.maxOutput);
+    CascadeController cascade;
+    CascadeConfig cascadeConfig = DEFAULT_CASCADE_CONFIG;
+    cascadeConfig.enabled = true;
+    cascade.configure(cascadeConfig);
+
+    float room = 18.0f;
+    float flow = room;
+    float supply = SUPPLY;
+    float valve = 0.0f;
+    pid.reset(room);
+    Response response = {0.0f, 0.0f, 0.0f, 0};
+
+    const float dt = STEP / 1000.0f;
+    for (unsigned long now = 0; now < RUN_TIME; now += STEP) {
+        if (now == STEP_TIME) {
+            supply = STEPPED_SUPPLY;
+            response.settledError = fabsf(room - SETPOINT);
+        }
+        if (useCascade && now % FLOW_PERIOD == 0) {
+            cascade.setFlowTemperature(flow, now);
+        }
+        if (now % sampleTime == 0) {
+            float output = pid.compute(SETPOINT, room, 1.0f);
+            if (useCascade) {
+                cascade.setDemand(output);
+            } else {
+                valve = output;
+            }
+        }
+        if (useCascade && now % cascadeConfig.sampleTime == 0) {
+            valve = cascade.update(now);
+        }
+
+        flow += (room + valve / 100.0f * (supply - room) - flow) * dt / FLOW_TAU;
+        float power = 100.0f * (flow - room) / DESIGN_RISE;
+        power = power > 0.0f ? power : 0.0f;
+        room += (OUTDOOR + HEATER_GAIN * power / 100.0f - room) * dt / ROOM_TAU;
+
+        if (now >= STEP_TIME) {
+            float error = room - SETPOINT;
+            if (-error > response.maxDrop) response.maxDrop = -error;
+            response.deviation += fabsf(error) * dt / 3600.0f;
+            if (fabsf(error) > RECOVERY_BAND) response.outsideBand = now - STEP_TIME;
+        }
+    }
+    return response;
+}
+
+static void report(const char* name, const Response& response) {
+    char message[128];
+    snprintf(message, sizeof(message), "%s: drop %.2f K, deviation %.2f K h, back in band after %lu min", name,
+             response.maxDrop, response.deviation, response.outsideBand / 60000);
+    TEST_MESSAGE(message);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_settled_before_the_step() {
+    // Both loops must start from a settled room, or the step response would include the warm-up
+    for (bool useCascade : {false, true}) {
+        TEST_ASSERT_LESS_THAN_FLOAT(SETTLED_BAND, simulate(useCascade).settledError);
+    }
+}
+
+void test_cascade_limits_the_drop() {
+    Response single = simulate(false);
+    Response cascade = simulate(true);
+    report("single loop", single);
+    report("cascade", cascade);
+
+    TEST_ASSERT_GREATER_THAN_FLOAT(RECOVERY_BAND, single.maxDrop);
+    TEST_ASSERT_LESS_THAN_FLOAT(MAX_DROP_RATIO * single.maxDrop, cascade.maxDrop);
+}
+
+void test_cascade_recovers_sooner() {
+    Response single = simulate(false);
+    Response cascade = simulate(true);
+
+    TEST_ASSERT_LESS_THAN_FLOAT(MAX_DEVIATION_RATIO * single.deviation, cascade.deviation);
+    TEST_ASSERT_GREATER_THAN_FLOAT(MIN_SINGLE_RECOVERY, static_cast<float>(single.outsideBand));
+    TEST_ASSERT_EQUAL_UINT32(0, cascade.outsideBand);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_settled_before_the_step);
+    RUN_TEST(test_cascade_limits_the_drop);
+    RUN_TEST(test_cascade_recovers_sooner);
+    return UNITY_END();
+}
@@ -0,0 +1,178 @@
+// Stress tests of the command queue between the network and control tasks.
+//
+// Producers are started through the CoreTask shim, which runs them on
+// std::thread on the host, and push as fast as they can while the test
+// thread drains the queue like the control task does.
+
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "system/core_task.h"
+#include "system/mpsc_queue.h"
+
+static const uint32_t ITEMS = 2000000;
+static const uint32_t PRODUCERS = 4;
+
+// The check word catches an item read while it was being written
+struct Item {
+    uint32_t sequence;
+    uint32_t check;
+    uint32_t producer;
+};
+
+// Same capacity as the ProtocolManager's command queue
+using Queue = MpscQueue<Item, 32>;
+
+struct Producer {
+    Queue* queue;
+    uint32_t id;
+    uint32_t count;
+    uint32_t refused;
+    std::atomic<bool> done;
+};
+
+static void produce(void* arg) {
+    Producer* producer = static_cast<Producer*>(arg);
+    for (uint32_t i = 0; i < producer->count;) {
+        if (producer->queue->push({i, ~i, producer->id})) {
+            i++;
+        } else {
+            producer->refused++;
+            std::this_thread::yield();
+        }
+    }
+    producer->done = true;
+}
+
+static bool allDone(const Producer* producers, uint32_t count) {
+    for (uint32_t p = 0; p < count; p++) {
+        if (!producers[p].done) return false;
+    }
+    return true;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_full_queue_refuses_and_counts() {
+    Queue queue;
+    for (uint32_t i = 0; i < Queue::capacity(); i++) {
+        TEST_ASSERT_TRUE(queue.push({i, ~i, 0}));
+    }
+    TEST_ASSERT_FALSE(queue.push({99, ~99u, 0}));
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getDroppedCount());
+
+    Item item;
+    TEST_ASSERT_TRUE(queue.pop(item));
+    TEST_ASSERT_EQUAL_UINT32(0, item.sequence);
+    TEST_ASSERT_TRUE(queue.push({100, ~100u, 0}));
+    for (uint32_t i = 1; i < Queue::capacity(); i++) {
+        TEST_ASSERT_TRUE(queue.pop(item));
+        TEST_ASSERT_EQUAL_UINT32(i, item.sequence);
+    }
+    TEST_ASSERT_TRUE(queue.pop(item));
+    TEST_ASSERT_EQUAL_UINT32(100, item.sequence);
+    TEST_ASSERT_FALSE(queue.pop(item));
+}
+
+void test_single_producer_keeps_order() {
+    // Static, the producer task may outlive a failed assertion
+    static Queue queue;
+    static Producer producer = {&queue, 0, ITEMS, 0, {false}};
+    TEST_ASSERT_TRUE(CoreTask::start("producer", produce, &producer, CoreTask::NETWORK_CORE, 4096, 1));
+
+    uint32_t expected = 0;
+    uint32_t misordered = 0;
+    uint32_t torn = 0;
+    Item item;
+    while (expected < ITEMS) {
+        if (!queue.pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item.check != ~item.sequence) torn++;
+        if (item.sequence != expected) misordered++;
+        expected = item.sequence + 1;
+    }
+    while (!producer.done) {
+        std::this_thread::yield();
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, misordered);
+    TEST_ASSERT_FALSE(queue.pop(item));
+    TEST_ASSERT_EQUAL_UINT32(producer.refused, queue.getDroppedCount());
+}
+
+// Every item of every producer arrives once, in that producer's order; the
+// rate is reported, not checked
+void test_multiple_producers_lose_and_repeat_nothing() {
+    static Queue queue;
+    static Producer producers[PRODUCERS];
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t p = 0; p < PRODUCERS; p++) {
+        producers[p].queue = &queue;
+        producers[p].id = p;
+        producers[p].count = ITEMS;
+        TEST_ASSERT_TRUE(CoreTask::start("producer", produce, &producers[p], CoreTask::NETWORK_CORE, 4096, 1));
+    }
+
+    uint32_t expected[PRODUCERS] = {};
+    uint32_t received = 0;
+    uint32_t lost = 0;
+    uint32_t repeated = 0;
+    uint32_t torn = 0;
+    Item item;
+    while (true) {
+        if (!queue.pop(item)) {
+            // A producer is done only after its last push, one more pop sees that
+            if (!allDone(producers, PRODUCERS)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (!queue.pop(item)) {
+                break;
+            }
+        }
+        received++;
+        if (item.producer >= PRODUCERS || item.check != ~item.sequence) {
+            torn++;
+            continue;
+        }
+        uint32_t& next = expected[item.producer];
+        if (item.sequence < next) {
+            repeated++;
+        } else {
+            lost += item.sequence - next;
+            next = item.sequence + 1;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (uint32_t p = 0; p < PRODUCERS; p++) {
+        lost += ITEMS - expected[p];
+    }
+
+    uint32_t refused = 0;
+    for (uint32_t p = 0; p < PRODUCERS; p++) refused += producers[p].refused;
+    char message[112];
+    snprintf(message, sizeof(message), "%u producers: %.1f M items/s, %u pushes refused while full", PRODUCERS,
+             PRODUCERS * ITEMS / seconds / 1e6, refused);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, repeated);
+    TEST_ASSERT_EQUAL_UINT32(0, lost);
+    TEST_ASSERT_EQUAL_UINT32(PRODUCERS * ITEMS, received);
+    TEST_ASSERT_FALSE(queue.pop(item));
+    TEST_ASSERT_EQUAL_UINT32(refused, queue.getDroppedCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_queue_refuses_and_counts);
+    RUN_TEST(test_single_producer_keeps_order);
+    RUN_TEST(test_multiple_producers_lose_and_repeat_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,174 @@
+// ConfigManager against the LittleFS stand-in, mounted on a temporary
+// directory.
+//
+// Settings saved by one ConfigManager must come back in the next, zones
+// must keep their entries through a save, and missing or broken files must
+// leave the defaults in place. The config.json shipped in data/ must load.
+
+#include <unity.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "config_manager.h"
+#include "native_hal.h"
+
+static char root[] = "/tmp/config_manager_XXXXXX";
+
+static void writeConfig(const char* json) {
+    FILE* file = fopen((std::string(root) + "/config.json").c_str(), "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs(json, file);
+    fclose(file);
+}
+
+static void assertGroupAddress(uint8_t main, uint8_t middle, uint8_t sub, const KNXPhysicalAddress& address) {
+    TEST_ASSERT_EQUAL_UINT8(main, address.area);
+    TEST_ASSERT_EQUAL_UINT8(middle, address.line);
+    TEST_ASSERT_EQUAL_UINT8(sub, address.member);
+}
+
+void setUp() {
+    strcpy(root, "/tmp/config_manager_XXXXXX");
+    TEST_ASSERT_NOT_NULL(mkdtemp(root));
+    NativeHal::setFilesystemRoot(root);
+}
+
+void tearDown() {
+    remove((std::string(root) + "/config.json").c_str());
+    rmdir(root);
+    NativeHal::setFilesystemRoot("");
+}
+
+void test_begin_fails_without_file_system() {
+    NativeHal::setFilesystemRoot("");
+    ConfigManager config;
+    TEST_ASSERT_FALSE(config.begin());
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ThermostatStatus::ERROR_FILESYSTEM), static_cast<int>(config.getLastError()));
+}
+
+void test_missing_file_keeps_defaults() {
+    ConfigManager config;
+    TEST_ASSERT_FALSE(config.begin());
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ThermostatStatus::ERROR_CONFIGURATION), static_cast<int>(config.getLastError()));
+    TEST_ASSERT_EQUAL_STRING("ESP32 Thermostat", config.getDeviceName());
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, config.getKp());
+    TEST_ASSERT_EQUAL_UINT8(0, config.getZoneCount());
+}
+
+void test_broken_file_is_rejected() {
+    writeConfig("{\"pid\": {\"kp\": 5.0,");
+    ConfigManager config;
+    TEST_ASSERT_FALSE(config.begin());
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, config.getKp());
+}
+
+void test_saved_settings_load_back() {
+    ConfigManager saved;
+    saved.setDeviceName("Living room");
+    saved.setSendInterval(15000);
+    saved.setWebUsername("owner");
+    saved.setKnxEnabled(true);
+    saved.setKnxPhysicalAddress(1, 2, 3);
+    saved.setMQTTServer("broker.local");
+    saved.setMQTTPort(8883);
+    saved.setKp(3.5f);
+    saved.setKi(0.25f);
+    saved.setKd(0.0f);
+    ValveGovernorConfig valve = saved.getValveConfig();
+    valve.minDelta = 3.0f;
+    valve.refreshInterval = 600000;
+    saved.setValveConfig(valve);
+    saved.setControlEngine(ControlEngine::HYSTERESIS);
+    HysteresisConfig hysteresis = saved.getHysteresisConfig();
+    hysteresis.bands[static_cast<int>(ThermostatMode::COMFORT)] = 0.3f;
+    saved.setHysteresisConfig(hysteresis);
+    CascadeConfig cascade = saved.getCascadeConfig();
+    cascade.enabled = true;
+    cascade.maxFlow = 45.0f;
+    saved.setCascadeConfig(cascade);
+    OutboundConfig outbound = saved.getOutboundConfig();
+    outbound.burst = 4;
+    saved.setOutboundConfig(outbound);
+    TEST_ASSERT_TRUE(saved.saveConfig());
+
+    ConfigManager loaded;
+    TEST_ASSERT_TRUE(loaded.begin());
+    TEST_ASSERT_EQUAL_STRING("Living room", loaded.getDeviceName());
+    TEST_ASSERT_EQUAL_UINT32(15000, loaded.getSendInterval());
+    TEST_ASSERT_EQUAL_STRING("owner", loaded.getWebUsername());
+    TEST_ASSERT_TRUE(loaded.getKnxEnabled());
+    uint8_t area, line, member;
+    loaded.getKnxPhysicalAddress(area, line, member);
+    TEST_ASSERT_EQUAL_UINT8(1, area);
+    TEST_ASSERT_EQUAL_UINT8(2, line);
+    TEST_ASSERT_EQUAL_UINT8(3, member);
+    TEST_ASSERT_EQUAL_STRING("broker.local", loaded.getMQTTServer());
+    TEST_ASSERT_EQUAL_UINT16(8883, loaded.getMQTTPort());
+    TEST_ASSERT_EQUAL_FLOAT(3.5f, loaded.getKp());
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, loaded.getKi());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, loaded.getKd());
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, loaded.getValveConfig().minDelta);
+    TEST_ASSERT_EQUAL_UINT32(600000, loaded.getValveConfig().refreshInterval);
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ControlEngine::HYSTERESIS), static_cast<int>(loaded.getControlEngine()));
+    TEST_ASSERT_EQUAL_FLOAT(0.3f, loaded.getHysteresisConfig().bands[static_cast<int>(ThermostatMode::COMFORT)]);
+    TEST_ASSERT_TRUE(loaded.getCascadeConfig().enabled);
+    TEST_ASSERT_EQUAL_FLOAT(45.0f, loaded.getCascadeConfig().maxFlow);
+    TEST_ASSERT_EQUAL_UINT8(4, loaded.getOutboundConfig().burst);
+}
+
+void test_zones_keep_their_entries_through_a_save() {
+    writeConfig("{\"zones\": ["
+                "{\"name\": \"Kitchen\", \"setpoint\": 20.5, \"mqtt\": \"kitchen\","
+                " \"knx\": {\"temperature\": {\"main\": 2, \"middle\": 1, \"sub\": 1},"
+                "         \"valve\": {\"main\": 2, \"middle\": 1, \"sub\": 3}}},"
+                "{\"name\": \"Bath\", \"engine\": \"hysteresis\"}"
+                "]}");
+
+    ConfigManager config;
+    TEST_ASSERT_TRUE(config.begin());
+    TEST_ASSERT_EQUAL_UINT8(2, config.getZoneCount());
+    const ZoneConfig& kitchen = config.getZone(0);
+    TEST_ASSERT_EQUAL_STRING("Kitchen", kitchen.name);
+    TEST_ASSERT_EQUAL_FLOAT(20.5f, kitchen.setpoint);
+    TEST_ASSERT_EQUAL_STRING("kitchen", kitchen.mqttPrefix);
+    assertGroupAddress(2, 1, 1, kitchen.temperatureGA);
+    assertGroupAddress(2, 1, 3, kitchen.valveGA);
+    assertGroupAddress(0, 0, 0, kitchen.setpointGA);
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ControlEngine::PID), static_cast<int>(kitchen.engine));
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ControlEngine::HYSTERESIS), static_cast<int>(config.getZone(1).engine));
+
+    // Only the engine of a zone changes at runtime
+    config.setZoneEngine(0, ControlEngine::HYSTERESIS);
+    TEST_ASSERT_TRUE(config.saveConfig());
+
+    ConfigManager loaded;
+    TEST_ASSERT_TRUE(loaded.begin());
+    TEST_ASSERT_EQUAL_UINT8(2, loaded.getZoneCount());
+    TEST_ASSERT_EQUAL_STRING("Kitchen", loaded.getZone(0).name);
+    assertGroupAddress(2, 1, 3, loaded.getZone(0).valveGA);
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ControlEngine::HYSTERESIS), static_cast<int>(loaded.getZone(0).engine));
+    TEST_ASSERT_EQUAL_STRING("Bath", loaded.getZone(1).name);
+}
+
+void test_shipped_config_loads() {
+    // Read only, nothing is saved into the project
+    NativeHal::setFilesystemRoot("data");
+    ConfigManager config;
+    TEST_ASSERT_TRUE(config.begin());
+    TEST_ASSERT_EQUAL_STRING("192.168.178.32", config.getMQTTServer());
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, config.getValveConfig().minDelta);
+    TEST_ASSERT_EQUAL_FLOAT(0.8f, config.getHysteresisConfig().bands[static_cast<int>(ThermostatMode::ECO)]);
+    TEST_ASSERT_EQUAL_UINT32(300000, config.getFailsafeConfig().timeout);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_fails_without_file_system);
+    RUN_TEST(test_missing_file_keeps_defaults);
+    RUN_TEST(test_broken_file_is_rejected);
+    RUN_TEST(test_saved_settings_load_back);
+    RUN_TEST(test_zones_keep_their_entries_through_a_save);
+    RUN_TEST(test_shipped_config_loads);
+    return UNITY_END();
+}
@@ -0,0 +1,181 @@
+// Echo suppression of ProtocolManager with a KNX/MQTT bridge.
+//
+// Two fake protocols stand for KNX and MQTT. In the loopback tests a
+// bridge returns everything sent on one as a command on the other, as a
+// KNX to MQTT gateway in the building would. Echoes must be dropped, real
+// commands must not, also when they restore a value sent shortly before.
+
+#include <unity.h>
+#include <cmath>
+#include <vector>
+#include "protocol_manager.h"
+
+struct Wire {
+    CommandSource to;
+    CommandType type;
+    float value;
+    uint8_t zone;
+};
+
+// Values in flight through the bridge
+static std::vector<Wire> wire;
+
+// DPT 9 keeps 11 bits of mantissa at 0.01 resolution
+static float dpt9(float value) {
+    int exponent = 0;
+    float mantissa = value * 100.0f;
+    while (fabsf(mantissa) > 2047.0f) {
+        mantissa /= 2.0f;
+        exponent++;
+    }
+    return roundf(mantissa) * (1 << exponent) / 100.0f;
+}
+
+class BridgedProtocol : public ProtocolInterface {
+public:
+    BridgedProtocol(const char* name, CommandSource source, CommandSource peer)
+        : name(name), source(source), peer(peer) {}
+
+    std::vector<float> setpoints;
+    bool bridged = false;
+
+    bool begin() override { return true; }
+    void loop() override {}
+    bool isConnected() const override { return true; }
+    void disconnect() override {}
+    bool reconnect() override { return true; }
+    bool configure(const JsonDocument&) override { return true; }
+    bool validateConfig() const override { return true; }
+    void getConfig(JsonDocument&) const override {}
+    bool sendTemperature(float) override { return true; }
+    bool sendHumidity(float) override { return true; }
+    bool sendPressure(float) override { return true; }
+    bool sendSetpoint(float value) override { return send(CommandType::CMD_SETPOINT, value, 0); }
+    bool sendValvePosition(float) override { return true; }
+    bool sendMode(ThermostatMode) override { return true; }
+    bool sendHeatingState(bool) override { return true; }
+    bool sendZoneValue(uint8_t zone, CommandType type, float value) override { return send(type, value, zone); }
+    uint32_t getCapabilities() const override { return ProtocolInterface::getCapabilities() | PROTOCOL_CAP_ZONES; }
+    ThermostatStatus getLastError() const override { return ThermostatStatus::OK; }
+    const char* getLastErrorMessage() const override { return ""; }
+    void clearError() override {}
+    void registerCallbacks(ThermostatState*, ProtocolManager*) override {}
+    void unregisterCallbacks() override {}
+    const char* getProtocolName() const override { return name; }
+    CommandSource getCommandSource() const override { return source; }
+
+private:
+    bool send(CommandType type, float value, uint8_t zone) {
+        if (type == CommandType::CMD_SETPOINT && zone == 0) {
+            setpoints.push_back(value);
+        }
+        if (bridged) {
+            // What the bridge reads back: DPT 9 from KNX, two decimals from MQTT
+            float received = source == CommandSource::SOURCE_KNX ? dpt9(value) : roundf(value * 100.0f) / 100.0f;
+            wire.push_back({peer, type, received, zone});
+        }
+        return true;
+    }
+
+    const char* name;
+    CommandSource source;
+    CommandSource peer;
+};
+
+struct Building {
+    ThermostatState state;
+    ProtocolManager manager;
+    BridgedProtocol knx;
+    BridgedProtocol mqtt;
+
+    explicit Building(bool bridged)
+        : manager(&state)
+        , knx("KNX", CommandSource::SOURCE_KNX, CommandSource::SOURCE_MQTT)
+        , mqtt("MQTT", CommandSource::SOURCE_MQTT, CommandSource::SOURCE_KNX) {
+        wire.clear();
+        knx.bridged = bridged;
+        mqtt.bridged = bridged;
+        manager.addProtocol(&knx);
+        manager.addProtocol(&mqtt);
+        OutboundConfig config = DEFAULT_OUTBOUND_CONFIG;
+        config.echoWindow = 3000;
+        manager.configureOutbound(config);
+    }
+
+    // One pass of the network and control tasks, the bridge delivers in between
+    void run(int passes) {
+        for (int i = 0; i < passes; i++) {
+            manager.flushOutbound();
+            std::vector<Wire> arriving;
+            arriving.swap(wire);
+            for (const Wire& message : arriving) {
+                manager.receiveCommand(message.to, message.type, message.value, message.zone);
+            }
+            manager.processCommands();
+        }
+    }
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_bridge_echoes_are_dropped() {
+    Building building(true);
+    building.state.setTargetTemperature(21.37f);
+    building.manager.sendSetpoint(21.37f);
+    building.manager.sendZoneSetpoint(3, 19.5f);
+    building.run(10);
+
+    // Sent once to each side, both returns dropped, nothing bounces
+    TEST_ASSERT_EQUAL_size_t(1, building.knx.setpoints.size());
+    TEST_ASSERT_EQUAL_size_t(1, building.mqtt.setpoints.size());
+    TEST_ASSERT_EQUAL_UINT32(2, building.manager.getEchoCache().getSuppressedCount(CommandSource::SOURCE_KNX));
+    TEST_ASSERT_EQUAL_UINT32(2, building.manager.getEchoCache().getSuppressedCount(CommandSource::SOURCE_MQTT));
+    TEST_ASSERT_TRUE(wire.empty());
+    TEST_ASSERT_EQUAL_FLOAT(21.37f, building.state.getTargetTemperature());
+}
+
+void test_bridged_user_command_is_forwarded_once() {
+    Building building(true);
+    building.state.setTargetTemperature(21.0f);
+    building.manager.sendSetpoint(21.0f);
+    building.run(3);
+
+    // Set on MQTT, forwarded to KNX, which the bridge returns to MQTT
+    TEST_ASSERT_TRUE(building.manager.receiveCommand(CommandSource::SOURCE_MQTT, CommandType::CMD_SETPOINT, 22.5f));
+    building.run(10);
+
+    TEST_ASSERT_EQUAL_FLOAT(22.5f, building.state.getTargetTemperature());
+    TEST_ASSERT_EQUAL_size_t(2, building.knx.setpoints.size());
+    TEST_ASSERT_EQUAL_FLOAT(22.5f, building.knx.setpoints.back());
+    TEST_ASSERT_EQUAL_size_t(1, building.mqtt.setpoints.size());
+    TEST_ASSERT_TRUE(wire.empty());
+}
+
+// Sent 21 to both, the user sets 22 and back to 21 on MQTT within the window
+void test_command_restoring_an_earlier_value_is_applied() {
+    Building building(false);
+    building.state.setTargetTemperature(21.0f);
+    building.manager.sendSetpoint(21.0f);
+    building.run(1);
+    TEST_ASSERT_EQUAL_size_t(1, building.mqtt.setpoints.size());
+
+    TEST_ASSERT_TRUE(building.manager.receiveCommand(CommandSource::SOURCE_MQTT, CommandType::CMD_SETPOINT, 22.0f));
+    building.run(2);
+    TEST_ASSERT_EQUAL_FLOAT(22.0f, building.state.getTargetTemperature());
+    TEST_ASSERT_EQUAL_FLOAT(22.0f, building.knx.setpoints.back());
+
+    TEST_ASSERT_TRUE(building.manager.receiveCommand(CommandSource::SOURCE_MQTT, CommandType::CMD_SETPOINT, 21.0f));
+    building.run(2);
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, building.state.getTargetTemperature());
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, building.knx.setpoints.back());
+    TEST_ASSERT_EQUAL_UINT32(0, building.manager.getEchoCache().getSuppressedCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bridge_echoes_are_dropped);
+    RUN_TEST(test_bridged_user_command_is_forwarded_once);
+    RUN_TEST(test_command_restoring_an_earlier_value_is_applied);
+    return UNITY_END();
+}
@@ -0,0 +1,97 @@
+// HysteresisController activation and configuration from other tasks.
+//
+// A writer calls configure() with configurations whose bands and output
+// all carry the same value while the control thread keeps computing; the
+// configuration the control thread takes over must never mix two writes.
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "thermostat_state.h"
+#include "control/hysteresis_controller.h"
+
+static const int WRITES = 200000;
+
+static HysteresisConfig configFor(int value) {
+    HysteresisConfig config;
+    float v = static_cast<float>(value % 1000) / 100.0f;
+    for (uint8_t i = 0; i < THERMOSTAT_MODE_COUNT; i++) config.bands[i] = v;
+    config.onOutput = v;
+    return config;
+}
+
+static bool isConsistent(const HysteresisConfig& config) {
+    for (uint8_t i = 0; i < THERMOSTAT_MODE_COUNT; i++) {
+        if (config.bands[i] != config.onOutput) return false;
+    }
+    return true;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_enabled_state_alone_controls() {
+    ThermostatState state;
+    HysteresisController controller(&state);
+    controller.begin();
+    controller.setSetpoint(21.0f);
+
+    controller.update(18.0f);
+    TEST_ASSERT_FALSE(controller.isHeating());
+
+    state.setEnabled(true);
+    TEST_ASSERT_TRUE(controller.isActive());
+    controller.update(18.0f);
+    TEST_ASSERT_TRUE(controller.isHeating());
+
+    // Deactivating is not a way to stop control, disabling the state is
+    controller.setActive(false);
+    controller.update(18.0f);
+    TEST_ASSERT_TRUE(controller.isHeating());
+    state.setEnabled(false);
+    controller.update(18.0f);
+    TEST_ASSERT_FALSE(controller.isHeating());
+    TEST_ASSERT_FALSE(controller.isActive());
+}
+
+void test_concurrent_configure_is_never_torn() {
+    ThermostatState state;
+    state.setEnabled(true);
+    HysteresisController controller(&state);
+    controller.begin();
+    HysteresisConfig initial = configFor(0);
+    controller.configure(&initial);
+    controller.update(20.0f);
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> passes(0), torn(0);
+    std::thread control([&]() {
+        while (!stop.load()) {
+            controller.update(20.0f);
+            if (!isConsistent(controller.getConfig())) torn++;
+            passes++;
+        }
+    });
+
+    for (int i = 0; i < WRITES; i++) {
+        HysteresisConfig config = configFor(i);
+        controller.configure(&config);
+    }
+    stop = true;
+    control.join();
+
+    TEST_ASSERT_GREATER_THAN_UINT32(0, passes.load());
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+
+    // The last write is taken over on the next pass
+    controller.update(20.0f);
+    HysteresisConfig last = configFor(WRITES - 1);
+    TEST_ASSERT_EQUAL_FLOAT(last.onOutput, controller.getConfig().onOutput);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_enabled_state_alone_controls);
+    RUN_TEST(test_concurrent_configure_is_never_torn);
+    return UNITY_END();
+}
@@ -0,0 +1,146 @@
+// Two-point control against PID on a slow room, on a simulated clock.
+//
+// The room is the native simulator's first-order model slowed down to a
+// four hour time constant, like a screed floor. The hysteresis engine uses
+// the shared switching rule with the default comfort band, the PID the
+// firmware's default gains and sample time, driving either a valve through
+// the ValveGovernor or an on/off actuator through PwmOutput. After a two
+// hour warm-up, two-point control must start the heater far less often
+// than PID modulation does, and keep the room at least as close to the
+// setpoint.
+
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "thermostat_state.h"
+#include "control/pid_controller.h"
+#include "control/hysteresis_controller.h"
+#include "control/valve_governor.h"
+#include "control/pwm_output.h"
+
+static const float SETPOINT = 21.0f;
+static const float OUTDOOR = 5.0f;
+static const float HEATER_GAIN = 25.0f;          // Rise above outdoor at full power, K
+static const float ROOM_TAU = 4 * 3600.0f;       // Seconds
+static const unsigned long STEP = 1000;          // Room integration step, ms
+static const unsigned long RUN_TIME = 24 * 3600000UL;
+static const unsigned long WARMUP = 2 * 3600000UL;
+static const PwmOutputConfig PWM_CONFIG = {true, 300000, 120000, 120000, 2.0f};
+static const float MAX_START_RATIO = 0.6f;       // Hysteresis starts per PID start or valve move, about 0.5 measured
+static const float MAX_MEAN_DEVIATION = 0.2f;    // K
+
+static ThermostatState state;
+
+struct Result {
+    uint32_t starts;       // Heater going from off to on, or valve moves
+    float meanDeviation;
+    float maxDeviation;
+};
+
+enum class Engine { HYSTERESIS, PID_VALVE, PID_PWM };
+
+static Result simulate(Engine engine) {
+    PIDConfig pidConfig = PIDController(&state).getConfig();
+    unsigned long sampleTime = static_cast<unsigned long>(pidConfig.sampleTime);
+    float band = DEFAULT_HYSTERESIS_CONFIG.bands[static_cast<int>(ThermostatMode::COMFORT)];
+
+    PidKernel<FloatMath> pid;
+    pid.setGains(pidConfig.kp, pidConfig.ki, pidConfig.kd);
+    pid.setDerivativeFilter(PID_DERIVATIVE_FILTER_SAMPLES);
+    pid.setOutputLimits(pidConfig.minOutput, pidConfig.maxOutput);
+    ValveGovernor governor;
+    PwmOutput pwm;
+    pwm.configure(PWM_CONFIG);
+
+    float temperature = 18.0f;
+    pid.reset(temperature);
+    bool heating = false;
+    float power = 0.0f;
+    Result result = {0, 0.0f, 0.0f};
+    double deviation = 0.0;
+    unsigned long samples = 0;
+
+    for (unsigned long now = 0; now < RUN_TIME; now += STEP) {
+        float lastPower = power;
+        if (now % sampleTime == 0) {
+            if (engine == Engine::HYSTERESIS) {
+                heating = HysteresisController::step(heating, SETPOINT, temperature, band);
+                power = heating ? 100.0f : 0.0f;
+            } else {
+                float output = pid.compute(SETPOINT, temperature, 1.0f);
+                float position;
+                if (engine == Engine::PID_PWM) {
+                    pwm.setDuty(output);
+                } else if (governor.update(output, now, position) == ValveAction::MOVE) {
+                    power = position;
+                    if (now >= WARMUP) result.starts++;
+                }
+            }
+        }
+        if (engine == Engine::PID_PWM) {
+            power = pwm.update(now) ? 100.0f : 0.0f;
+        }
+        if (engine != Engine::PID_VALVE && lastPower <= 0.0f && power > 0.0f && now >= WARMUP) {
+            result.starts++;
+        }
+
+        temperature += (OUTDOOR + HEATER_GAIN * power / 100.0f - temperature) * (STEP / 1000.0f) / ROOM_TAU;
+
+        if (now >= WARMUP) {
+            float error = fabsf(temperature - SETPOINT);
+            deviation += error;
+            if (error > result.maxDeviation) result.maxDeviation = error;
+            samples++;
+        }
+    }
+    result.meanDeviation = static_cast<float>(deviation / samples);
+    return result;
+}
+
+static void report(const char* name, const Result& result) {
+    char message[128];
+    snprintf(message, sizeof(message), "%s: %u starts, mean deviation %.2f K, max %.2f K", name,
+             static_cast<unsigned>(result.starts), result.meanDeviation, result.maxDeviation);
+    TEST_MESSAGE(message);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_hysteresis_starts_less_often_than_pid_pwm() {
+    Result hysteresis = simulate(Engine::HYSTERESIS);
+    Result pid = simulate(Engine::PID_PWM);
+    report("hysteresis", hysteresis);
+    report("PID + PWM", pid);
+
+    TEST_ASSERT_GREATER_THAN_UINT32(0, hysteresis.starts);
+    TEST_ASSERT_LESS_THAN_FLOAT(MAX_START_RATIO * pid.starts, static_cast<float>(hysteresis.starts));
+    TEST_ASSERT_LESS_THAN_FLOAT(MAX_MEAN_DEVIATION, hysteresis.meanDeviation);
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(pid.meanDeviation, hysteresis.meanDeviation);
+}
+
+void test_hysteresis_actuates_less_often_than_pid_valve() {
+    Result hysteresis = simulate(Engine::HYSTERESIS);
+    Result pid = simulate(Engine::PID_VALVE);
+    report("hysteresis", hysteresis);
+    report("PID valve moves", pid);
+
+    TEST_ASSERT_LESS_THAN_FLOAT(MAX_START_RATIO * pid.starts, static_cast<float>(hysteresis.starts));
+}
+
+void test_hysteresis_stays_within_band() {
+    Result hysteresis = simulate(Engine::HYSTERESIS);
+    float band = DEFAULT_HYSTERESIS_CONFIG.bands[static_cast<int>(ThermostatMode::COMFORT)];
+
+    // The slow room overshoots the band edges by little more than one sample's drift
+    TEST_ASSERT_LESS_THAN_FLOAT(band, hysteresis.maxDeviation);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_hysteresis_starts_less_often_than_pid_pwm);
+    RUN_TEST(test_hysteresis_actuates_less_often_than_pid_valve);
+    RUN_TEST(test_hysteresis_stays_within_band);
+    return UNITY_END();
+}
@@ -0,0 +1,118 @@
+// KNXInterface on the KNX/IP bus stand-in of NativeHal.
+//
+// Telegrams injected on a group address must arrive at the ProtocolManager
+// as the command the address was configured for, and zone values must go
+// out as DPT 9 telegrams on the zone's addresses.
+
+#include <unity.h>
+#include <vector>
+#include "knx/knx_interface.h"
+#include "native_hal.h"
+#include "protocol_manager.h"
+
+static std::vector<ProtocolCommand> zoneCommands;
+
+static void recordZoneCommand(const ProtocolCommand& command) {
+    zoneCommands.push_back(command);
+}
+
+// DPT 9 bytes as a KNX sensor sends them
+static NativeHal::KnxTelegram write(uint16_t address, uint8_t high, uint8_t low) {
+    return {address, KNX_CT_WRITE, {high, low}};
+}
+
+struct Bus {
+    ThermostatState state;
+    ProtocolManager manager;
+    KNXInterface knx;
+
+    Bus() : manager(&state), knx(&state) {
+        StaticJsonDocument<256> config;
+        config["physical"]["area"] = 1;
+        config["physical"]["line"] = 1;
+        config["physical"]["member"] = 160;
+        TEST_ASSERT_TRUE(knx.configure(config));
+        TEST_ASSERT_TRUE(knx.begin());
+        knx.registerProtocolManager(&manager);
+        manager.onZoneCommand(&recordZoneCommand);
+    }
+
+    // One pass of the network task, then of the control task
+    void run() {
+        knx.loop();
+        manager.processCommands();
+    }
+};
+
+void setUp() {
+    NativeHal::clearKnxTelegrams();
+    zoneCommands.clear();
+}
+
+void tearDown() {}
+
+void test_zone_temperature_reaches_the_manager() {
+    Bus bus;
+    bus.knx.setZoneGroupAddresses(2, {{2, 1, 1}, {2, 1, 2}, {2, 1, 3}, {0, 0, 0}});
+
+    // 21.5 C, and a telegram on an address nobody listens to
+    NativeHal::injectKnxTelegram(write(NativeHal::knxGroupAddress(2, 1, 1), 0x0C, 0x33));
+    NativeHal::injectKnxTelegram(write(NativeHal::knxGroupAddress(2, 1, 9), 0x0C, 0x33));
+    bus.run();
+
+    TEST_ASSERT_EQUAL_size_t(1, zoneCommands.size());
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(CommandType::CMD_SET_TEMPERATURE), static_cast<int>(zoneCommands[0].type));
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(CommandSource::SOURCE_KNX), static_cast<int>(zoneCommands[0].source));
+    TEST_ASSERT_EQUAL_UINT8(2, zoneCommands[0].zone);
+    TEST_ASSERT_EQUAL_FLOAT(21.5f, zoneCommands[0].value);
+}
+
+void test_read_requests_are_ignored() {
+    Bus bus;
+    bus.knx.setZoneGroupAddresses(1, {{2, 1, 1}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}});
+
+    NativeHal::injectKnxTelegram({NativeHal::knxGroupAddress(2, 1, 1), KNX_CT_READ, {}});
+    bus.run();
+
+    TEST_ASSERT_TRUE(zoneCommands.empty());
+}
+
+void test_outdoor_temperature_updates_the_state() {
+    Bus bus;
+    bus.knx.setOutdoorTemperatureGA({3, 0, 1});
+    TEST_ASSERT_FALSE(bus.state.hasOutdoorTemperature());
+
+    // -5.0 C
+    NativeHal::injectKnxTelegram(write(NativeHal::knxGroupAddress(3, 0, 1), 0x86, 0x0C));
+    bus.run();
+
+    TEST_ASSERT_TRUE(bus.state.hasOutdoorTemperature());
+    TEST_ASSERT_EQUAL_FLOAT(-5.0f, bus.state.getOutdoorTemperature());
+}
+
+void test_zone_valve_is_sent_as_dpt9() {
+    Bus bus;
+    bus.knx.setZoneGroupAddresses(3, {{0, 0, 0}, {0, 0, 0}, {2, 3, 7}, {0, 0, 0}});
+
+    TEST_ASSERT_TRUE(bus.knx.sendZoneValue(3, CommandType::CMD_VALVE, 40.0f));
+    // No setpoint address for the zone, and no zone 4 at all
+    TEST_ASSERT_FALSE(bus.knx.sendZoneValue(3, CommandType::CMD_SETPOINT, 21.0f));
+    TEST_ASSERT_FALSE(bus.knx.sendZoneValue(4, CommandType::CMD_VALVE, 40.0f));
+
+    const std::vector<NativeHal::KnxTelegram>& sent = NativeHal::getKnxTelegrams();
+    TEST_ASSERT_EQUAL_size_t(1, sent.size());
+    TEST_ASSERT_EQUAL_HEX16(NativeHal::knxGroupAddress(2, 3, 7), sent[0].address);
+    TEST_ASSERT_EQUAL_UINT8(KNX_CT_WRITE, sent[0].command);
+    TEST_ASSERT_EQUAL_size_t(2, sent[0].data.size());
+    TEST_ASSERT_EQUAL_HEX8(0x0F, sent[0].data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xD0, sent[0].data[1]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_zone_temperature_reaches_the_manager);
+    RUN_TEST(test_read_requests_are_ignored);
+    RUN_TEST(test_outdoor_temperature_updates_the_state);
+    RUN_TEST(test_zone_valve_is_sent_as_dpt9);
+    return UNITY_END();
+}
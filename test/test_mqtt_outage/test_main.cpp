@@ -0,0 +1,153 @@
+// MQTTInterface across broker outages.
+//
+// The broker behind the PubSubClient stand-in is stopped while values are
+// sent and started again. Every live topic must end up with the newest
+// value, also when the link drops again during the reconnect burst, and
+// the history must be replayed oldest first without gaps or repeats.
+
+#include <unity.h>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include "communication/mqtt/mqtt_interface.h"
+
+static const char* PREFIX = "esp32/thermostat/";
+
+static void startMqtt(MQTTInterface& mqtt) {
+    NativeHal::setMqttBrokerRunning(true);
+    NativeHal::setMqttPublishLimit(-1);
+    NativeHal::clearMqttMessages();
+    mqtt.setServer("localhost", 1883);
+    mqtt.setBacklogConfig({true, 0, 1000.0f});  // RAM only, fast replay
+    mqtt.setEnabled(true);
+    TEST_ASSERT_TRUE(mqtt.begin());
+}
+
+// Last payload per live topic, history topics left out
+static std::map<std::string, std::string> liveTopics() {
+    std::map<std::string, std::string> topics;
+    for (const NativeHal::MqttMessage& message : NativeHal::getMqttMessages()) {
+        if (message.topic.find("history/") == std::string::npos) {
+            topics[message.topic.substr(strlen(PREFIX))] = message.payload;
+        }
+    }
+    return topics;
+}
+
+static void sendAll(MQTTInterface& mqtt, float base) {
+    mqtt.sendTemperature(base);
+    mqtt.sendSetpoint(base + 1.0f);
+    mqtt.sendValvePosition(base + 2.0f);
+    mqtt.sendHeatingState(true);
+}
+
+static void checkNewest(float base) {
+    char expected[16];
+    std::map<std::string, std::string> topics = liveTopics();
+    snprintf(expected, sizeof(expected), "%.2f", base);
+    TEST_ASSERT_EQUAL_STRING(expected, topics["temperature"].c_str());
+    snprintf(expected, sizeof(expected), "%.2f", base + 1.0f);
+    TEST_ASSERT_EQUAL_STRING(expected, topics["setpoint"].c_str());
+    snprintf(expected, sizeof(expected), "%.2f", base + 2.0f);
+    TEST_ASSERT_EQUAL_STRING(expected, topics["valve"].c_str());
+    TEST_ASSERT_EQUAL_STRING("ON", topics["heating"].c_str());
+}
+
+static void drainBacklog(MQTTInterface& mqtt) {
+    for (int i = 0; i < 5000 && mqtt.getBacklogSize() > 0 && mqtt.isConnected(); i++) {
+        mqtt.loop();
+        delay(1);
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_restart_publishes_newest_values() {
+    ThermostatState state;
+    MQTTInterface mqtt(&state);
+    startMqtt(mqtt);
+    sendAll(mqtt, 18.0f);
+
+    NativeHal::setMqttBrokerRunning(false);
+    for (int i = 0; i < 10; i++) {
+        sendAll(mqtt, 19.0f + i);
+    }
+    TEST_ASSERT_FALSE(mqtt.isConnected());
+
+    NativeHal::setMqttBrokerRunning(true);
+    TEST_ASSERT_TRUE(mqtt.reconnect());
+    checkNewest(28.0f);
+}
+
+void test_link_drop_during_burst_keeps_newest_values() {
+    ThermostatState state;
+    MQTTInterface mqtt(&state);
+    startMqtt(mqtt);
+    sendAll(mqtt, 18.0f);
+
+    NativeHal::setMqttBrokerRunning(false);
+    sendAll(mqtt, 20.0f);
+
+    // The status and one live value get through, then the link drops again
+    NativeHal::setMqttBrokerRunning(true);
+    NativeHal::setMqttPublishLimit(2);
+    mqtt.reconnect();
+    TEST_ASSERT_FALSE(NativeHal::isMqttBrokerRunning());
+    mqtt.loop();
+    TEST_ASSERT_FALSE(mqtt.isConnected());
+
+    NativeHal::setMqttBrokerRunning(true);
+    TEST_ASSERT_TRUE(mqtt.reconnect());
+    checkNewest(20.0f);
+}
+
+void test_history_is_replayed_in_order_across_restarts() {
+    const int SENDS = 50;  // Below the RAM ring, nothing is dropped
+    ThermostatState state;
+    MQTTInterface mqtt(&state);
+    startMqtt(mqtt);
+
+    NativeHal::setMqttBrokerRunning(false);
+    for (int i = 0; i < SENDS; i++) {
+        mqtt.sendTemperature(10.0f + i * 0.25f);
+    }
+    TEST_ASSERT_EQUAL_size_t(SENDS, mqtt.getBacklogSize());
+
+    // Killed again part way through the replay
+    NativeHal::setMqttBrokerRunning(true);
+    NativeHal::setMqttPublishLimit(20);
+    TEST_ASSERT_TRUE(mqtt.reconnect());
+    drainBacklog(mqtt);
+    TEST_ASSERT_FALSE(mqtt.isConnected());
+    TEST_ASSERT_GREATER_THAN(0, mqtt.getBacklogSize());
+
+    NativeHal::setMqttBrokerRunning(true);
+    TEST_ASSERT_TRUE(mqtt.reconnect());
+    drainBacklog(mqtt);
+    TEST_ASSERT_EQUAL_size_t(0, mqtt.getBacklogSize());
+
+    int history = 0;
+    for (const NativeHal::MqttMessage& message : NativeHal::getMqttMessages()) {
+        if (message.topic.find("history/") == std::string::npos) {
+            continue;
+        }
+        TEST_ASSERT_FALSE(message.retained);
+        const char* value = strstr(message.payload.c_str(), "\"value\":");
+        TEST_ASSERT_NOT_NULL(value);
+        TEST_ASSERT_EQUAL_FLOAT(10.0f + history * 0.25f, strtof(value + 8, nullptr));
+        history++;
+    }
+    TEST_ASSERT_EQUAL_INT(SENDS, history);
+    TEST_ASSERT_EQUAL_UINT32(SENDS, mqtt.getBacklogStats().replayed);
+    TEST_ASSERT_EQUAL_UINT32(0, mqtt.getBacklogStats().dropped);
+    TEST_ASSERT_EQUAL_STRING("22.25", liveTopics()["temperature"].c_str());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_restart_publishes_newest_values);
+    RUN_TEST(test_link_drop_during_burst_keeps_newest_values);
+    RUN_TEST(test_history_is_replayed_in_order_across_restarts);
+    return UNITY_END();
+}
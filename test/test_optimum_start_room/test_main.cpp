@@ -0,0 +1,154 @@
+// Optimum start on the native simulator's room model, on a simulated clock.
+//
+// Every evening the room is set back and comfort is scheduled for the next
+// morning, as NATIVE_COMFORT does in the simulator. The PID runs with the
+// firmware's default gains and sample time; OptimumStart sees each control
+// pass with the valve position that drove the room, takes over with full
+// output when it starts a preheat and hands back at the learnt holding
+// output, as ControlPipeline does. Every morning the room must reach the
+// comfort setpoint within a few minutes of the comfort time, measured on
+// the room itself, and the estimator must have found the room's true
+// heat-up parameters. The first four hours of plain PID heating are all
+// it has to learn from before the first night.
+
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include "thermostat_state.h"
+#include "control/pid_controller.h"
+#include "control/optimum_start.h"
+
+static const float COMFORT_SETPOINT = 21.0f;
+static const float SETBACK = 17.0f;
+static const float OUTDOOR = 5.0f;
+static const float HEATER_GAIN = 25.0f;          // Rise above outdoor at full power, K
+static const unsigned long STEP = 1000;          // Room integration step, ms
+static const unsigned long HOUR = 3600000UL;
+static const unsigned long DAY = 24 * HOUR;
+static const unsigned long FIRST_SETBACK = 4 * HOUR;
+static const unsigned long NIGHT = 8 * HOUR;     // Setback to comfort time
+static const int DAYS = 8;
+static const long MAX_LATENESS = 15 * 60000L;    // Arrival either side of the comfort time, 1-2 min measured
+static const float MAX_MODEL_ERROR = 0.1f;       // Relative error of the learnt gain and loss
+
+static ThermostatState state;
+
+struct Run {
+    int mornings;
+    long arrival[DAYS];           // Room within END_BAND of comfort after the comfort time, ms, negative when early
+    long reported[DAYS];          // OptimumStart's own lateness
+    float gain;                   // Learnt, K/h at full output
+    float loss;                   // Learnt, 1/h
+};
+
+// Room time constant in hours, outdoor amplitude of a daily swing, coldest at the comfort time
+static Run simulate(float roomTauHours, float outdoorSwing) {
+    PIDConfig pidConfig = PIDController(&state).getConfig();
+    unsigned long sampleTime = static_cast<unsigned long>(pidConfig.sampleTime);
+
+    PidKernel<FloatMath> pid;
+    pid.setGains(pidConfig.kp, pidConfig.ki, pidConfig.kd);
+    pid.setDerivativeFilter(PID_DERIVATIVE_FILTER_SAMPLES);
+    pid.setOutputLimits(pidConfig.minOutput, pidConfig.maxOutput);
+
+    OptimumStart optimumStart;
+    OptimumStartConfig config = DEFAULT_OPTIMUM_START_CONFIG;
+    config.enabled = true;
+    config.deadTime = 0;
+    optimumStart.configure(config);
+    optimumStart.setSetpoint(COMFORT_SETPOINT);
+
+    Run run = {0, {}, {}, 0.0f, 0.0f};
+    float room = 18.0f;
+    float setpoint = COMFORT_SETPOINT;
+    float valve = 0.0f;
+    float outdoor = OUTDOOR;
+    unsigned long nextSetback = FIRST_SETBACK;
+    unsigned long comfortTime = 0;
+    bool waiting = false;         // For the room to reach comfort after a preheat started
+    pid.reset(room);
+
+    for (unsigned long now = 0; now < DAYS * DAY; now += STEP) {
+        unsigned long phaseTime = (now + DAY - (FIRST_SETBACK + NIGHT) % DAY) % DAY;
+        outdoor = OUTDOOR - outdoorSwing * cosf(2.0f * static_cast<float>(M_PI) * phaseTime / DAY);
+
+        if (now == nextSetback) {
+            setpoint = SETBACK;
+            optimumStart.schedule(NIGHT / 60000.0f, now);
+            comfortTime = now + NIGHT;
+            nextSetback += DAY;
+        }
+
+        if (now % sampleTime == 0) {
+            switch (optimumStart.update(room, valve, outdoor, now)) {
+                case PreheatEvent::START:
+                    setpoint = optimumStart.getSetpoint();
+                    waiting = true;
+                    break;
+                case PreheatEvent::END:
+                    // PIDController::restartFrom() on the kernel
+                    pid.reset(room);
+                    pid.offsetIntegral(-optimumStart.getHoldingOutput(outdoor));
+                    if (run.mornings < DAYS) run.reported[run.mornings] = optimumStart.getLastLateness();
+                    break;
+                default:
+                    break;
+            }
+            valve = pid.compute(setpoint, room, 1.0f);
+            if (optimumStart.isPreheating()) {
+                valve = pidConfig.maxOutput;
+            }
+        }
+
+        room += (outdoor + HEATER_GAIN * valve / 100.0f - room) * (STEP / 1000.0f) / (roomTauHours * 3600.0f);
+
+        if (waiting && room >= COMFORT_SETPOINT - OptimumStart::END_BAND) {
+            waiting = false;
+            if (run.mornings < DAYS) {
+                run.arrival[run.mornings++] = static_cast<long>(now) - static_cast<long>(comfortTime);
+            }
+        }
+    }
+
+    run.gain = optimumStart.getEstimator().getGain();
+    run.loss = optimumStart.getEstimator().getLoss();
+    return run;
+}
+
+static void checkMornings(const Run& run, float roomTauHours) {
+    char message[128];
+    snprintf(message, sizeof(message), "gain %.2f K/h (true %.2f), loss %.3f 1/h (true %.3f)", run.gain,
+             HEATER_GAIN / roomTauHours, run.loss, 1.0f / roomTauHours);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_EQUAL_INT(DAYS, run.mornings);
+    for (int i = 0; i < run.mornings; i++) {
+        snprintf(message, sizeof(message), "morning %d: reached %ld min %s the comfort time (reported %ld min)",
+                 i + 1, labs(run.arrival[i]) / 60000, run.arrival[i] < 0 ? "before" : "after",
+                 run.reported[i] / 60000);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_INT_WITHIN(MAX_LATENESS, 0, run.arrival[i]);
+    }
+
+    TEST_ASSERT_FLOAT_WITHIN(MAX_MODEL_ERROR * HEATER_GAIN / roomTauHours, HEATER_GAIN / roomTauHours, run.gain);
+    TEST_ASSERT_FLOAT_WITHIN(MAX_MODEL_ERROR / roomTauHours, 1.0f / roomTauHours, run.loss);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_comfort_on_time_in_a_fast_room() {
+    checkMornings(simulate(1.0f, 0.0f), 1.0f);
+}
+
+void test_comfort_on_time_in_a_slow_room_with_outdoor_swing() {
+    checkMornings(simulate(4.0f, 4.0f), 4.0f);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_comfort_on_time_in_a_fast_room);
+    RUN_TEST(test_comfort_on_time_in_a_slow_room_with_outdoor_swing);
+    return UNITY_END();
+}
@@ -0,0 +1,130 @@
+// ProtocolManager::flushOutbound() fairness under a send budget.
+//
+// Datapoints that change on every flush must not keep others of the same
+// pending word from being sent: with a burst of B and N datapoints due,
+// each one goes out within ceil(N / B) flushes.
+
+#include <unity.h>
+#include <vector>
+#include "protocol_manager.h"
+
+struct Sent {
+    uint8_t zone;
+    CommandType type;
+};
+
+class RecordingProtocol : public ProtocolInterface {
+public:
+    std::vector<Sent> sent;
+
+    bool begin() override { return true; }
+    void loop() override {}
+    bool isConnected() const override { return true; }
+    void disconnect() override {}
+    bool reconnect() override { return true; }
+    bool configure(const JsonDocument&) override { return true; }
+    bool validateConfig() const override { return true; }
+    void getConfig(JsonDocument&) const override {}
+    bool sendTemperature(float) override { return record(0, CommandType::CMD_SET_TEMPERATURE); }
+    bool sendHumidity(float) override { return true; }
+    bool sendPressure(float) override { return true; }
+    bool sendSetpoint(float) override { return record(0, CommandType::CMD_SETPOINT); }
+    bool sendValvePosition(float) override { return record(0, CommandType::CMD_VALVE); }
+    bool sendMode(ThermostatMode) override { return record(0, CommandType::CMD_MODE); }
+    bool sendHeatingState(bool) override { return record(0, CommandType::CMD_HEATING); }
+    bool sendZoneValue(uint8_t zone, CommandType type, float) override { return record(zone, type); }
+    uint32_t getCapabilities() const override { return ProtocolInterface::getCapabilities() | PROTOCOL_CAP_ZONES; }
+    ThermostatStatus getLastError() const override { return ThermostatStatus::OK; }
+    const char* getLastErrorMessage() const override { return ""; }
+    void clearError() override {}
+    void registerCallbacks(ThermostatState*, ProtocolManager*) override {}
+    void unregisterCallbacks() override {}
+    const char* getProtocolName() const override { return "Recorder"; }
+    CommandSource getCommandSource() const override { return CommandSource::SOURCE_MQTT; }
+
+    size_t count(uint8_t zone, CommandType type) const {
+        size_t total = 0;
+        for (const Sent& entry : sent) {
+            if (entry.zone == zone && entry.type == type) total++;
+        }
+        return total;
+    }
+
+private:
+    bool record(uint8_t zone, CommandType type) {
+        sent.push_back({zone, type});
+        return true;
+    }
+};
+
+static void configureBurst(ProtocolManager& manager, uint8_t burst) {
+    OutboundConfig config = DEFAULT_OUTBOUND_CONFIG;
+    config.burst = burst;
+    manager.configureOutbound(config);
+}
+
+void setUp() {}
+void tearDown() {}
+
+// The device's setpoint, mode and valve share word 0 with zone 2's valve
+void test_high_bit_is_not_starved_by_busy_low_bits() {
+    ThermostatState state;
+    ProtocolManager manager(&state);
+    RecordingProtocol protocol;
+    manager.addProtocol(&protocol);
+    configureBurst(manager, 2);
+
+    manager.sendZoneValvePosition(2, 40.0f);
+    for (int flush = 0; flush < 4; flush++) {
+        manager.sendSetpoint(21.0f + flush);
+        manager.sendMode(ThermostatMode::COMFORT);
+        manager.sendValvePosition(10.0f + flush);
+        manager.flushOutbound();
+    }
+
+    TEST_ASSERT_EQUAL_size_t(1, protocol.count(2, CommandType::CMD_VALVE));
+    TEST_ASSERT_GREATER_THAN(0, protocol.count(0, CommandType::CMD_VALVE));
+}
+
+// Twenty datapoints across four words, all changing on every flush
+void test_every_busy_datapoint_waits_at_most_its_share() {
+    ThermostatState state;
+    ProtocolManager manager(&state);
+    RecordingProtocol protocol;
+    manager.addProtocol(&protocol);
+    const uint8_t BURST = 4;
+    const uint8_t ZONES = 10;
+    const size_t DUE = ZONES * 2;
+    const size_t ROUNDS = (DUE + BURST - 1) / BURST;
+    configureBurst(manager, BURST);
+
+    size_t lastSent[ZONES + 1][COMMAND_TYPE_COUNT] = {};
+    size_t longestWait = 0;
+    for (size_t flush = 1; flush <= 50; flush++) {
+        for (uint8_t zone = 1; zone <= ZONES; zone++) {
+            manager.sendZoneSetpoint(zone, 20.0f + flush);
+            manager.sendZoneValvePosition(zone, static_cast<float>(flush));
+        }
+        protocol.sent.clear();
+        manager.flushOutbound();
+        TEST_ASSERT_EQUAL_size_t(BURST, protocol.sent.size());
+        for (const Sent& entry : protocol.sent) {
+            lastSent[entry.zone][static_cast<uint8_t>(entry.type)] = flush;
+        }
+        for (uint8_t zone = 1; zone <= ZONES; zone++) {
+            size_t setpointWait = flush - lastSent[zone][static_cast<uint8_t>(CommandType::CMD_SETPOINT)];
+            size_t valveWait = flush - lastSent[zone][static_cast<uint8_t>(CommandType::CMD_VALVE)];
+            longestWait = setpointWait > longestWait ? setpointWait : longestWait;
+            longestWait = valveWait > longestWait ? valveWait : longestWait;
+        }
+    }
+
+    TEST_ASSERT_LESS_THAN(ROUNDS, longestWait);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_high_bit_is_not_starved_by_busy_low_bits);
+    RUN_TEST(test_every_busy_datapoint_waits_at_most_its_share);
+    return UNITY_END();
+}
@@ -0,0 +1,150 @@
+// PidAutotuner relay test against a plant with known ultimate gain and period.
+//
+// The plant is three equal first-order lags, the heating circuit, the room
+// and the sensor in one. With gain K and time constant T its phase reaches
+// -180 degrees at w = sqrt(3) / T, where each lag has half its gain, so
+// Ku = 8 / K and Tu = 2 pi T / sqrt(3). The describing function ignores
+// the harmonics of the relay's square wave, which on this plant puts Ku
+// about 10 % low and Tu about 6 % high.
+//
+// A reader on another thread polls getStatus() while tests are started
+// and finished; a DONE status must always carry the gains of its Ku/Tu.
+
+#include <unity.h>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include "control/pid_autotuner.h"
+
+static const float PLANT_GAIN = 0.2f;         // K per % of output
+static const float PLANT_TAU = 600000.0f;     // ms per lag
+static const float AMBIENT = 11.0f;           // Holds 21 C at 50 %
+static const float SETPOINT = 21.0f;
+static const unsigned long SAMPLE = 10000;    // ms
+static const float SAMPLE_TIME = 30000.0f;    // Nominal PID sample time in ms
+
+static const float EXPECTED_KU = 8.0f / PLANT_GAIN;
+static const float EXPECTED_TU = 2.0f * static_cast<float>(M_PI) * PLANT_TAU / sqrtf(3.0f);
+static const float KU_TOLERANCE = 0.15f;      // Relative
+static const float TU_TOLERANCE = 0.08f;
+
+struct Plant {
+    float lags[3];
+
+    Plant() : lags{SETPOINT, SETPOINT, SETPOINT} {}
+
+    // Advances by dt ms with the output held, in substeps well below the lag
+    float step(float output, float dt) {
+        const int SUBSTEPS = 10;
+        float h = dt / SUBSTEPS / PLANT_TAU;
+        for (int s = 0; s < SUBSTEPS; s++) {
+            lags[0] += (AMBIENT + PLANT_GAIN * output - lags[0]) * h;
+            lags[1] += (lags[0] - lags[1]) * h;
+            lags[2] += (lags[1] - lags[2]) * h;
+        }
+        return lags[2];
+    }
+};
+
+// Runs a relay test to its end, returns the final state
+static AutotuneState runRelayTest(PidAutotuner& tuner, AutotuneRule rule) {
+    Plant plant;
+    unsigned long now = SAMPLE;
+    float input = SETPOINT;
+    tuner.start(SETPOINT, 50.0f, 50.0f, 0.1f, rule, now);
+    while (tuner.getState() == AutotuneState::RUNNING) {
+        float output = tuner.update(input, now);
+        input = plant.step(output, SAMPLE);
+        now += SAMPLE;
+    }
+    if (tuner.getState() == AutotuneState::DONE) {
+        tuner.computeGains(SAMPLE_TIME);
+    }
+    return tuner.getState();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_relay_test_finds_ultimate_gain_and_period() {
+    PidAutotuner tuner;
+    TEST_ASSERT_EQUAL(AutotuneState::DONE, runRelayTest(tuner, AutotuneRule::ZIEGLER_NICHOLS));
+
+    const AutotuneResult& result = tuner.getResult();
+    char message[96];
+    snprintf(message, sizeof(message), "Ku=%.2f (expected %.2f) Tu=%.0fs (expected %.0fs) after %u cycles",
+             result.ultimateGain, EXPECTED_KU, result.ultimatePeriod / 1000.0f, EXPECTED_TU / 1000.0f,
+             tuner.getCycles());
+    TEST_MESSAGE(message);
+    TEST_ASSERT_FLOAT_WITHIN(KU_TOLERANCE * EXPECTED_KU, EXPECTED_KU, result.ultimateGain);
+    TEST_ASSERT_FLOAT_WITHIN(TU_TOLERANCE * EXPECTED_TU, EXPECTED_TU, result.ultimatePeriod);
+}
+
+void test_rules_scale_gains_from_ku_tu() {
+    struct Case {
+        AutotuneRule rule;
+        float kpFactor;
+        float tiFactor;
+        float tdFactor;
+    };
+    const Case cases[] = {
+        {AutotuneRule::ZIEGLER_NICHOLS, 0.6f, 0.5f, 0.125f},
+        {AutotuneRule::TYREUS_LUYBEN, 1.0f / 2.2f, 2.2f, 1.0f / 6.3f},
+        {AutotuneRule::NO_OVERSHOOT, 0.2f, 0.5f, 1.0f / 3.0f},
+    };
+    for (const Case& c : cases) {
+        PidAutotuner tuner;
+        TEST_ASSERT_EQUAL(AutotuneState::DONE, runRelayTest(tuner, c.rule));
+
+        // Against the plant's true Ku/Tu, so the gains are sane and not just self-consistent
+        float kp = c.kpFactor * EXPECTED_KU;
+        float ki = kp * SAMPLE_TIME / (c.tiFactor * EXPECTED_TU);
+        float kd = kp * c.tdFactor * EXPECTED_TU / SAMPLE_TIME;
+        const AutotuneResult& result = tuner.getResult();
+        TEST_ASSERT_FLOAT_WITHIN(KU_TOLERANCE * kp, kp, result.kp);
+        TEST_ASSERT_FLOAT_WITHIN((KU_TOLERANCE + TU_TOLERANCE) * ki, ki, result.ki);
+        TEST_ASSERT_FLOAT_WITHIN((KU_TOLERANCE + TU_TOLERANCE) * kd, kd, result.kd);
+    }
+}
+
+void test_status_is_published_with_gains() {
+    PidAutotuner tuner;
+    TEST_ASSERT_EQUAL(AutotuneState::IDLE, tuner.getStatus().state);
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> done(0), torn(0);
+    std::thread reader([&]() {
+        while (!stop.load()) {
+            AutotuneStatus status = tuner.getStatus();
+            if (status.state != AutotuneState::DONE) continue;
+            done++;
+            const AutotuneResult& result = status.result;
+            float ti = 0.5f * result.ultimatePeriod;
+            if (result.kp != 0.6f * result.ultimateGain || result.ki != result.kp * SAMPLE_TIME / ti) torn++;
+        }
+    });
+
+    for (int run = 0; run < 200; run++) {
+        runRelayTest(tuner, AutotuneRule::ZIEGLER_NICHOLS);
+        tuner.cancel();
+    }
+    // Leave the last one done, so the reader sees it at least once
+    runRelayTest(tuner, AutotuneRule::ZIEGLER_NICHOLS);
+    while (done.load() == 0) std::this_thread::yield();
+    stop = true;
+    reader.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+    AutotuneStatus status = tuner.getStatus();
+    TEST_ASSERT_EQUAL(AutotuneState::DONE, status.state);
+    TEST_ASSERT_EQUAL_FLOAT(tuner.getResult().kp, status.result.kp);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_relay_test_finds_ultimate_gain_and_period);
+    RUN_TEST(test_rules_scale_gains_from_ku_tu);
+    RUN_TEST(test_status_is_published_with_gains);
+    return UNITY_END();
+}
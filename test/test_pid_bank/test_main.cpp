@@ -0,0 +1,179 @@
+// PidBank against one PidKernel per zone on the same inputs.
+//
+// Every zone gets its own gains and temperature trace; the bank steps all
+// zones in one call, the kernels one by one. Gain changes, resets and
+// integral offsets are applied to both mid-run. Q16 outputs must match
+// bit for bit, float outputs to rounding (the compiler may contract the
+// two loops differently).
+
+#include <unity.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "pid_bank.h"
+
+static const size_t ZONES = 8;
+static const int STEPS = 5000;
+static const float FLOAT_TOLERANCE = 1e-3f;  // Valve %
+
+static float setpointFor(size_t zone, int step) {
+    return ((step / 700) + zone) % 2 ? 21.5f : 18.0f + 0.25f * zone;
+}
+
+static float inputFor(size_t zone, int step) {
+    return 19.0f + 2.0f * sinf(step * (0.002f + 0.0005f * zone)) + 0.05f * sinf(step * 0.37f + zone);
+}
+
+static float dtFor(int step) {
+    return 0.8f + 0.4f * static_cast<float>(step % 5) / 4.0f;
+}
+
+struct Mismatch {
+    float maxDifference;
+    int exactMismatches;
+    int saturated;
+};
+
+template <typename Math>
+static Mismatch compare() {
+    typedef typename Math::Value Value;
+    PidBank<Math, ZONES> bank;
+    PidKernel<Math> kernels[ZONES];
+
+    bank.setDerivativeFilter(2.0f);
+    bank.setOutputLimits(0.0f, 100.0f);
+    for (size_t z = 0; z < ZONES; z++) {
+        float kp = 1.0f + 0.5f * z;
+        float ki = 0.1f + 0.05f * z;
+        float kd = 0.5f * (z % 3);
+        bank.setGains(z, kp, ki, kd);
+        bank.reset(z, Math::fromFloat(inputFor(z, 0)));
+        kernels[z].setDerivativeFilter(2.0f);
+        kernels[z].setOutputLimits(0.0f, 100.0f);
+        kernels[z].setGains(kp, ki, kd);
+        kernels[z].reset(Math::fromFloat(inputFor(z, 0)));
+    }
+
+    Mismatch result = {0.0f, 0, 0};
+    Value setpoints[ZONES], inputs[ZONES], outputs[ZONES];
+    for (int step = 0; step < STEPS; step++) {
+        if (step == 1500) {
+            // Bumpless gain change on every other zone
+            for (size_t z = 0; z < ZONES; z += 2) {
+                bank.setGains(z, 3.0f, 0.2f, 1.0f);
+                kernels[z].setGains(3.0f, 0.2f, 1.0f);
+            }
+        }
+        if (step == 2500) {
+            bank.reset(3, Math::fromFloat(inputFor(3, step)));
+            kernels[3].reset(Math::fromFloat(inputFor(3, step)));
+            bank.offsetIntegral(5, Math::fromFloat(-15.0f));
+            kernels[5].offsetIntegral(Math::fromFloat(-15.0f));
+        }
+        if (step == 3500) {
+            bank.setOutputLimits(10.0f, 60.0f);
+            for (size_t z = 0; z < ZONES; z++) kernels[z].setOutputLimits(10.0f, 60.0f);
+        }
+
+        Value dt = Math::fromFloat(dtFor(step));
+        for (size_t z = 0; z < ZONES; z++) {
+            setpoints[z] = Math::fromFloat(setpointFor(z, step));
+            inputs[z] = Math::fromFloat(inputFor(z, step));
+        }
+        bank.compute(setpoints, inputs, dt, outputs, ZONES);
+
+        for (size_t z = 0; z < ZONES; z++) {
+            Value expected = kernels[z].compute(setpoints[z], inputs[z], dt);
+            if (expected != outputs[z]) result.exactMismatches++;
+            float difference = fabsf(Math::toFloat(expected) - Math::toFloat(outputs[z]));
+            result.maxDifference = fmaxf(result.maxDifference, difference);
+            float output = Math::toFloat(expected);
+            if (output == 0.0f || output == 100.0f || output == 10.0f || output == 60.0f) result.saturated++;
+        }
+    }
+    return result;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_q16_bank_matches_kernels_exactly() {
+    Mismatch result = compare<Q16Math>();
+    TEST_ASSERT_TRUE_MESSAGE(result.saturated > 0, "trace should drive outputs into their limits");
+    TEST_ASSERT_EQUAL_INT(0, result.exactMismatches);
+}
+
+void test_float_bank_matches_kernels() {
+    Mismatch result = compare<FloatMath>();
+    char message[96];
+    snprintf(message, sizeof(message), "max |bank - kernel| = %g %%, %d of %d steps not bit-identical",
+             result.maxDifference, result.exactMismatches, STEPS * static_cast<int>(ZONES));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(result.maxDifference <= FLOAT_TOLERANCE);
+}
+
+// Not a pass/fail check; reports the cost per zone of one batched pass
+// against stepping every zone's kernel on its own
+template <typename Math>
+static void benchmark(const char* name) {
+    typedef typename Math::Value Value;
+    const int ROUNDS = 200;
+    PidBank<Math, ZONES> bank;
+    PidKernel<Math> kernels[ZONES];
+    bank.setDerivativeFilter(2.0f);
+    for (size_t z = 0; z < ZONES; z++) {
+        bank.setGains(z, 2.0f, 0.5f, 1.0f);
+        kernels[z].setDerivativeFilter(2.0f);
+        kernels[z].setGains(2.0f, 0.5f, 1.0f);
+    }
+
+    std::vector<Value> inputs(STEPS * ZONES);
+    for (int step = 0; step < STEPS; step++) {
+        for (size_t z = 0; z < ZONES; z++) inputs[step * ZONES + z] = Math::fromFloat(inputFor(z, step));
+    }
+    Value setpoints[ZONES], outputs[ZONES];
+    for (size_t z = 0; z < ZONES; z++) setpoints[z] = Math::fromFloat(21.0f);
+    Value dt = Math::fromFloat(1.0f);
+    volatile Value sink = Value();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int step = 0; step < STEPS; step++) {
+            bank.compute(setpoints, &inputs[step * ZONES], dt, outputs, ZONES);
+            sink = outputs[step % ZONES];
+        }
+    }
+    auto batched = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int step = 0; step < STEPS; step++) {
+            const Value* stepInputs = &inputs[step * ZONES];
+            for (size_t z = 0; z < ZONES; z++) outputs[z] = kernels[z].compute(setpoints[z], stepInputs[z], dt);
+            sink = outputs[step % ZONES];
+        }
+    }
+    auto perZone = std::chrono::steady_clock::now() - start;
+    (void)sink;
+
+    double steps = static_cast<double>(ROUNDS) * STEPS * ZONES;
+    char message[96];
+    snprintf(message, sizeof(message), "%s: batched %.1f ns/zone, per zone %.1f ns/zone", name,
+             std::chrono::duration<double, std::nano>(batched).count() / steps,
+             std::chrono::duration<double, std::nano>(perZone).count() / steps);
+    TEST_MESSAGE(message);
+}
+
+void test_benchmark() {
+    benchmark<FloatMath>("float");
+    benchmark<Q16Math>("q16");
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_q16_bank_matches_kernels_exactly);
+    RUN_TEST(test_float_bank_matches_kernels);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
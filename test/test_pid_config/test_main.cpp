@@ -0,0 +1,158 @@
+// PIDController configuration changes from other tasks.
+//
+// Two writers call configure() with configurations whose fields all carry
+// the same value, while the control thread keeps computing and a reader
+// polls getConfig(). A copy with mixed fields is a torn read.
+//
+// A configuration taken over while the controller holds an output must
+// not step it, with or without a feed-forward.
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "thermostat_state.h"
+#include "control/pid_controller.h"
+
+static const int WRITES = 100000;
+static const int WRITERS = 2;
+static const float STEP_TOLERANCE = 0.5f;  // Valve %
+
+static PIDConfig configFor(int value) {
+    float v = static_cast<float>(value);
+    PIDConfig config = {v, v, v, 0.0f, 100.0f + v, 1000.0f + v};
+    return config;
+}
+
+static bool isConsistent(const PIDConfig& config) {
+    return config.ki == config.kp && config.kd == config.kp && config.minOutput == 0.0f &&
+           config.maxOutput == 100.0f + config.kp && config.sampleTime == 1000.0f + config.kp;
+}
+
+static void writeConfigs(PIDController* controller, int first) {
+    for (int i = 0; i < WRITES; i++) {
+        PIDConfig config = configFor(first + i);
+        controller->configure(&config);
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_configure_is_taken_over_on_next_pass() {
+    ThermostatState state;
+    state.setEnabled(true);
+    PIDController controller(&state);
+    controller.begin();
+    controller.setSetpoint(25.0f);
+    controller.setActive(true);
+    controller.update(20.0f);
+    TEST_ASSERT_GREATER_THAN_FLOAT(10.0f, controller.getOutput());
+
+    controller.setOutputLimits(0.0f, 10.0f);
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, controller.getMaxOutput());
+    TEST_ASSERT_GREATER_THAN_FLOAT(10.0f, controller.getOutput());
+
+    controller.update(20.0f);
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, controller.getOutput());
+}
+
+// Two degrees below the setpoint, so the proportional term is large
+void test_gain_change_under_load_is_bumpless() {
+    ThermostatState state;
+    state.setEnabled(true);
+    PIDController controller(&state);
+    controller.begin();
+    controller.setSetpoint(21.0f);
+    controller.setActive(true);
+    for (int i = 0; i < 5; i++) controller.update(19.0f);
+    float before = controller.getOutput();
+    TEST_ASSERT_TRUE(before > 0.0f && before < 100.0f);
+
+    PIDConfig config = controller.getConfig();
+    config.kp *= 3.0f;  // Without the handover the output would jump by 8 %
+    config.kd *= 2.0f;
+    controller.configure(&config);
+    controller.update(19.0f);
+    TEST_ASSERT_FLOAT_WITHIN(STEP_TOLERANCE, before, controller.getOutput());
+}
+
+// A curve asking for 64 % where 40 % holds the room leaves a negative integral
+void test_reconfigure_with_feed_forward_above_demand_is_bumpless() {
+    ThermostatState state;
+    state.setEnabled(true);
+    PIDController controller(&state);
+    controller.begin();
+    controller.setHeatingCurve({4.0f, 0.0f});
+    controller.setOutdoorTemperature(5.0f);
+    controller.setSetpoint(21.0f);
+    controller.setActive(true);
+    controller.update(21.0f);
+    controller.restartFrom(40.0f);
+    controller.update(21.0f);
+    TEST_ASSERT_EQUAL_FLOAT(64.0f, controller.getFeedForward());
+    TEST_ASSERT_FLOAT_WITHIN(STEP_TOLERANCE, 40.0f, controller.getOutput());
+
+    PIDConfig config = controller.getConfig();
+    config.kp = 4.0f;
+    controller.configure(&config);
+    controller.update(21.0f);
+    TEST_ASSERT_FLOAT_WITHIN(STEP_TOLERANCE, 40.0f, controller.getOutput());
+
+    controller.setOutputLimits(5.0f, 90.0f);
+    controller.update(21.0f);
+    TEST_ASSERT_FLOAT_WITHIN(STEP_TOLERANCE, 40.0f, controller.getOutput());
+}
+
+void test_concurrent_configure_is_never_torn() {
+    ThermostatState state;
+    state.setEnabled(true);
+    PIDController controller(&state);
+    controller.begin();
+    controller.setSetpoint(21.0f);
+    controller.setActive(true);
+    PIDConfig initial = configFor(0);
+    controller.configure(&initial);
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> reads(0), torn(0), passes(0);
+    std::thread reader([&]() {
+        while (!stop.load()) {
+            if (!isConsistent(controller.getConfig())) torn++;
+            reads++;
+        }
+    });
+    std::thread control([&]() {
+        while (!stop.load()) {
+            controller.update(20.0f);
+            passes++;
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int w = 0; w < WRITERS; w++) {
+        writers.emplace_back(writeConfigs, &controller, 1 + w * WRITES);
+    }
+    for (auto& writer : writers) writer.join();
+    stop = true;
+    reader.join();
+    control.join();
+
+    TEST_ASSERT_GREATER_THAN_UINT32(0, reads.load());
+    TEST_ASSERT_GREATER_THAN_UINT32(0, passes.load());
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+
+    // The last write of either writer wins
+    PIDConfig last = controller.getConfig();
+    TEST_ASSERT_TRUE(isConsistent(last));
+    TEST_ASSERT_TRUE(last.kp == WRITES || last.kp == WRITERS * WRITES);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_configure_is_taken_over_on_next_pass);
+    RUN_TEST(test_gain_change_under_load_is_bumpless);
+    RUN_TEST(test_reconfigure_with_feed_forward_above_demand_is_bumpless);
+    RUN_TEST(test_concurrent_configure_is_never_torn);
+    return UNITY_END();
+}
@@ -0,0 +1,277 @@
+// PidKernel<Q16Math> against PidKernel<FloatMath> on the same trace.
+//
+// The trace is a room temperature following setpoint steps with a small
+// oscillation on top, sampled with jittered intervals. Both kernels see
+// the same inputs; the Q16 output may differ from the float output by at
+// most OUTPUT_TOLERANCE valve percentage points at any step.
+//
+// On a first-order room model, gain and limit changes and the handover to
+// a feed-forward must not step the output, and the feed-forward must
+// shorten the recovery from an outdoor temperature step.
+
+#include <unity.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "pid_kernel.h"
+#include "heating_curve.h"
+
+static const int STEPS = 20000;
+static const float OUTPUT_TOLERANCE = 0.05f;  // Valve %, about 3300 Q16 LSBs
+
+struct TraceStep {
+    float setpoint;
+    float input;
+    float dt;
+    float feedForward;
+};
+
+static std::vector<TraceStep> makeTrace() {
+    std::vector<TraceStep> trace;
+    float room = 17.0f;
+    for (int i = 0; i < STEPS; i++) {
+        TraceStep step;
+        step.setpoint = (i / 2000) % 2 ? 21.5f : 19.0f;
+        room += 0.02f * (step.setpoint - room) + 0.05f * sinf(i * 0.37f);
+        step.input = room;
+        step.dt = 0.8f + 0.4f * static_cast<float>(i % 7) / 6.0f;
+        step.feedForward = (i / 5000) % 2 ? 10.0f : 0.0f;
+        trace.push_back(step);
+    }
+    return trace;
+}
+
+template <typename Math>
+static void configure(PidKernel<Math>& kernel, float firstInput) {
+    kernel.setGains(2.0f, 0.5f, 1.0f);
+    kernel.setDerivativeFilter(2.0f);
+    kernel.setOutputLimits(0.0f, 100.0f);
+    kernel.reset(Math::fromFloat(firstInput));
+}
+
+template <typename Math>
+static std::vector<float> run(const std::vector<TraceStep>& trace) {
+    PidKernel<Math> kernel;
+    configure(kernel, trace[0].input);
+    std::vector<float> outputs;
+    for (const TraceStep& step : trace) {
+        outputs.push_back(Math::toFloat(kernel.compute(Math::fromFloat(step.setpoint), Math::fromFloat(step.input),
+                                                       Math::fromFloat(step.dt), Math::fromFloat(step.feedForward))));
+    }
+    return outputs;
+}
+
+// Room per nominal sample: approaches outdoor + ROOM_GAIN * output / 100
+static const float ROOM_GAIN = 40.0f;
+static const float ROOM_TAU = 60.0f;      // Samples
+static const float STEP_TOLERANCE = 0.5f; // Valve %, far below the jumps a clamp or gain change would cause
+
+template <typename Math>
+struct Room {
+    PidKernel<Math> kernel;
+    HeatingCurve curve;
+    float temperature;
+    float outdoor;
+    float setpoint;
+    float output;
+
+    Room() : curve({0.0f, 0.0f}), temperature(21.0f), outdoor(5.0f), setpoint(21.0f), output(0.0f) {
+        kernel.setGains(8.0f, 0.4f, 0.0f);
+        kernel.setOutputLimits(0.0f, 100.0f);
+        kernel.reset(Math::fromFloat(temperature));
+    }
+
+    // Switches the curve on the way PIDController does, handing its share out of the integral
+    void enableCurve(float slope) {
+        curve = {slope, 0.0f};
+        kernel.offsetIntegral(Math::fromFloat(curve.baseOutput(setpoint, outdoor)));
+    }
+
+    float step() {
+        float feedForward = curve.baseOutput(setpoint, outdoor);
+        output = Math::toFloat(kernel.compute(Math::fromFloat(setpoint), Math::fromFloat(temperature),
+                                              Math::fromFloat(1.0f), Math::fromFloat(feedForward)));
+        temperature += (outdoor + ROOM_GAIN * output / 100.0f - temperature) / ROOM_TAU;
+        return output;
+    }
+
+    void settle() {
+        for (int i = 0; i < 5000; i++) step();
+    }
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_div_truncates_negative_operands() {
+    typedef Q16Math Q;
+    TEST_ASSERT_EQUAL_INT32(Q::fromFloat(-3.0f), Q::div(Q::fromFloat(-1.5f), Q::fromFloat(0.5f)));
+    TEST_ASSERT_EQUAL_INT32(Q::fromFloat(-3.0f), Q::div(Q::fromFloat(1.5f), Q::fromFloat(-0.5f)));
+    TEST_ASSERT_EQUAL_INT32(Q::fromFloat(3.0f), Q::div(Q::fromFloat(-1.5f), Q::fromFloat(-0.5f)));
+    TEST_ASSERT_EQUAL_INT32(-21845, Q::div(-Q::ONE, 3 * Q::ONE));  // -1/3, toward zero
+    TEST_ASSERT_EQUAL_INT32(-1, Q::div(-1, Q::ONE));
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, Q::div(Q::fromFloat(-20000.0f), Q::fromFloat(0.25f)));
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, Q::div(-1, 0));
+    TEST_ASSERT_EQUAL_INT32(INT32_MAX, Q::div(0, 0));
+}
+
+void test_q16_matches_float_within_tolerance() {
+    std::vector<TraceStep> trace = makeTrace();
+    std::vector<float> expected = run<FloatMath>(trace);
+    std::vector<float> actual = run<Q16Math>(trace);
+
+    float maxDifference = 0.0f;
+    int saturated = 0;
+    for (size_t i = 0; i < trace.size(); i++) {
+        maxDifference = fmaxf(maxDifference, fabsf(expected[i] - actual[i]));
+        if (expected[i] == 0.0f || expected[i] == 100.0f) saturated++;
+    }
+
+    char message[96];
+    snprintf(message, sizeof(message), "max |q16 - float| = %.5f %% over %d steps, %d saturated",
+             maxDifference, STEPS, saturated);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE_MESSAGE(saturated > 0, "trace should drive the output into its limits");
+    TEST_ASSERT_TRUE(maxDifference <= OUTPUT_TOLERANCE);
+}
+
+void test_q16_is_deterministic() {
+    std::vector<TraceStep> trace = makeTrace();
+    std::vector<float> first = run<Q16Math>(trace);
+    std::vector<float> second = run<Q16Math>(trace);
+    TEST_ASSERT_EQUAL_MEMORY(first.data(), second.data(), first.size() * sizeof(float));
+}
+
+// Not a pass/fail check; reports the cost of one compute() per math type
+template <typename Math>
+static double nanosecondsPerStep(const std::vector<TraceStep>& trace) {
+    std::vector<typename Math::Value> setpoints, inputs, dts;
+    for (const TraceStep& step : trace) {
+        setpoints.push_back(Math::fromFloat(step.setpoint));
+        inputs.push_back(Math::fromFloat(step.input));
+        dts.push_back(Math::fromFloat(step.dt));
+    }
+
+    const int ROUNDS = 50;
+    PidKernel<Math> kernel;
+    volatile typename Math::Value sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        configure(kernel, trace[0].input);
+        for (size_t i = 0; i < trace.size(); i++) sink = kernel.compute(setpoints[i], inputs[i], dts[i]);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (ROUNDS * trace.size());
+}
+
+void test_benchmark() {
+    std::vector<TraceStep> trace = makeTrace();
+    char message[64];
+    snprintf(message, sizeof(message), "float %.1f ns/step, q16 %.1f ns/step",
+             nanosecondsPerStep<FloatMath>(trace), nanosecondsPerStep<Q16Math>(trace));
+    TEST_MESSAGE(message);
+}
+
+// A curve steeper than the room needs leaves a negative integral
+template <typename Math>
+static void checkFeedForwardAboveDemandKeptOnChange(bool changeGains) {
+    Room<Math> room;
+    room.enableCurve(4.0f);
+    room.settle();
+    float before = room.output;
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 40.0f, before);
+    TEST_ASSERT_LESS_THAN_FLOAT(-20.0f, Math::toFloat(room.kernel.getIntegral()));
+
+    if (changeGains) {
+        room.kernel.setGains(4.0f, 0.2f, 0.0f);
+    } else {
+        room.kernel.setOutputLimits(5.0f, 90.0f);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(STEP_TOLERANCE, before, room.step());
+}
+
+void test_gain_change_with_feed_forward_above_demand_does_not_step() {
+    checkFeedForwardAboveDemandKeptOnChange<FloatMath>(true);
+    checkFeedForwardAboveDemandKeptOnChange<Q16Math>(true);
+}
+
+void test_limit_change_with_feed_forward_above_demand_does_not_step() {
+    checkFeedForwardAboveDemandKeptOnChange<FloatMath>(false);
+    checkFeedForwardAboveDemandKeptOnChange<Q16Math>(false);
+}
+
+// Gains changed halfway through a setpoint step, with a large error
+template <typename Math>
+static void checkGainChangeUnderLoad() {
+    Room<Math> room;
+    room.settle();
+    room.setpoint = 23.0f;
+    float previous = 0.0f;
+    for (int i = 0; i < 3; i++) previous = room.step();
+    float error = room.setpoint - room.temperature;
+    TEST_ASSERT_GREATER_THAN_FLOAT(1.0f, error);
+
+    float trend = previous - room.output;
+    room.kernel.setGains(16.0f, 0.8f, 0.0f);  // Without the handover the output would jump by 8 * error
+    float output = room.output;
+    TEST_ASSERT_FLOAT_WITHIN(STEP_TOLERANCE + fabsf(trend), output, room.step());
+    TEST_ASSERT_TRUE(output < 100.0f);
+}
+
+void test_gain_change_under_load_is_bumpless() {
+    checkGainChangeUnderLoad<FloatMath>();
+    checkGainChangeUnderLoad<Q16Math>();
+}
+
+template <typename Math>
+static void checkFeedForwardHandover() {
+    Room<Math> room;
+    room.settle();
+    float before = room.output;
+    room.enableCurve(2.0f);
+    TEST_ASSERT_FLOAT_WITHIN(STEP_TOLERANCE, before, room.step());
+}
+
+void test_feed_forward_handover_does_not_step() {
+    checkFeedForwardHandover<FloatMath>();
+    checkFeedForwardHandover<Q16Math>();
+}
+
+// Largest deviation from the setpoint after the outdoor temperature drops by 10 K
+static float outdoorStepDeviation(float slope) {
+    Room<FloatMath> room;
+    if (slope > 0.0f) room.enableCurve(slope);
+    room.settle();
+    room.outdoor -= 10.0f;
+    float deviation = 0.0f;
+    for (int i = 0; i < 2000; i++) {
+        room.step();
+        deviation = fmaxf(deviation, fabsf(room.setpoint - room.temperature));
+    }
+    return deviation;
+}
+
+void test_feed_forward_shrinks_outdoor_step_deviation() {
+    float without = outdoorStepDeviation(0.0f);
+    float with = outdoorStepDeviation(0.8f * 100.0f / ROOM_GAIN);  // A curve 20 % below what the room needs
+    char message[80];
+    snprintf(message, sizeof(message), "max deviation after -10 K outdoor: %.2f K without, %.2f K with", without, with);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.5f * without, with);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_div_truncates_negative_operands);
+    RUN_TEST(test_q16_matches_float_within_tolerance);
+    RUN_TEST(test_q16_is_deterministic);
+    RUN_TEST(test_gain_change_with_feed_forward_above_demand_does_not_step);
+    RUN_TEST(test_limit_change_with_feed_forward_above_demand_does_not_step);
+    RUN_TEST(test_gain_change_under_load_is_bumpless);
+    RUN_TEST(test_feed_forward_handover_does_not_step);
+    RUN_TEST(test_feed_forward_shrinks_outdoor_step_deviation);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,129 @@
+// Concurrent readers of ThermostatState::snapshot() against the writer.
+//
+// The writer keeps the fields in a fixed relation to each other, so a
+// snapshot that mixes values from two updates breaks the relation.
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "thermostat_state.h"
+
+static const int UPDATES = 200000;
+static const int READERS = 3;
+
+struct ReaderResult {
+    uint32_t reads;
+    uint32_t torn;
+    uint32_t backwards;  // Version older than the previous snapshot's
+};
+
+static float valueFor(int i) {
+    return 15.0f + static_cast<float>(i % 10);
+}
+
+// Fields of one batched update
+static bool matchesBatch(const ThermostatSnapshot& copy) {
+    float v = copy.currentTemperature;
+    return copy.targetTemperature == v && copy.currentHumidity == v + 20.0f && copy.valvePosition == v * 2.0f;
+}
+
+static void readBatches(const ThermostatState* state, const std::atomic<bool>* stop, ReaderResult* result) {
+    uint32_t lastVersion = 0;
+    while (!stop->load()) {
+        ThermostatSnapshot copy = state->snapshot();
+        result->reads++;
+        if (copy.version < lastVersion) result->backwards++;
+        lastVersion = copy.version;
+        if (copy.version > 1 && !matchesBatch(copy)) result->torn++;
+    }
+}
+
+// Two copies taken at the same version must be identical
+static void readPairs(const ThermostatState* state, const std::atomic<bool>* stop, ReaderResult* result) {
+    while (!stop->load()) {
+        ThermostatSnapshot first = state->snapshot();
+        ThermostatSnapshot second = state->snapshot();
+        result->reads += 2;
+        if (second.version < first.version) result->backwards++;
+        if (second.version == first.version &&
+            (first.currentTemperature != second.currentTemperature ||
+             first.targetTemperature != second.targetTemperature ||
+             first.currentHumidity != second.currentHumidity || first.valvePosition != second.valvePosition)) {
+            result->torn++;
+        }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_batched_update_is_never_torn() {
+    ThermostatState state;
+    state.beginUpdate();
+    state.setCurrentTemperature(valueFor(0));
+    state.setCurrentHumidity(valueFor(0) + 20.0f);
+    state.setTargetTemperature(valueFor(0));
+    state.setValvePosition(valueFor(0) * 2.0f);
+    state.endUpdate();
+
+    std::atomic<bool> stop(false);
+    ReaderResult results[READERS] = {};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back(readBatches, &state, &stop, &results[r]);
+    }
+
+    for (int i = 1; i < UPDATES; i++) {
+        float v = valueFor(i);
+        state.beginUpdate();
+        state.setCurrentTemperature(v);
+        state.setCurrentHumidity(v + 20.0f);
+        state.setTargetTemperature(v);
+        state.setValvePosition(v * 2.0f);
+        state.endUpdate();
+    }
+    stop = true;
+    for (auto& reader : readers) reader.join();
+
+    for (int r = 0; r < READERS; r++) {
+        TEST_ASSERT_GREATER_THAN_UINT32(0, results[r].reads);
+        TEST_ASSERT_EQUAL_UINT32(0, results[r].torn);
+        TEST_ASSERT_EQUAL_UINT32(0, results[r].backwards);
+    }
+}
+
+void test_single_field_writes_are_never_torn() {
+    ThermostatState state;
+    std::atomic<bool> stop(false);
+    ReaderResult results[READERS] = {};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back(readPairs, &state, &stop, &results[r]);
+    }
+
+    // Each setter is its own write, readers may see any mix of them, but
+    // never a change without a new version
+    for (int i = 0; i < UPDATES; i++) {
+        float v = valueFor(i);
+        state.setCurrentTemperature(v);
+        state.setCurrentHumidity(v + 20.0f);
+        state.setTargetTemperature(v);
+        state.setValvePosition(v * 2.0f);
+    }
+    stop = true;
+    for (auto& reader : readers) reader.join();
+
+    for (int r = 0; r < READERS; r++) {
+        TEST_ASSERT_GREATER_THAN_UINT32(0, results[r].reads);
+        TEST_ASSERT_EQUAL_UINT32(0, results[r].torn);
+        TEST_ASSERT_EQUAL_UINT32(0, results[r].backwards);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_batched_update_is_never_torn);
+    RUN_TEST(test_single_field_writes_are_never_torn);
+    return UNITY_END();
+}
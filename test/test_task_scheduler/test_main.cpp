@@ -0,0 +1,164 @@
+// TaskScheduler driven by a fake clock.
+//
+// Time only moves when the test sets it or a task's callback advances it
+// to stand for its own execution time, so deadlines, lateness and
+// durations are exact.
+
+#include <unity.h>
+#include <climits>
+#include <vector>
+#include "system/task_scheduler.h"
+
+static unsigned long fakeNow = 0;
+
+static unsigned long fakeClock() {
+    return fakeNow;
+}
+
+struct Run {
+    char task;
+    unsigned long time;
+};
+
+static std::vector<Run> runs;
+
+static TaskScheduler::TaskCallback recorder(char task, unsigned long duration = 0) {
+    return [task, duration]() {
+        runs.push_back({task, fakeNow});
+        fakeNow += duration;
+    };
+}
+
+// Calls runDue() every millisecond up to and including end
+static void runUntil(TaskScheduler& scheduler, unsigned long end) {
+    while (true) {
+        scheduler.runDue();
+        if (fakeNow == end) break;
+        fakeNow++;
+    }
+}
+
+void setUp() {
+    fakeNow = 1000;
+    runs.clear();
+}
+
+void tearDown() {}
+
+void test_tasks_run_on_their_deadlines() {
+    TaskScheduler scheduler(fakeClock);
+    int slow = scheduler.addTask("slow", 100, recorder('s'));
+    int fast = scheduler.addTask("fast", 30, recorder('f'));
+    runUntil(scheduler, 1300);
+
+    TEST_ASSERT_EQUAL_UINT32(4, scheduler.getStats(slow).runs);   // 1000, 1100, 1200, 1300
+    TEST_ASSERT_EQUAL_UINT32(11, scheduler.getStats(fast).runs);  // 1000 to 1300 every 30
+    for (const Run& run : runs) {
+        unsigned long period = run.task == 's' ? 100 : 30;
+        TEST_ASSERT_EQUAL_UINT32(0, (run.time - 1000) % period);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(slow).maxJitter);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(fast).overruns);
+
+    // Next: fast at 1330, slow at 1400
+    TEST_ASSERT_EQUAL_UINT32(30, scheduler.timeUntilNextDeadline());
+}
+
+void test_due_tasks_run_earliest_deadline_first() {
+    TaskScheduler scheduler(fakeClock);
+    scheduler.addTask("a", 100, recorder('a'));
+    scheduler.addTask("b", 40, recorder('b'));
+    scheduler.addTask("c", 70, recorder('c'));
+    scheduler.runDue();
+    runs.clear();
+
+    // All three are late, b since 1040, c since 1070, a since 1100
+    fakeNow = 1150;
+    scheduler.runDue();
+    TEST_ASSERT_EQUAL_size_t(3, runs.size());
+    TEST_ASSERT_EQUAL_INT('b', runs[0].task);
+    TEST_ASSERT_EQUAL_INT('c', runs[1].task);
+    TEST_ASSERT_EQUAL_INT('a', runs[2].task);
+}
+
+void test_overrun_skips_missed_slots() {
+    TaskScheduler scheduler(fakeClock);
+    int id = scheduler.addTask("heavy", 100, recorder('h', 250));
+
+    // Runs 1000 to 1250, the slots at 1100 and 1200 are gone
+    scheduler.runDue();
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getStats(id).overruns);
+    TEST_ASSERT_EQUAL_UINT32(100, scheduler.timeUntilNextDeadline());
+    scheduler.runDue();
+    TEST_ASSERT_EQUAL_size_t(1, runs.size());
+
+    // The next run starts a period after the overrun ended, and counts once more
+    fakeNow = 1350;
+    scheduler.runDue();
+    TEST_ASSERT_EQUAL_size_t(2, runs.size());
+    TEST_ASSERT_EQUAL_UINT32(1350, runs[1].time);
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler.getStats(id).overruns);
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler.getStats(id).runs);
+}
+
+void test_late_run_stays_phase_locked() {
+    TaskScheduler scheduler(fakeClock);
+    int id = scheduler.addTask("sensor", 100, recorder('s', 5));
+    scheduler.runDue();
+
+    // 30 ms late but done before the next slot, which stays at 1200
+    fakeNow = 1130;
+    scheduler.runDue();
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(id).overruns);
+    TEST_ASSERT_EQUAL_UINT32(65, scheduler.timeUntilNextDeadline());
+}
+
+void test_jitter_and_duration_stats() {
+    TaskScheduler scheduler(fakeClock);
+    unsigned long duration = 3;
+    int id = scheduler.addTask("work", 100, [&duration]() { fakeNow += duration; });
+    scheduler.runDue();
+
+    fakeNow = 1112;
+    duration = 8;
+    scheduler.runDue();
+    fakeNow = 1204;
+    duration = 2;
+    scheduler.runDue();
+
+    const TaskScheduler::TaskStats& stats = scheduler.getStats(id);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.runs);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.lastJitter);
+    TEST_ASSERT_EQUAL_UINT32(12, stats.maxJitter);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.lastDuration);
+    TEST_ASSERT_EQUAL_UINT32(8, stats.maxDuration);
+
+    scheduler.resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(id).runs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(id).maxJitter);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(id).maxDuration);
+}
+
+void test_order_survives_clock_rollover() {
+    fakeNow = ULONG_MAX - 50;
+    TaskScheduler scheduler(fakeClock);
+    int fast = scheduler.addTask("fast", 30, recorder('f'));
+    int slow = scheduler.addTask("slow", 100, recorder('s'));
+    runUntil(scheduler, 149);  // 200 ms across the wrap, both ends included
+
+    TEST_ASSERT_EQUAL_UINT32(7, scheduler.getStats(fast).runs);
+    TEST_ASSERT_EQUAL_UINT32(3, scheduler.getStats(slow).runs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(fast).maxJitter);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(slow).overruns);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_tasks_run_on_their_deadlines);
+    RUN_TEST(test_due_tasks_run_earliest_deadline_first);
+    RUN_TEST(test_overrun_skips_missed_slots);
+    RUN_TEST(test_late_run_stays_phase_locked);
+    RUN_TEST(test_jitter_and_duration_stats);
+    RUN_TEST(test_order_survives_clock_rollover);
+    return UNITY_END();
+}
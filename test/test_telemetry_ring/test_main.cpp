@@ -0,0 +1,125 @@
+// TelemetryRing under a producer that never waits.
+//
+// One thread pushes 20M samples as fast as it can while readers follow
+// with their own cursors. Every sample carries its sequence number and a
+// check pattern derived from it, so a copy that overlapped an overwrite
+// shows up as torn. Readers must never return a torn sample, never go
+// backwards, and account for every sample they did not get as skipped.
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "telemetry_ring.h"
+
+static const uint32_t PUSHES = 20000000;
+static const size_t BATCH = 32;
+static const uint32_t PATTERN_WORDS = 30;  // Long copies widen the window for tearing
+
+struct Sample {
+    uint32_t sequence;
+    uint32_t pattern[PATTERN_WORDS];
+    uint32_t check;
+};
+
+// Small, so the producer laps the readers all the time
+typedef TelemetryRing<Sample, 8> Ring;
+
+static Sample sampleFor(uint32_t sequence) {
+    Sample sample;
+    sample.sequence = sequence;
+    for (uint32_t k = 0; k < PATTERN_WORDS; k++) sample.pattern[k] = sequence * 31u + k;
+    sample.check = sequence ^ 0xdeadbeefu;
+    return sample;
+}
+
+static bool isIntact(const Sample& sample) {
+    if (sample.check != (sample.sequence ^ 0xdeadbeefu)) return false;
+    for (uint32_t k = 0; k < PATTERN_WORDS; k++) {
+        if (sample.pattern[k] != sample.sequence * 31u + k) return false;
+    }
+    return true;
+}
+
+struct ReaderResult {
+    uint32_t received;
+    uint32_t skipped;
+    uint32_t torn;
+    uint32_t backwards;
+    uint32_t cursor;
+};
+
+// Readers with a step above 1 thin out the stream like a slow WebSocket client
+static void readRing(const Ring* ring, const std::atomic<bool>* done, uint32_t step, ReaderResult* result) {
+    Sample batch[BATCH];
+    uint32_t cursor = 0;
+    int64_t last = -1;
+    bool finished = false;
+    while (!finished) {
+        finished = done->load();
+        size_t count;
+        // Drain what is left once the producer stopped
+        while ((count = ring->read(cursor, batch, BATCH, step, &result->skipped)) > 0) {
+            for (size_t i = 0; i < count; i++) {
+                if (!isIntact(batch[i])) result->torn++;
+                if (static_cast<int64_t>(batch[i].sequence) <= last) result->backwards++;
+                last = batch[i].sequence;
+                result->received++;
+            }
+            if (!finished) break;
+        }
+    }
+    result->cursor = cursor;
+}
+
+static void runReaders(const std::vector<uint32_t>& steps, uint32_t pace) {
+    Ring ring;
+    std::atomic<bool> done(false);
+    std::vector<ReaderResult> results(steps.size(), ReaderResult());
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < steps.size(); r++) {
+        readers.emplace_back(readRing, &ring, &done, steps[r], &results[r]);
+    }
+
+    uint32_t pushes = pace ? PUSHES / 10 : PUSHES;
+    for (uint32_t i = 0; i < pushes; i++) {
+        ring.push(sampleFor(i));
+        for (volatile uint32_t wait = 0; wait < pace; wait++) {
+        }
+    }
+    done = true;
+    for (auto& reader : readers) reader.join();
+
+    for (size_t r = 0; r < steps.size(); r++) {
+        char message[112];
+        snprintf(message, sizeof(message), "step %u: received=%u skipped=%u torn=%u backwards=%u", steps[r],
+                 results[r].received, results[r].skipped, results[r].torn, results[r].backwards);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_GREATER_THAN_UINT32(0, results[r].received);
+        TEST_ASSERT_EQUAL_UINT32(0, results[r].torn);
+        TEST_ASSERT_EQUAL_UINT32(0, results[r].backwards);
+        TEST_ASSERT_EQUAL_UINT32(pushes, results[r].cursor);
+        if (steps[r] == 1) {
+            // Every sample was either received or counted as skipped
+            TEST_ASSERT_EQUAL_UINT32(pushes, results[r].received + results[r].skipped);
+        }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_unpaced_producer_never_tears() {
+    runReaders({1, 1, 4}, 0);
+}
+
+void test_paced_producer_never_tears() {
+    runReaders({1, 8}, 200);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_unpaced_producer_never_tears);
+    RUN_TEST(test_paced_producer_never_tears);
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+// ValveGovernor on hand-picked request sequences.
+//
+// Time is passed in explicitly, so every case runs on a simulated clock:
+// small moves must be held back, a held move must go out once the refresh
+// interval has passed, moves of at least minDelta and end stops must go out
+// at once, and the slew limit must spread a large step over several updates.
+
+#include <unity.h>
+#include "control/valve_governor.h"
+
+static const ValveGovernorConfig CONFIG = {1.0f, 0.0f, 2.0f, 60000};
+static const unsigned long PERIOD = 1000;  // Control period, ms
+
+static ValveGovernor governor;
+
+void setUp() {
+    governor.configure(CONFIG);
+    governor.reset();
+}
+
+void tearDown() {}
+
+static ValveAction feed(float requested, unsigned long now, float& position) {
+    position = -1.0f;
+    return governor.update(requested, now, position);
+}
+
+void test_first_request_is_sent() {
+    float position;
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::MOVE), static_cast<int>(feed(40.3f, 0, position)));
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, position);
+    TEST_ASSERT_EQUAL_UINT32(1, governor.getStats().moves);
+}
+
+void test_small_move_is_suppressed() {
+    float position;
+    feed(40.0f, 0, position);
+
+    // 1 % and 1.4 % (quantized to 1 %) stay below minDelta
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::NONE), static_cast<int>(feed(41.0f, PERIOD, position)));
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::NONE), static_cast<int>(feed(41.4f, 2 * PERIOD, position)));
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, position);
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::NONE), static_cast<int>(feed(39.0f, 3 * PERIOD, position)));
+
+    TEST_ASSERT_EQUAL_UINT32(1, governor.getStats().moves);
+    TEST_ASSERT_EQUAL_UINT32(3, governor.getStats().suppressed);
+    TEST_ASSERT_EQUAL_UINT32(0, governor.getStats().refreshes);
+}
+
+void test_move_past_deadband_is_sent() {
+    float position;
+    feed(40.0f, 0, position);
+
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::MOVE), static_cast<int>(feed(42.0f, PERIOD, position)));
+    TEST_ASSERT_EQUAL_FLOAT(42.0f, position);
+
+    // The deadband is measured from the last sent position, not the last request
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::NONE), static_cast<int>(feed(43.0f, 2 * PERIOD, position)));
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::MOVE), static_cast<int>(feed(44.0f, 3 * PERIOD, position)));
+    TEST_ASSERT_EQUAL_FLOAT(44.0f, position);
+    TEST_ASSERT_EQUAL_UINT32(3, governor.getStats().moves);
+}
+
+void test_end_stops_are_always_sent() {
+    float position;
+    feed(1.0f, 0, position);
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::MOVE), static_cast<int>(feed(0.2f, PERIOD, position)));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, position);
+
+    feed(99.0f, 2 * PERIOD, position);
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::MOVE), static_cast<int>(feed(100.0f, 3 * PERIOD, position)));
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, position);
+}
+
+void test_held_move_is_forced_after_refresh_interval() {
+    float position;
+    feed(40.0f, 0, position);
+
+    unsigned long now = PERIOD;
+    for (; now < CONFIG.refreshInterval; now += PERIOD) {
+        TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::NONE), static_cast<int>(feed(41.0f, now, position)));
+    }
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::MOVE), static_cast<int>(feed(41.0f, now, position)));
+    TEST_ASSERT_EQUAL_FLOAT(41.0f, position);
+    TEST_ASSERT_EQUAL_UINT32(2, governor.getStats().moves);
+    TEST_ASSERT_EQUAL_UINT32(0, governor.getStats().refreshes);
+
+    // The hold restarts from the forced move
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::NONE), static_cast<int>(feed(42.0f, now + PERIOD, position)));
+}
+
+void test_unchanged_position_is_refreshed() {
+    float position;
+    feed(40.0f, 0, position);
+
+    unsigned long now = PERIOD;
+    for (; now < CONFIG.refreshInterval; now += PERIOD) {
+        feed(40.0f, now, position);
+    }
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::REFRESH), static_cast<int>(feed(40.0f, now, position)));
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, position);
+    TEST_ASSERT_EQUAL_UINT32(1, governor.getStats().refreshes);
+    TEST_ASSERT_EQUAL_UINT32(1, governor.getStats().moves);
+}
+
+void test_slew_rate_limits_large_step() {
+    ValveGovernorConfig config = CONFIG;
+    config.maxSlewRate = 2.0f;  // % per second
+    governor.configure(config);
+
+    float position;
+    feed(20.0f, 0, position);
+
+    // 20 % -> 30 % at 2 %/s takes five one-second updates
+    for (int i = 1; i <= 5; i++) {
+        TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::MOVE), static_cast<int>(feed(30.0f, i * PERIOD, position)));
+        TEST_ASSERT_EQUAL_FLOAT(20.0f + 2.0f * i, position);
+    }
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::NONE), static_cast<int>(feed(30.0f, 6 * PERIOD, position)));
+}
+
+void test_slew_rate_always_makes_progress() {
+    ValveGovernorConfig config = CONFIG;
+    config.maxSlewRate = 0.1f;  // Less than one step per update
+    config.minDelta = 0.0f;
+    governor.configure(config);
+
+    float position;
+    feed(20.0f, 0, position);
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(ValveAction::MOVE), static_cast<int>(feed(30.0f, PERIOD, position)));
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, position);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_request_is_sent);
+    RUN_TEST(test_small_move_is_suppressed);
+    RUN_TEST(test_move_past_deadband_is_sent);
+    RUN_TEST(test_end_stops_are_always_sent);
+    RUN_TEST(test_held_move_is_forced_after_refresh_interval);
+    RUN_TEST(test_unchanged_position_is_refreshed);
+    RUN_TEST(test_slew_rate_limits_large_step);
+    RUN_TEST(test_slew_rate_always_makes_progress);
+    return UNITY_END();
+}
@@ -0,0 +1,193 @@
+// WebInterface handlers behind the in-process AsyncWebServer stand-in.
+//
+// Requests are built by the test and dispatched to the server the web
+// interface started on port 80, with LittleFS on a temporary directory.
+// Every route must ask for credentials and state changing ones for a CSRF
+// token; accepted changes must reach the state and the saved config.
+
+#include <unity.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "web_interface.h"
+#include "control/pid_controller.h"
+#include "native_hal.h"
+#include "protocol_manager.h"
+
+static char root[] = "/tmp/web_interface_XXXXXX";
+
+static std::string hostPath(const char* path) {
+    return std::string(root) + path;
+}
+
+struct Device {
+    ConfigManager config;
+    ThermostatState state;
+    PIDController pid;
+    ProtocolManager manager;
+    WebInterface web;
+
+    Device() : pid(&state), manager(&state), web(&config, nullptr, &pid, &state, &manager) {
+        TEST_ASSERT_TRUE(web.begin());
+    }
+
+    // Dispatches with the default credentials admin/admin
+    const AsyncWebServerResponse& request(AsyncWebServerRequest& request, bool login = true) {
+        if (login) request.setCredentials("admin", "admin");
+        TEST_ASSERT_TRUE(AsyncWebServer::dispatch(80, request));
+        TEST_ASSERT_NOT_NULL(request.response());
+        return *request.response();
+    }
+};
+
+void setUp() {
+    strcpy(root, "/tmp/web_interface_XXXXXX");
+    TEST_ASSERT_NOT_NULL(mkdtemp(root));
+    NativeHal::setFilesystemRoot(root);
+}
+
+void tearDown() {
+    remove(hostPath("/config.json").c_str());
+    remove(hostPath("/style.css").c_str());
+    rmdir(root);
+    NativeHal::setFilesystemRoot("");
+}
+
+void test_requests_without_credentials_are_refused() {
+    Device device;
+    AsyncWebServerRequest status(HTTP_GET, "/status");
+    const AsyncWebServerResponse& response = device.request(status, false);
+    TEST_ASSERT_EQUAL_INT(401, response.code());
+    TEST_ASSERT_TRUE(response.header("WWW-Authenticate").startsWith("Basic"));
+
+    AsyncWebServerRequest wrong(HTTP_GET, "/status");
+    wrong.setCredentials("admin", "guess");
+    TEST_ASSERT_EQUAL_INT(401, device.request(wrong, false).code());
+}
+
+void test_status_reports_the_state() {
+    Device device;
+    device.state.setTargetTemperature(21.5f);
+
+    AsyncWebServerRequest status(HTTP_GET, "/status");
+    const AsyncWebServerResponse& response = device.request(status);
+    TEST_ASSERT_EQUAL_INT(200, response.code());
+    TEST_ASSERT_EQUAL_STRING("application/json", response.contentType().c_str());
+    TEST_ASSERT_EQUAL_STRING("nosniff", response.header("X-Content-Type-Options").c_str());
+
+    StaticJsonDocument<512> doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, response.content()));
+    TEST_ASSERT_EQUAL_FLOAT(21.5f, doc["setpoint"].as<float>());
+
+    // Nothing changed since the version just reported
+    AsyncWebServerRequest again(HTTP_GET, "/status");
+    again.addParam("since", String(doc["version"].as<unsigned long>()));
+    StaticJsonDocument<512> delta;
+    TEST_ASSERT_FALSE(deserializeJson(delta, device.request(again).content()));
+    TEST_ASSERT_FALSE(delta.containsKey("setpoint"));
+}
+
+void test_setpoint_needs_a_csrf_token() {
+    Device device;
+    device.state.setTargetTemperature(20.0f);
+
+    AsyncWebServerRequest forged(HTTP_POST, "/setpoint");
+    forged.addParam("setpoint", "25.0", true);
+    TEST_ASSERT_EQUAL_INT(403, device.request(forged).code());
+
+    AsyncWebServerRequest setpoint(HTTP_POST, "/setpoint");
+    setpoint.addParam("setpoint", "22.5", true);
+    setpoint.addParam("_csrf", "token", true);
+    TEST_ASSERT_EQUAL_INT(200, device.request(setpoint).code());
+
+    // Applied by the control task, and saved
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, device.state.getTargetTemperature());
+    device.manager.processCommands();
+    TEST_ASSERT_EQUAL_FLOAT(22.5f, device.state.getTargetTemperature());
+    TEST_ASSERT_EQUAL_INT(0, access(hostPath("/config.json").c_str(), F_OK));
+}
+
+void test_pid_gains_are_updated() {
+    Device device;
+    AsyncWebServerRequest pid(HTTP_POST, "/pid");
+    pid.addHeader("X-CSRF-Token", "token");
+    pid.addParam("plain", "{\"kp\": 4.0, \"ki\": 0.2}", true);
+    TEST_ASSERT_EQUAL_INT(200, device.request(pid).code());
+    TEST_ASSERT_EQUAL_FLOAT(4.0f, device.pid.getKp());
+    TEST_ASSERT_EQUAL_FLOAT(0.2f, device.pid.getKi());
+    TEST_ASSERT_EQUAL_FLOAT(4.0f, device.config.getKp());
+
+    AsyncWebServerRequest broken(HTTP_POST, "/pid");
+    broken.addHeader("X-CSRF-Token", "token");
+    broken.addParam("plain", "{\"kp\": ", true);
+    TEST_ASSERT_EQUAL_INT(400, device.request(broken).code());
+}
+
+void test_saved_settings_survive_a_restart() {
+    {
+        Device device;
+        AsyncWebServerRequest save(HTTP_POST, "/save");
+        save.addParam("_csrf", "token", true);
+        save.addParam("plain", "{\"device\": {\"name\": \"Hall\", \"sendInterval\": 20000}}", true);
+        TEST_ASSERT_EQUAL_INT(200, device.request(save).code());
+    }
+
+    ConfigManager config;
+    TEST_ASSERT_TRUE(config.begin());
+    TEST_ASSERT_EQUAL_STRING("Hall", config.getDeviceName());
+    TEST_ASSERT_EQUAL_UINT32(20000, config.getSendInterval());
+}
+
+void test_files_are_served_from_littlefs() {
+    FILE* file = fopen(hostPath("/style.css").c_str(), "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs("body { margin: 0; }", file);
+    fclose(file);
+
+    Device device;
+    AsyncWebServerRequest style(HTTP_GET, "/style.css");
+    const AsyncWebServerResponse& response = device.request(style);
+    TEST_ASSERT_EQUAL_INT(200, response.code());
+    TEST_ASSERT_EQUAL_STRING("body { margin: 0; }", response.content().c_str());
+    TEST_ASSERT_EQUAL_STRING("max-age=86400", response.header("Cache-Control").c_str());
+
+    AsyncWebServerRequest missing(HTTP_GET, "/missing.js");
+    TEST_ASSERT_EQUAL_INT(404, device.request(missing).code());
+}
+
+void test_root_page_carries_its_csrf_token() {
+    Device device;
+    AsyncWebServerRequest page(HTTP_GET, "/");
+    const AsyncWebServerResponse& response = device.request(page);
+    TEST_ASSERT_EQUAL_INT(200, response.code());
+    TEST_ASSERT_NOT_NULL(page._tempObject);
+    TEST_ASSERT_TRUE(response.content().indexOf(static_cast<const char*>(page._tempObject)) >= 0);
+}
+
+void test_reboot_restarts_after_answering() {
+    Device device;
+    float scale = NativeHal::getTimeScale();
+    uint32_t restarts = NativeHal::getRestartCount();
+
+    // The handler waits 5 s before the restart
+    NativeHal::setTimeScale(1000.0f);
+    AsyncWebServerRequest reboot(HTTP_POST, "/reboot");
+    TEST_ASSERT_EQUAL_INT(200, device.request(reboot).code());
+    NativeHal::setTimeScale(scale);
+
+    TEST_ASSERT_EQUAL_UINT32(restarts + 1, NativeHal::getRestartCount());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_requests_without_credentials_are_refused);
+    RUN_TEST(test_status_reports_the_state);
+    RUN_TEST(test_setpoint_needs_a_csrf_token);
+    RUN_TEST(test_pid_gains_are_updated);
+    RUN_TEST(test_saved_settings_survive_a_restart);
+    RUN_TEST(test_files_are_served_from_littlefs);
+    RUN_TEST(test_root_page_carries_its_csrf_token);
+    RUN_TEST(test_reboot_restarts_after_answering);
+    return UNITY_END();
+}